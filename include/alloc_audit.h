@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include "common.h"
+
+// Per-thread heap allocation auditing, built with `make ALLOC_AUDIT=1`. The
+// malloc family (and so operator new, which goes through malloc) is
+// interposed; once a hot thread's warmup is over, every allocation it makes is
+// counted and its backtrace written to stderr, or the process aborts when
+// USPF_ALLOC_AUDIT=abort. Warmup is USPF_ALLOC_WARMUP_MS after begin()
+// (default 2000), enough for lazy first-use setup such as iostream buffers.
+// Without ALLOC_AUDIT the gate compiles to nothing.
+#ifdef USPF_ALLOC_AUDIT
+
+class AllocAuditGate {
+   public:
+    // Register the calling thread under `name` and start its warmup
+    void begin(const char* name);
+
+    // Once per loop iteration: arms the thread when warmup is over
+    inline void tick() {
+        if (__builtin_expect(!armed_ && rdtsc() >= arm_at_, 0)) arm();
+    }
+
+    // Stop auditing the calling thread (shutdown may allocate)
+    void end();
+
+   private:
+    void arm();
+
+    bool armed_{true};  // until begin()
+    uint64_t arm_at_{0};
+};
+
+#else
+
+class AllocAuditGate {
+   public:
+    void begin(const char*) {}
+    inline void tick() {}
+    void end() {}
+};
+
+#endif
+
+// Print allocations made by each audited thread after its warmup; returns
+// their total (always 0 without ALLOC_AUDIT)
+uint64_t alloc_audit_report();
@@ -0,0 +1,16 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "bypass_io.h"
+
+class PacketCapture;
+
+// Minimal RX soak against a live port: prints pps/bps every second for
+// `seconds` seconds. Works with any backend (netmap:, udp:, uring:, xdp:).
+int run_rx_benchmark(BypassConfig cfg, int seconds);
+
+// Background thread printing delta pps/gbps every second (caller joins).
+std::thread start_stats_reporter(PacketCapture& cap,
+                                 std::atomic<bool>& global_running,
+                                 std::chrono::steady_clock::time_point end_time);
@@ -2,6 +2,22 @@
 #include <functional>
 #include <string>
 #include "common.h"
+#include "rx_prefetch.h"
+#include "rx_telemetry.h"
+
+// Which I/O path backs a BypassIO, chosen from the ifname prefix:
+//   netmap:eth0, vale0:1, ...   -> Netmap (kernel bypass, full Ethernet frames)
+//   udp:[addr:]port             -> Socket (kernel UDP stack + recvmmsg, payload only)
+//   uring:[addr:]port           -> IoUring (multishot recvmsg, payload only)
+//   xdp:eth0[@queue]            -> Xdp (AF_XDP socket, full Ethernet frames)
+enum class IoBackend : uint8_t { Netmap, Socket, IoUring, Xdp };
+
+IoBackend backend_of(const std::string& ifname);
+const char* backend_name(IoBackend b);
+
+// Kernel device behind a netmap:/xdp: spec ("netmap:eth0-1" -> "eth0"); empty
+// for vale ports and socket specs
+std::string device_of(const std::string& ifname);
 
 struct BypassConfig {
     std::string ifname = "netmap:eth0";
@@ -9,9 +25,29 @@ struct BypassConfig {
     int rx_ring_last = -1;
     int tx_ring_first = -1;
     int tx_ring_last = -1;
-    int burst = BATCH_SIZE;
+    int burst = BATCH_SIZE;  // per ring (netmap) or recvmmsg vector length (socket)
     bool busy_poll = true;
     int cpu_affinity = -1;  // -1 = don't pin
+
+    // Netmap and AF_XDP: packets of descriptor/frame prefetch lookahead in the
+    // RX loop (0 = off)
+    int prefetch = kRxPrefetchDistance;
+
+    // Socket and io_uring backends
+    int sock_rcvbuf = 0;  // SO_RCVBUF bytes (0 = kernel default)
+    int sock_busy_poll_us = 50;  // SO_BUSY_POLL budget in usecs (0 = off)
+    bool sock_prefer_busy_poll = true;  // SO_PREFER_BUSY_POLL
+    bool sock_timestamps = true;  // SO_TIMESTAMPNS kernel RX timestamps
+
+    // io_uring backend only
+    bool uring_sqpoll = false;  // kernel SQ polling thread (no submit syscalls)
+    int uring_sq_cpu = -1;  // pin the SQPOLL thread (-1 = unpinned)
+    int uring_buffers = 4096;  // provided buffers, rounded up to a power of two
+
+    // AF_XDP backend only
+    bool xdp_zerocopy = true;  // bind with XDP_ZEROCOPY when the driver allows it
+    bool xdp_generic = false;  // force generic (SKB) XDP, e.g. on a veth pair
+    int xdp_frames = 4096;  // UMEM frames (half for RX fill, half for TX)
 };
 
 class BypassIO {
@@ -23,19 +59,34 @@ class BypassIO {
     // Returns received count (not necessarily accepted).
     int rx_batch(const std::function<bool(const PacketView&)>& cb);
 
-    // Transmit a buffer (optional for your filter pipeline).
+    // Transmit a buffer (optional for your filter pipeline). Supported on the
+    // frame-level backends (netmap, AF_XDP); returns len, or -1 if it could not
+    // be queued.
     int tx(const uint8_t* data, uint16_t len);
 
     // Stats across life of this object
     const Stats& stats() const { return stats_; }
 
+    // Per-ring occupancy / batch-size histograms and empty polls
+    const RxTelemetry& telemetry() const { return telemetry_; }
+
     // Valid after construction
     bool ok() const { return ok_; }
 
+    IoBackend backend() const { return backend_; }
+
+    // Frames already received but not yet consumed (netmap RX ring space,
+    // io_uring CQEs, AF_XDP RX descriptors); -1 if the backend cannot tell
+    int rx_backlog() const;
+
    private:
+    int rx_batch_netmap(const std::function<bool(const PacketView&)>& cb);
+
     BypassConfig cfg_;
     Stats stats_{};
+    RxTelemetry telemetry_{};
     bool ok_{false};
+    IoBackend backend_{IoBackend::Netmap};
 
     // netmap internals are hidden to keep user code clean
     struct Impl;
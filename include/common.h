@@ -40,6 +40,17 @@ struct PacketView {
     const uint8_t* data{nullptr};
     uint16_t len{0};
     uint64_t tsc{0};
+
+    // Kernel RX timestamp in CLOCK_REALTIME ns (0 = not available)
+    uint64_t rx_ns{0};
+
+    // data points at the UDP payload instead of an Ethernet frame (socket
+    // backends: the kernel already stripped L2-L4 and matched the port)
+    bool payload_only{false};
+
+    // UDP destination port of a payload-only view (the bound socket port);
+    // frame views carry it in their headers
+    uint16_t dport{0};
 };
 
 void pin_thread_to_core(int core);
@@ -53,3 +64,7 @@ inline uint64_t rdtsc() {
     return 0;
 #endif
 }
+
+// Nanoseconds per rdtsc() tick, calibrated once against steady_clock (~10 ms
+// on first call). 0 if the platform has no usable TSC.
+double tsc_ns_per_tick();
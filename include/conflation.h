@@ -0,0 +1,123 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "common.h"
+
+// Conflation counters (capture thread writes, reporter reads, like Stats)
+struct ConflationStats {
+    uint64_t episodes{0};     // times the ring backed up and conflation began
+    uint64_t absorbed{0};     // ticks taken into the slot table
+    uint64_t overwritten{0};  // pending ticks replaced by a newer one for the same key
+    uint64_t flushed{0};      // ticks moved from the table into the ring
+    uint64_t dropped{0};      // table full: distinct keys exceeded the slots
+};
+
+/**
+ * Producer-side conflation for when the tick ring backs up. Instead of losing
+ * the ticks that do not fit, the capture thread puts them into a slot table
+ * keyed by (instr_id, side), where a newer tick replaces the pending one. A
+ * dirty list remembers the order keys first became pending, and flush() moves
+ * them into the ring as the consumer frees space, so it always drains the
+ * latest state of each instrument rather than a backlog of stale quotes.
+ *
+ * While anything is pending, every new tick goes through the table too, so the
+ * ring never holds a tick newer than one still waiting here. When the table
+ * drains, a generation bump empties it in O(1) and direct pushes resume.
+ */
+class TickConflator {
+   public:
+    // `slots` is rounded up to a power of two
+    explicit TickConflator(size_t slots);
+
+    bool active() const { return pending_ != 0; }
+    size_t pending() const { return pending_; }
+
+    // Take a tick the ring could not (or, while active, must not) accept
+    inline void put(const Tick& t) {
+        if (pending_ == 0) ++stats_.episodes;
+
+        const uint32_t key = (t.instr_id << 1) | (t.side & 1);
+        uint32_t i = (key * 0x9E3779B9u) >> shift_;  // Fibonacci hash: top bits
+        for (uint32_t probe = 0; probe < kMaxProbe; ++probe, i = (i + 1) & mask_) {
+            Slot& s = slots_[i];
+            if (s.gen != gen_) {  // free in this generation: claim it
+                s.gen = gen_;
+                s.key = key;
+                mark_dirty(s, i, t);
+                return;
+            }
+            if (s.key != key) continue;
+            if (s.dirty) {
+                s.tick = t;
+                ++stats_.absorbed;
+                ++stats_.overwritten;
+            } else {
+                mark_dirty(s, i, t);  // flushed earlier in this episode
+            }
+            return;
+        }
+        ++stats_.dropped;
+    }
+
+    // Move pending ticks into the ring, oldest-dirtied first, without ever
+    // overfilling it (only the producer calls this, so size() is exact enough:
+    // the consumer can only free more). Returns the number moved.
+    template <typename Ring>
+    size_t flush(Ring& ring) {
+        size_t room = ring.capacity() - ring.size();
+        size_t moved = 0;
+        Tick batch[64];
+        while (pending_ && room) {
+            size_t n = 0;
+            while (n < 64 && n < room && pending_) {
+                Slot& s = slots_[fifo_[head_]];
+                head_ = (head_ + 1) & mask_;
+                --pending_;
+                s.dirty = false;
+                batch[n++] = s.tick;
+            }
+            ring.push_bulk(batch, n);
+            room -= n;
+            moved += n;
+        }
+        stats_.flushed += moved;
+        if (pending_ == 0) ++gen_;  // empty the table for the next episode
+        return moved;
+    }
+
+    const ConflationStats& stats() const { return stats_; }
+
+   private:
+    static constexpr uint32_t kMaxProbe = 32;
+
+    struct Slot {
+        Tick tick;
+        uint32_t key;
+        uint32_t gen;  // slot is in use only if gen == gen_
+        bool dirty;    // queued in fifo_
+    };
+
+    inline void mark_dirty(Slot& s, uint32_t idx, const Tick& t) {
+        s.tick = t;
+        s.dirty = true;
+        ++stats_.absorbed;
+        fifo_[tail_] = idx;
+        tail_ = (tail_ + 1) & mask_;
+        ++pending_;
+    }
+
+    uint32_t mask_;
+    uint32_t shift_;  // 32 - log2(slots)
+    uint32_t gen_{1};
+    std::vector<Slot> slots_;
+    std::vector<uint32_t> fifo_;  // dirty list: slot indices, each at most once
+    uint32_t head_{0}, tail_{0};
+    size_t pending_{0};
+    ConflationStats stats_;
+};
+
+// Print one interval (now - prev) of conflation counters; final=true prints
+// the whole run
+void print_conflation(const ConflationStats& now, const ConflationStats& prev,
+    size_t pending, bool final);
@@ -0,0 +1,428 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "common.h"
+#include "tick_decode.h"
+
+// Wire field loads; memcpy keeps them alignment-safe. The host is assumed
+// little-endian, as in decode_tick_from_payload().
+template <typename T>
+inline T load_le(const uint8_t* p) {
+    T v;
+    std::memcpy(&v, p, sizeof(T));
+    return v;
+}
+
+template <typename T>
+inline T load_be(const uint8_t* p) {
+    static_assert(sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8, "field width");
+    if constexpr (sizeof(T) == 2) {
+        uint16_t u = __builtin_bswap16(load_le<uint16_t>(p));
+        T v;
+        std::memcpy(&v, &u, 2);
+        return v;
+    } else if constexpr (sizeof(T) == 4) {
+        uint32_t u = __builtin_bswap32(load_le<uint32_t>(p));
+        T v;
+        std::memcpy(&v, &u, 4);
+        return v;
+    } else {
+        uint64_t u = __builtin_bswap64(load_le<uint64_t>(p));
+        T v;
+        std::memcpy(&v, &u, 8);
+        return v;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Compile-time layouts: fixed-size records decoded by straight-line code.
+// Each provides kSize, kName and decode(record, tsc, Tick&), which returns
+// false for an out-of-range field. A datagram may carry several records
+// back to back.
+// ---------------------------------------------------------------------------
+
+// The original feed: u32 instr, u8 type, u8 side, f32 px, f32 qty (LE)
+struct Md14Layout {
+    static constexpr uint16_t kSize = 14;
+    static constexpr const char* kName = "md14";
+
+    static inline bool decode(const uint8_t* rec, uint64_t tsc, Tick& out) {
+        decode_tick_from_payload(rec, tsc, out);
+        return out.side <= 1;
+    }
+};
+
+// Network-order fixed-point feed: u32 instr, u8 type, u8 side,
+// i64 px in 1e-8 units, u32 qty (all big-endian)
+struct Px8BeLayout {
+    static constexpr uint16_t kSize = 18;
+    static constexpr const char* kName = "px8be";
+
+    static inline bool decode(const uint8_t* rec, uint64_t tsc, Tick& out) {
+        out.ts_ns = tsc;
+        out.instr_id = load_be<uint32_t>(rec);
+        out.instr_type = rec[4];
+        out.side = rec[5];
+        out.px = (float)((double)load_be<int64_t>(rec + 6) * 1e-8);
+        out.qty = (float)load_be<uint32_t>(rec + 14);
+        return out.side <= 1 && out.px > 0.f;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Table-driven schemas for simple field-list protocols
+// ---------------------------------------------------------------------------
+
+enum class TickField : uint8_t { InstrId, InstrType, Side, Px, Qty };
+enum class FieldType : uint8_t { U8, U16, U32, U64, I32, I64, F32, F64 };
+
+struct FieldSpec {
+    TickField target;
+    FieldType type;
+    bool big_endian;
+    uint16_t offset;  // within the record
+    double scale;     // applied to px/qty
+};
+
+// `header` bytes are skipped, then the rest must be a whole number of
+// `record`-byte records
+struct TableSchema {
+    uint16_t header{0};
+    uint16_t record{0};
+    std::vector<FieldSpec> fields;
+};
+
+/**
+ * Parse a schema such as
+ *   "rec=18,instr=u32be@0,type=u8@4,side=u8@5,px=i64be@6/1e8,qty=u32be@14"
+ * Fields are <target>=<type>[be]@<offset>[/div|*mul]; targets are instr,
+ * type, side, px, qty; "hdr=N" skips a per-datagram header. Every field
+ * must fit inside the record. There is no timestamp target: Tick::ts_ns is
+ * the RX TSC, which the latency reporting downstream relies on.
+ */
+bool parse_table_schema(const std::string& spec, TableSchema& out, std::string& err);
+
+inline void apply_field(const FieldSpec& f, const uint8_t* rec, Tick& t) {
+    const uint8_t* q = rec + f.offset;
+    const bool be = f.big_endian;
+    uint64_t u = 0;
+    double d = 0;
+    switch (f.type) {
+        case FieldType::U8:
+            u = q[0];
+            d = (double)u;
+            break;
+        case FieldType::U16:
+            u = be ? load_be<uint16_t>(q) : load_le<uint16_t>(q);
+            d = (double)u;
+            break;
+        case FieldType::U32:
+            u = be ? load_be<uint32_t>(q) : load_le<uint32_t>(q);
+            d = (double)u;
+            break;
+        case FieldType::U64:
+            u = be ? load_be<uint64_t>(q) : load_le<uint64_t>(q);
+            d = (double)u;
+            break;
+        case FieldType::I32: {
+            const int32_t s = be ? load_be<int32_t>(q) : load_le<int32_t>(q);
+            u = (uint64_t)(int64_t)s;
+            d = (double)s;
+            break;
+        }
+        case FieldType::I64: {
+            const int64_t s = be ? load_be<int64_t>(q) : load_le<int64_t>(q);
+            u = (uint64_t)s;
+            d = (double)s;
+            break;
+        }
+        case FieldType::F32:
+            d = be ? load_be<float>(q) : load_le<float>(q);
+            u = (uint64_t)d;
+            break;
+        case FieldType::F64:
+            d = be ? load_be<double>(q) : load_le<double>(q);
+            u = (uint64_t)d;
+            break;
+    }
+    switch (f.target) {
+        case TickField::InstrId:
+            t.instr_id = (uint32_t)u;
+            break;
+        case TickField::InstrType:
+            t.instr_type = (uint8_t)u;
+            break;
+        case TickField::Side:
+            t.side = (uint8_t)u;
+            break;
+        case TickField::Px:
+            t.px = (float)(d * f.scale);
+            break;
+        case TickField::Qty:
+            t.qty = (float)(d * f.scale);
+            break;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Registry
+// ---------------------------------------------------------------------------
+
+enum class DecoderKind : uint8_t { Md14, Md14Packed, Px8Be, Table };
+
+// Per-decoder counters (capture thread writes, reporter reads, like Stats)
+struct DecoderStats {
+    uint64_t datagrams{0};
+    uint64_t ticks{0};
+    uint64_t bad_length{0};  // payload not header + whole records
+    uint64_t bad_value{0};   // record rejected by a field range check
+};
+
+/**
+ * Maps UDP destination ports to decoders and turns each datagram into zero or
+ * more Ticks. Dispatch is a switch on DecoderKind into templated, inlinable
+ * decode loops, so the per-packet path has no virtual or std::function calls.
+ * The emit callback is a template parameter for the same reason; it is called
+ * as emit(const Tick*, size_t) once per datagram (per kBatch records for very
+ * large ones) so the consumer can push the whole batch with one ring publish.
+ *
+ * Configure it fully before handing it to PacketCapture; it is not safe to
+ * change routes while the capture thread runs.
+ */
+class DecoderRegistry {
+   public:
+    // Starts with "md14" as the default decoder for every port
+    DecoderRegistry();
+
+    static constexpr size_t kBatch = 64;
+
+    // Add a decoder from a spec ("md14", "md14x", "px8be", "table:<schema>");
+    // returns its id, or -1 with err set
+    int add(const std::string& spec, std::string& err);
+
+    // Route a UDP port (0 = default for ports without their own route)
+    void route(uint16_t port, int id);
+
+    // Parse and apply a "port=spec" rule (the -d command-line option)
+    bool configure(const std::string& rule, std::string& err);
+
+    // Once the frame filter takes every port: route `port` (the -p port) to
+    // the current default, then drop datagrams to ports without a route of
+    // their own, counted as unrouted
+    void restrict_to_routes(uint16_t port);
+
+    // Any route() since construction
+    bool routed() const { return routed_; }
+
+    // Every route, the default included, decodes with `kind`
+    bool all_routes(DecoderKind kind) const;
+
+    // Payload length the frame filter may insist on: 14 while every route is
+    // plain md14 (one record per datagram), else 0 and the decoders check
+    // lengths themselves
+    uint16_t fixed_payload_len() const {
+        return all_routes(DecoderKind::Md14) ? kRecordSize : 0;
+    }
+
+    template <typename Emit>
+    inline size_t decode(const PacketView& v, Emit&& emit) {
+        const uint8_t* payload = nullptr;
+        uint16_t paylen = 0, dport = 0;
+        if (!view_payload(v, payload, paylen, dport)) {
+            ++malformed_;
+            return 0;
+        }
+        return decode_payload(dport, payload, paylen, v.tsc, emit);
+    }
+
+    template <typename Emit>
+    inline size_t decode_payload(uint16_t port, const uint8_t* p, uint16_t len,
+        uint64_t tsc, Emit&& emit) {
+        const int id = lookup(port);
+        if (id < 0) {
+            ++unrouted_;
+            return 0;
+        }
+        Entry& e = entries_[id];
+        ++e.stats.datagrams;
+        size_t n = 0;
+        switch (e.kind) {
+            case DecoderKind::Md14:
+                n = run_md14(e.stats, p, len, tsc, emit);
+                break;
+            case DecoderKind::Md14Packed:
+                n = run_md14_packed(e.stats, p, len, tsc, emit);
+                break;
+            case DecoderKind::Px8Be:
+                n = run_fixed<Px8BeLayout>(e.stats, p, len, tsc, emit);
+                break;
+            case DecoderKind::Table:
+                n = run_table(e.stats, tables_[e.table], p, len, tsc, emit);
+                break;
+        }
+        e.stats.ticks += n;
+        return n;
+    }
+
+    // Reporter side
+    size_t size() const { return entries_.size(); }
+    const std::string& name(size_t id) const { return entries_[id].name; }
+    const DecoderStats& stats(size_t id) const { return entries_[id].stats; }
+    uint64_t unrouted() const { return unrouted_; }
+    uint64_t malformed() const { return malformed_; }
+    void print_stats() const;
+
+   private:
+    struct Entry {
+        DecoderKind kind;
+        uint16_t table;  // index into tables_ for DecoderKind::Table
+        std::string name;
+        DecoderStats stats;
+    };
+
+    struct Route {
+        uint16_t port;
+        int id;
+    };
+
+    inline int lookup(uint16_t port) const {
+        for (const Route& r : routes_)
+            if (r.port == port) return r.id;
+        return default_id_;
+    }
+
+    // Decode `count` records of `stride` bytes with one(record, Tick&) and
+    // emit them. Single-record datagrams, still the common case, skip the
+    // batch buffer; larger ones go out of line.
+    template <typename One, typename Emit>
+    static inline size_t run_records(DecoderStats& st, const uint8_t* p, size_t count,
+        size_t stride, One& one, Emit& emit) {
+        if (count == 1) {
+            Tick t;
+            if (!one(p, t)) {
+                ++st.bad_value;
+                return 0;
+            }
+            emit((const Tick*)&t, 1);
+            return 1;
+        }
+        return run_batched(st, p, count, stride, one, emit);
+    }
+
+    template <typename One, typename Emit>
+    __attribute__((noinline)) static size_t run_batched(DecoderStats& st,
+        const uint8_t* p, size_t count, size_t stride, One& one, Emit& emit) {
+        Tick batch[kBatch];
+        size_t n = 0, k = 0;
+        for (size_t i = 0; i < count; ++i, p += stride) {
+            if (!one(p, batch[k])) {
+                ++st.bad_value;
+                continue;
+            }
+            if (++k == kBatch) {
+                emit((const Tick*)batch, k);
+                n += k;
+                k = 0;
+            }
+        }
+        if (k) emit((const Tick*)batch, k);
+        return n + k;
+    }
+
+    template <typename Layout, typename Emit>
+    static inline size_t run_fixed(DecoderStats& st, const uint8_t* p, uint16_t len,
+        uint64_t tsc, Emit& emit) {
+        if (len == 0 || len % Layout::kSize != 0) {
+            ++st.bad_length;
+            return 0;
+        }
+        auto one = [tsc](const uint8_t* rec, Tick& t) {
+            return Layout::decode(rec, tsc, t);
+        };
+        return run_records(st, p, len / Layout::kSize, Layout::kSize, one, emit);
+    }
+
+    // md14 records: multi-record datagrams go through the SIMD kernel
+    template <typename Emit>
+    static inline size_t run_md14_records(DecoderStats& st, const uint8_t* p,
+        size_t count, uint64_t tsc, Emit& emit) {
+        if (count == 1) {
+            auto one = [tsc](const uint8_t* rec, Tick& t) {
+                return Md14Layout::decode(rec, tsc, t);
+            };
+            return run_records(st, p, 1, kRecordSize, one, emit);
+        }
+        return run_simd(st, p, count, tsc, emit);
+    }
+
+    template <typename Emit>
+    __attribute__((noinline)) static size_t run_simd(DecoderStats& st, const uint8_t* p,
+        size_t count, uint64_t tsc, Emit& emit) {
+        Tick batch[kBatch];
+        size_t n = 0;
+        while (count) {
+            const size_t take = count < kBatch ? count : kBatch;
+            const size_t k = decode_records(p, take, tsc, batch);
+            st.bad_value += take - k;
+            if (k) emit((const Tick*)batch, k);
+            n += k;
+            p += take * kRecordSize;
+            count -= take;
+        }
+        return n;
+    }
+
+    template <typename Emit>
+    static inline size_t run_md14(DecoderStats& st, const uint8_t* p, uint16_t len,
+        uint64_t tsc, Emit& emit) {
+        if (len == 0 || len % kRecordSize != 0) {
+            ++st.bad_length;
+            return 0;
+        }
+        return run_md14_records(st, p, len / kRecordSize, tsc, emit);
+    }
+
+    // PackedHeader + count records; the header's count must match the length
+    template <typename Emit>
+    static inline size_t run_md14_packed(DecoderStats& st, const uint8_t* p, uint16_t len,
+        uint64_t tsc, Emit& emit) {
+        PackedHeader h;
+        if (len < sizeof(h)) {
+            ++st.bad_length;
+            return 0;
+        }
+        std::memcpy(&h, p, sizeof(h));
+        if (h.count == 0 || len != sizeof(h) + (size_t)h.count * kRecordSize) {
+            ++st.bad_length;
+            return 0;
+        }
+        return run_md14_records(st, p + sizeof(h), h.count, tsc, emit);
+    }
+
+    template <typename Emit>
+    static inline size_t run_table(DecoderStats& st, const TableSchema& s,
+        const uint8_t* p, uint16_t len, uint64_t tsc, Emit& emit) {
+        if (len <= s.header || (len - s.header) % s.record != 0) {
+            ++st.bad_length;
+            return 0;
+        }
+        auto one = [&s, tsc](const uint8_t* rec, Tick& t) {
+            t = Tick{};
+            t.ts_ns = tsc;
+            for (const FieldSpec& f : s.fields) apply_field(f, rec, t);
+            return t.side <= 1;
+        };
+        return run_records(st, p + s.header, (len - s.header) / s.record, s.record, one,
+            emit);
+    }
+
+    std::vector<Entry> entries_;
+    std::vector<TableSchema> tables_;
+    std::vector<Route> routes_;
+    int default_id_{-1};
+    bool routed_{false};  // route() was called
+    uint64_t unrouted_{0};
+    uint64_t malformed_{0};
+};
@@ -0,0 +1,116 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include "histogram.h"
+#include "tick_decode.h"
+
+// Redundant line a datagram arrived on
+enum class FeedLine : uint8_t { A = 0, B = 1 };
+
+// Arbitration counters (capture thread writes, reporter reads, like Stats)
+struct ArbiterStats {
+    uint64_t forwarded[2]{};   // first arrivals passed downstream, by line
+    uint64_t duplicates{0};    // later copies dropped
+    uint64_t gaps{0};          // forward jumps in a channel's sequence
+    uint64_t missing{0};       // skipped sequence numbers not yet seen on either line
+    uint64_t recovered{0};     // skipped numbers that turned up late
+    uint64_t stale{0};         // older than the dedup window; dropped
+    uint64_t unsequenced{0};   // no PackedHeader, or channel out of range; dropped
+    Log2Histogram a_lead;      // TSC ticks the A copy beat its B copy by
+    Log2Histogram b_lead;      // TSC ticks the B copy beat its A copy by
+};
+
+/**
+ * First-arrival-wins arbitration of two redundant feed lines carrying packed
+ * datagrams (PackedHeader: seq, channel, count). Each channel tracks the next
+ * expected sequence number and a window of recent arrivals, so the second copy
+ * of a datagram is dropped and the time between the two copies is recorded.
+ *
+ * Both lines must be polled by the same thread (PacketCapture does this), so
+ * there is no locking; the A-vs-B delta uses the poll-time TSC and includes up
+ * to one loop iteration of polling-order bias.
+ */
+class FeedArbiter {
+   public:
+    static constexpr uint16_t kChannels = 64;
+    static constexpr uint32_t kWindow = 256;  // power of two
+
+    FeedArbiter() : ch_(new Channel[kChannels]()) {}
+
+    // Returns true if this datagram should be decoded and forwarded
+    inline bool on_datagram(FeedLine line, const uint8_t* payload, uint16_t len,
+        uint64_t tsc) {
+        PackedHeader h;
+        if (len < sizeof(h)) {
+            ++stats_.unsequenced;
+            return false;
+        }
+        std::memcpy(&h, payload, sizeof(h));
+        if (h.channel >= kChannels) {
+            ++stats_.unsequenced;
+            return false;
+        }
+
+        Channel& c = ch_[h.channel];
+        if (!c.started) {
+            c.started = true;
+            c.next = h.seq;
+        }
+        Slot& s = c.win[h.seq & (kWindow - 1)];
+        const int32_t ahead = (int32_t)(h.seq - c.next);
+
+        if (ahead >= 0) {
+            // New high-water mark; anything skipped is missing until it turns up
+            if (ahead > 0) {
+                ++stats_.gaps;
+                stats_.missing += (uint32_t)ahead;
+            }
+            c.next = h.seq + 1;
+        } else if ((uint32_t)-ahead > kWindow) {
+            ++stats_.stale;
+            return false;
+        } else if (s.valid && s.seq == h.seq) {
+            ++stats_.duplicates;
+            if (s.line != (uint8_t)line) {
+                Log2Histogram& lead = s.line == (uint8_t)FeedLine::A ? stats_.a_lead
+                                                                     : stats_.b_lead;
+                lead.add(tsc - s.tsc);
+            }
+            return false;
+        } else {
+            ++stats_.recovered;
+            if (stats_.missing) --stats_.missing;
+        }
+
+        s.seq = h.seq;
+        s.tsc = tsc;
+        s.line = (uint8_t)line;
+        s.valid = 1;
+        ++stats_.forwarded[(int)line];
+        return true;
+    }
+
+    const ArbiterStats& stats() const { return stats_; }
+
+   private:
+    struct Slot {
+        uint32_t seq;
+        uint8_t line;
+        uint8_t valid;
+        uint64_t tsc;
+    };
+
+    struct Channel {
+        bool started;
+        uint32_t next;  // next expected sequence number
+        Slot win[kWindow];
+    };
+
+    std::unique_ptr<Channel[]> ch_;
+    ArbiterStats stats_;
+};
+
+// Print one interval (now - prev) of arbitration counters and lead-time
+// percentiles; final=true prints the whole run
+void print_arbiter(const ArbiterStats& now, const ArbiterStats& prev, bool final);
@@ -0,0 +1,44 @@
+#pragma once
+#include <atomic>
+#include <string>
+#include <thread>
+#include "packet_filter.h"
+
+/**
+ * Local control channel for live filter changes: a unix stream socket that
+ * takes one command per line and answers one line each.
+ *
+ *   show                           current rules and versions
+ *   udp_port=N [payload_len=N]     publish new rules (unspecified keys keep
+ *     [csum=0|1]                   their current value); 0 = any; csum turns
+ *                                  checksum verification on or off
+ *
+ * e.g. `echo udp_port=5002 | socat - UNIX-CONNECT:/tmp/uspf.ctl`. Runs on its
+ * own thread (inherits the housekeeping affinity of whoever starts it) and
+ * never touches the capture thread beyond PacketFilter::publish().
+ */
+class FilterControl {
+   public:
+    FilterControl(PacketFilter& filter, std::string path);
+    ~FilterControl();
+
+    FilterControl(const FilterControl&) = delete;
+    FilterControl& operator=(const FilterControl&) = delete;
+
+    // Bind the socket (replacing a stale one) and start serving; false on error
+    bool start();
+    void stop();
+
+    // Apply one command line; returns the reply (no trailing newline)
+    std::string handle(const std::string& line);
+
+   private:
+    void serve();
+    void serve_client(int fd);
+
+    PacketFilter& filter_;
+    std::string path_;
+    int listen_fd_{-1};
+    std::atomic<bool> running_{false};
+    std::thread worker_;
+};
@@ -0,0 +1,180 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "common.h"
+
+// One flight recorder entry, two cache lines. Capture threads record one per
+// packet (accepted or not), engines one per drain.
+struct alignas(64) FlightRecord {
+    uint64_t rx_tsc;    // RX TSC of the packet / of the drain's first tick
+    uint64_t pop_tsc;   // drain popped its first tick (engine; 0 for packets)
+    uint64_t done_tsc;  // end of the pump() batch that filtered, decoded and
+                        // pushed or handled the packet / drain handled
+    uint32_t depth;     // tick ring depth after the push / after the drain
+    uint16_t len;       // frame (or payload-only view) bytes / ticks drained
+    uint8_t verdict;    // FilterVerdict (packets)
+    uint8_t line;       // 0 = A, 1 = B (packets)
+    uint8_t snap[96];   // first bytes of the frame / the drain's first Tick
+};
+static_assert(sizeof(FlightRecord) == 128, "two cache lines");
+
+/**
+ * Always-on circular flight recorder of a hot thread's last N packets or
+ * drains, for looking at a bad tick or a latency spike after the fact. The
+ * hot thread writes it with plain stores and no TSC read of its own per
+ * entry: packets carry their RX stamp and get one done stamp per pump()
+ * batch, drains reuse the engine's pop latency reads. Nothing is shared with
+ * readers but the ring itself, which a dump reads racily, so the newest entry
+ * of a live recorder may be torn.
+ *
+ * Dumps go to text files (flight_recorder_init()): of every recorder on
+ * SIGUSR1 or a crash, and of one recorder when an entry's RX-to-done time
+ * breaches the threshold. A breach records half a ring more, then freezes it
+ * (later entries go to a scratch slot) until the dump is written and the hot
+ * thread re-arms it at its next loop iteration, so the dump holds the spike
+ * in the middle of its context.
+ */
+class FlightRecorder {
+   public:
+    enum class Kind : uint8_t { Packets, Drains };
+    static constexpr size_t kSnap = sizeof(FlightRecord::snap);
+
+    // `name` tags dump files (a string literal or otherwise outliving this)
+    FlightRecorder(const char* name, Kind kind) : name_(name), kind_(kind) {}
+    ~FlightRecorder();
+
+    FlightRecorder(const FlightRecorder&) = delete;
+    FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+    // On the hot thread, before its loop: allocate and prefault the ring as
+    // configured by flight_recorder_init() (none: recorder off), register it
+    // for dumps (all slots taken: recorder off, logged) and give the thread
+    // an alternate signal stack
+    void begin_thread();
+
+    bool on() const { return on_; }
+
+    // Once per loop iteration: picks up a re-arm after a breach dump
+    inline void tick() {
+        if (__builtin_expect(rearm_.load(std::memory_order_relaxed), 0)) resume();
+    }
+
+    // Capture thread, after the packet has been filtered and handled
+    inline void packet(const uint8_t* data, uint16_t len, uint64_t rx_tsc,
+        uint8_t verdict, uint8_t line, uint32_t depth) {
+        FlightRecord& r = next();
+        r.rx_tsc = rx_tsc;
+        r.pop_tsc = 0;
+        r.depth = depth;
+        r.len = len;
+        r.verdict = verdict;
+        r.line = line;
+        if (data) snap_copy(r.snap, data, len < kSnap ? len : kSnap);
+    }
+
+    // Capture thread, around each pump(): entries recorded since `from` get
+    // one done stamp and are checked against the breach threshold
+    uint64_t position() const { return pos_; }
+    inline void end_batch(uint64_t from) {
+        if (pos_ != from) stamp_batch(from);
+    }
+
+    // Engine thread, after a drain of `ticks` ticks starting with `first`
+    inline void drain(const Tick& first, uint64_t pop_tsc, uint64_t done_tsc,
+        size_t ticks, uint32_t depth) {
+        FlightRecord& r = next();
+        r.rx_tsc = first.ts_ns;
+        r.pop_tsc = pop_tsc;
+        r.done_tsc = done_tsc;
+        r.depth = depth;
+        r.len = ticks > 0xFFFF ? 0xFFFF : (uint16_t)ticks;
+        r.verdict = 0;
+        r.line = 0;
+        std::memcpy(r.snap, &first, sizeof(Tick));
+        check(done_tsc - first.ts_ns);
+    }
+
+    // Dump side (flight_recorder_service() and the signal handlers)
+    const char* name() const { return name_; }
+    bool frozen() const { return frozen_.load(std::memory_order_acquire); }
+    bool rearming() const { return rearm_.load(std::memory_order_relaxed); }
+    void rearm() { rearm_.store(true, std::memory_order_relaxed); }
+    uint64_t breaches() const { return breaches_; }
+
+    // Write the recorder to `path`, oldest entry first; formats with integer
+    // code into a stack buffer and calls only open(), write() and close(),
+    // so it can run in a signal handler
+    bool dump(const char* path, const char* reason) const;
+
+   private:
+    static constexpr uint64_t kNever = ~0ULL;
+
+    // memcpy() of n <= kSnap bytes as two or three overlapping fixed-size
+    // copies, which compile to vector moves; a libc call for a variable
+    // length costs more than the rest of packet() together
+    static inline void snap_copy(uint8_t* d, const uint8_t* s, size_t n) {
+        if (n >= 32) {
+            std::memcpy(d, s, 32);
+            if (n > 64) std::memcpy(d + 32, s + 32, 32);
+            std::memcpy(d + n - 32, s + n - 32, 32);
+        } else if (n >= 8) {
+            std::memcpy(d, s, 8);
+            if (n > 16) std::memcpy(d + 8, s + 8, 8);
+            if (n > 24) std::memcpy(d + 16, s + 16, 8);
+            std::memcpy(d + n - 8, s + n - 8, 8);
+        } else {
+            for (size_t i = 0; i < n; ++i) d[i] = s[i];
+        }
+    }
+
+    inline FlightRecord& next() {
+        FlightRecord& r = base_[pos_ & mask_];
+        if (__builtin_expect(++pos_ == stop_at_, 0)) freeze();
+        return r;
+    }
+    // Signed: an RX stamp from a core whose TSC runs ahead is not a breach
+    inline void check(uint64_t ticks) {
+        if (__builtin_expect((int64_t)ticks > breach_ticks_, 0)) trigger();
+    }
+    void stamp_batch(uint64_t from);
+    void trigger();
+    void freeze();
+    void resume();
+
+    const char* name_;
+    const Kind kind_;
+    bool on_{false};
+    FlightRecord* base_{&scratch_};  // recs_, or scratch_ while frozen
+    uint64_t mask_{0};
+    uint64_t pos_{0};           // entries recorded so far
+    uint64_t stop_at_{kNever};  // freeze when pos_ reaches it (breach)
+    int64_t breach_ticks_{INT64_MAX};
+    uint64_t breaches_{0};
+
+    FlightRecord* recs_{nullptr};
+    size_t records_{0};
+    uint64_t valid_from_{0};  // first entry since the last re-arm
+    uint64_t frozen_end_{0};  // pos_ at the freeze
+    double ns_per_tick_{0};
+    std::atomic<bool> frozen_{false};
+    std::atomic<bool> rearm_{false};
+    FlightRecord scratch_{};
+};
+
+/**
+ * Configure flight recorders before any hot thread starts: `records` entries
+ * per hot thread (rounded up to a power of two, 0 = off), the RX-to-done
+ * breach threshold in ns (0 = none) and the dump directory. Installs SIGUSR1
+ * (dump all) and crash handlers (SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT:
+ * dump all, then die by the same signal). The crash handler runs on an
+ * alternate signal stack, set up here for the calling thread and by
+ * begin_thread() for each hot thread, so a stack overflow still dumps.
+ */
+void flight_recorder_init(size_t records, uint64_t breach_ns, const char* dir);
+
+// From the main thread's wait loop: writes the dumps that SIGUSR1 asked for
+// and those of frozen (breached) recorders, then re-arms them. Returns the
+// number of files written.
+size_t flight_recorder_service();
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+
+// Fixed-size power-of-two histogram for hot-path latencies and sizes. Bucket
+// b counts values v with bit_width(v) == b, i.e. [2^(b-1), 2^b), bucket 0
+// holds zeros. add() is a clz and a few adds; no allocation, no locks.
+// Like Stats, it is written by one thread and read racily by a reporter.
+struct Log2Histogram {
+    static constexpr int kBuckets = 48;
+
+    uint64_t counts[kBuckets]{};
+    uint64_t total{0};
+    uint64_t sum{0};
+    uint64_t max{0};
+
+    inline void add(uint64_t v) {
+        int b = v ? 64 - __builtin_clzll(v) : 0;
+        if (b >= kBuckets) b = kBuckets - 1;
+        ++counts[b];
+        ++total;
+        sum += v;
+        if (v > max) max = v;
+    }
+
+    double mean() const { return total ? (double)sum / (double)total : 0.0; }
+
+    // Upper bound of the bucket holding the p-th percentile (0 < p <= 100)
+    uint64_t percentile(double p) const {
+        if (total == 0) return 0;
+        const uint64_t rank = (uint64_t)((double)total * p / 100.0);
+        uint64_t seen = 0;
+        for (int b = 0; b < kBuckets; ++b) {
+            seen += counts[b];
+            if (seen > rank || seen == total) {
+                const uint64_t hi = b == 0 ? 0 : (uint64_t(1) << b) - 1;
+                return hi < max ? hi : max;
+            }
+        }
+        return max;
+    }
+
+    // Fold in another histogram (e.g. one per worker into a total)
+    void merge(const Log2Histogram& o) {
+        for (int b = 0; b < kBuckets; ++b) counts[b] += o.counts[b];
+        total += o.total;
+        sum += o.sum;
+        if (o.max > max) max = o.max;
+    }
+
+    // Interval view: counts accumulated since `earlier` (max is not windowed)
+    Log2Histogram since(const Log2Histogram& earlier) const {
+        Log2Histogram d;
+        for (int b = 0; b < kBuckets; ++b) d.counts[b] = counts[b] - earlier.counts[b];
+        d.total = total - earlier.total;
+        d.sum = sum - earlier.sum;
+        d.max = max;
+        return d;
+    }
+};
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <string>
+#include <utility>
+
+// NUMA node of the NIC behind an -i spec (netmap:eth0, xdp:eth0@1, ...), read
+// from /sys/class/net/<dev>/device/numa_node. -1 if unknown (vale ports,
+// udp:/uring: specs, single-node hosts or virtual devices).
+int nic_numa_node(const std::string& ifname);
+
+// NUMA node of a CPU, or -1 if unknown
+int cpu_numa_node(int cpu);
+
+// What huge_alloc() actually got
+struct HugeInfo {
+    size_t page_size{0};  // 1 GB, 2 MB or the base page size
+    int node{-1};         // node holding the first page after prefault (-1 = unknown)
+};
+
+/**
+ * Map `bytes` of zeroed, pre-faulted memory preferring `node` (-1 = no
+ * policy). Tries 1 GB hugetlb pages for allocations of at least 1 GB, then
+ * 2 MB hugetlb pages, then base pages with MADV_HUGEPAGE. Returns nullptr
+ * only if even the base-page mapping fails.
+ */
+void* huge_alloc(size_t bytes, int node, HugeInfo* info = nullptr);
+void huge_free(void* p, size_t bytes, size_t page_size);
+
+/**
+ * Construct a T in huge_alloc() memory and own it with a shared_ptr whose
+ * deleter runs ~T and unmaps. Used for the tick ring and other hot-path
+ * tables so they sit on the NIC's node without TLB pressure.
+ */
+template <typename T, typename... Args>
+std::shared_ptr<T> make_shared_huge(int node, HugeInfo* info, Args&&... args) {
+    HugeInfo local;
+    if (!info) info = &local;
+    void* mem = huge_alloc(sizeof(T), node, info);
+    if (!mem) throw std::bad_alloc();
+    T* obj = new (mem) T(std::forward<Args>(args)...);
+    const size_t page_size = info->page_size;
+    return std::shared_ptr<T>(obj, [page_size](T* p) {
+        p->~T();
+        huge_free(p, sizeof(T), page_size);
+    });
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Internet checksum (RFC 1071) kernels, shared by PacketFilter and
+// nm_md_sender. The one's-complement sum does not depend on byte order, so
+// words are summed as native uint16 and the folded result is compared or
+// memcpy'd into the header as is: no byte swaps anywhere.
+
+/**
+ * 32-bit partial one's-complement sum of `len` bytes, added to `sum`.
+ *
+ * SSE2 (baseline x86-64, so the sender gets it without -march): 16 bytes per
+ * step, split into their eight 16-bit words in 32-bit lanes (mask and shift)
+ * and accumulated without carries; the lanes are folded once at the end. A
+ * 20-byte IPv4 header is one vector step and a 4-byte tail. With AVX2 (the
+ * -march=native main build) whole datagrams go 32 bytes per step first. Lanes
+ * cannot overflow below 512 KB.
+ */
+inline uint32_t csum_partial(const void* data, size_t len, uint32_t sum) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    uint64_t s = sum;
+#if defined(__AVX2__)
+    if (len >= 32) {
+        const __m256i lo16 = _mm256_set1_epi32(0xFFFF);
+        __m256i acc = _mm256_setzero_si256();
+        for (; len >= 32; p += 32, len -= 32) {
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            acc = _mm256_add_epi32(acc, _mm256_and_si256(v, lo16));
+            acc = _mm256_add_epi32(acc, _mm256_srli_epi32(v, 16));
+        }
+        uint32_t lanes[8];
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), acc);
+        for (uint32_t l : lanes) s += l;
+    }
+#endif
+#if defined(__SSE2__)
+    if (len >= 16) {
+        const __m128i lo16 = _mm_set1_epi32(0xFFFF);
+        __m128i acc = _mm_setzero_si128();
+        for (; len >= 16; p += 16, len -= 16) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            acc = _mm_add_epi32(acc, _mm_and_si128(v, lo16));
+            acc = _mm_add_epi32(acc, _mm_srli_epi32(v, 16));
+        }
+        uint32_t lanes[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc);
+        s += (uint64_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+#endif
+    for (; len >= 4; p += 4, len -= 4) {
+        uint32_t w;
+        std::memcpy(&w, p, 4);
+        s += w;
+    }
+    if (len >= 2) {
+        uint16_t w;
+        std::memcpy(&w, p, 2);
+        s += w;
+        p += 2;
+        len -= 2;
+    }
+    if (len) {
+        // A trailing odd byte is the first byte of a zero-padded word
+        const uint8_t pad[2] = {p[0], 0};
+        uint16_t w;
+        std::memcpy(&w, pad, 2);
+        s += w;
+    }
+    s = (s & 0xFFFFFFFFu) + (s >> 32);
+    s = (s & 0xFFFFFFFFu) + (s >> 32);
+    return (uint32_t)s;
+}
+
+// Fold a partial sum to 16 bits; 0xFFFF over data that includes its checksum
+// field means the checksum is valid
+inline uint16_t csum_fold(uint32_t sum) {
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    return (uint16_t)sum;
+}
+
+// Partial sum of the UDP/IPv4 pseudo-header: addresses from the IPv4 header
+// at `ip`, protocol 17 and the UDP length (network order bytes at `ulen_be`)
+inline uint32_t udp_pseudo_sum(const uint8_t* ip, const uint8_t* ulen_be) {
+    const uint8_t tail[4] = {0, 17, ulen_be[0], ulen_be[1]};
+    return csum_partial(tail, 4, csum_partial(ip + 12, 8, 0));
+}
+
+// Checksum field value for a header whose field was zeroed before summing
+inline uint16_t csum_finish(uint32_t sum) {
+    return (uint16_t)~csum_fold(sum);
+}
+
+// UDP variant: a computed 0 is sent as 0xFFFF, since 0 means "no checksum"
+inline uint16_t udp_csum_finish(uint32_t sum) {
+    const uint16_t c = csum_finish(sum);
+    return c ? c : 0xFFFF;
+}
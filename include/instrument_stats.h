@@ -0,0 +1,123 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "common.h"
+
+/**
+ * Rolling per-instrument statistics for the strategy: EWMA mean and variance
+ * of quoted prices, a faster EWMA of squared mid changes (short-horizon
+ * volatility), and the top of book for a size-weighted microprice.
+ *
+ * Instruments get dense indices in arrival order through a fixed open-addressed
+ * id -> index table; the state itself is one flat array of 32-byte records, so
+ * an update touches one cache line. Everything is sized in the constructor:
+ * update() is O(1), never allocates, and ticks for instruments beyond the
+ * capacity are counted as untracked and ignored.
+ */
+class InstrumentStats {
+   public:
+    static constexpr uint32_t kNone = ~0u;
+
+    struct State {
+        float mean;     // EWMA of quoted prices
+        float var;      // EWMA variance around mean
+        float vol2;     // fast EWMA of squared mid-price changes
+        float bid, ask;
+        float bid_qty, ask_qty;
+        uint32_t n;     // ticks seen (saturating)
+    };
+    static_assert(sizeof(State) == 32, "two instruments per cache line");
+
+    // `capacity` instruments; `alpha` weights the mean/variance (horizon about
+    // 2/alpha ticks), `vol_alpha` the short-horizon volatility
+    explicit InstrumentStats(size_t capacity, float alpha = 0.05f,
+        float vol_alpha = 0.25f);
+
+    // Dense index of `instr_id`, assigning the next free one on first sight;
+    // kNone when the table is full
+    inline uint32_t index(uint32_t instr_id) {
+        uint32_t i = (instr_id * 0x9E3779B9u) >> shift_;
+        for (;; i = (i + 1) & mask_) {
+            Slot& s = slots_[i];
+            if (s.dense != kNone) {
+                if (s.id == instr_id) return s.dense;
+            } else {
+                if (size_ == state_.size()) return kNone;
+                s.id = instr_id;
+                s.dense = size_++;
+                return s.dense;
+            }
+        }
+    }
+
+    // Fold one tick into its instrument's state; returns the dense index
+    // (kNone if untracked). `before`, if given, receives the state as it was
+    // before this tick, which is what a signal on this tick should compare to.
+    inline uint32_t update(const Tick& t, State* before = nullptr) {
+        const uint32_t idx = index(t.instr_id);
+        if (idx == kNone) {
+            ++untracked_;
+            return kNone;
+        }
+        State& s = state_[idx];
+        if (before) *before = s;
+
+        const float px = t.px;
+        if (s.n == 0) {
+            s.mean = px;
+            s.var = 0.f;
+        } else {
+            const float d = px - s.mean;
+            s.mean += alpha_ * d;
+            s.var = (1.f - alpha_) * (s.var + alpha_ * d * d);
+        }
+
+        // Mid-to-mid change, once both sides have been quoted
+        const bool two_sided = s.bid > 0.f && s.ask > 0.f;
+        const float old_mid = 0.5f * (s.bid + s.ask);
+        if (t.side == 0) {
+            s.bid = px;
+            s.bid_qty = t.qty;
+        } else {
+            s.ask = px;
+            s.ask_qty = t.qty;
+        }
+        if (two_sided) {
+            const float dm = 0.5f * (s.bid + s.ask) - old_mid;
+            s.vol2 += vol_alpha_ * (dm * dm - s.vol2);
+        }
+        if (s.n != ~0u) ++s.n;
+        return idx;
+    }
+
+    const State& state(uint32_t idx) const { return state_[idx]; }
+    size_t size() const { return size_; }
+    size_t capacity() const { return state_.size(); }
+    uint64_t untracked() const { return untracked_; }
+
+    static float stddev(const State& s) { return std::sqrt(s.var); }
+    static float volatility(const State& s) { return std::sqrt(s.vol2); }
+
+    // Size-weighted mid: leans toward the side with less size behind it;
+    // falls back to the mean until both sides have been quoted
+    static float microprice(const State& s) {
+        const float q = s.bid_qty + s.ask_qty;
+        if (s.bid <= 0.f || s.ask <= 0.f || q <= 0.f) return s.mean;
+        return (s.bid * s.ask_qty + s.ask * s.bid_qty) / q;
+    }
+
+   private:
+    struct Slot {
+        uint32_t id;
+        uint32_t dense;  // kNone = empty
+    };
+
+    float alpha_, vol_alpha_;
+    uint32_t mask_, shift_;
+    std::vector<Slot> slots_;   // id -> dense index, load <= 50%
+    std::vector<State> state_;  // dense-indexed
+    uint32_t size_{0};
+    uint64_t untracked_{0};
+};
@@ -0,0 +1,98 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include "common.h"
+#include "histogram.h"
+#include "spsc_ring.h"
+
+// One loop iteration that took longer than the stall threshold, with the
+// context needed to tell "core stolen" causes apart: context switches point to
+// preemption or blocking, none at all to IRQ/SMI time.
+struct StallRecord {
+    uint64_t wall_ns{0};     // CLOCK_REALTIME when the stall ended
+    uint64_t gap_ns{0};      // iteration gap
+    int64_t ring_fill{-1};   // tick ring occupancy (-1 = unknown)
+    int64_t rx_backlog{-1};  // frames waiting in the RX rings (-1 = unknown)
+    uint32_t vcsw{0};        // voluntary context switches in the sampling window
+    uint32_t ivcsw{0};       // involuntary context switches (preemption)
+};
+
+/**
+ * TSC-stamps each iteration of a hot loop and keeps a histogram of iteration
+ * gaps. Gaps above the threshold are queued as StallRecords for a reporter
+ * thread to print, so the hot thread never formats or writes output itself.
+ * Context-switch counts come from getrusage(RUSAGE_THREAD), sampled every
+ * ~10 ms and on each stall, so a stall's counts cover at most that window.
+ */
+class JitterMonitor {
+   public:
+    using Probe = std::function<int64_t()>;
+
+    explicit JitterMonitor(const char* name) : name_(name) {}
+
+    // Stall threshold in ns (0 = monitor off); call before the loop starts
+    void set_threshold_ns(uint64_t ns) { threshold_ns_ = ns; }
+
+    // Optional fill-level probes, evaluated only when a stall is recorded
+    void set_probes(Probe ring_fill, Probe rx_backlog) {
+        ring_fill_ = std::move(ring_fill);
+        rx_backlog_ = std::move(rx_backlog);
+    }
+
+    // Called on the monitored thread before its loop
+    void begin_thread();
+
+    // Stamp one iteration
+    inline void tick() {
+        if (!enabled_) return;
+        const uint64_t now = rdtsc();
+        const uint64_t gap = now - last_;
+        last_ = now;
+        hist_.add(gap);
+        if (__builtin_expect(gap > stall_ticks_, 0)) on_stall(gap);
+        if (__builtin_expect(now >= next_sample_, 0)) sample_rusage(now);
+    }
+
+    // Restart the gap clock after a deliberate sleep, so it is not a stall
+    inline void resume() {
+        if (enabled_) last_ = rdtsc();
+    }
+
+    // Reporter side
+    bool enabled() const { return enabled_; }
+    const char* name() const { return name_; }
+    bool pop_stall(StallRecord& out) { return stalls_.pop(out); }
+    uint64_t stalls() const { return stall_count_; }
+    uint64_t stalls_lost() const { return stalls_lost_; }
+    const Log2Histogram& gaps() const { return hist_; }  // in TSC ticks
+    uint64_t threshold_ns() const { return threshold_ns_; }
+
+   private:
+    void on_stall(uint64_t gap_ticks);
+    void sample_rusage(uint64_t now);
+
+    const char* name_;
+    uint64_t threshold_ns_{0};
+    bool enabled_{false};
+    double ns_per_tick_{0};
+    uint64_t stall_ticks_{~0ULL};
+    uint64_t sample_ticks_{0};
+    uint64_t last_{0};
+    uint64_t next_sample_{0};
+
+    // getrusage snapshot at the start of the current sampling window
+    uint64_t nvcsw_{0};
+    uint64_t nivcsw_{0};
+
+    Probe ring_fill_;
+    Probe rx_backlog_;
+
+    Log2Histogram hist_;
+    uint64_t stall_count_{0};
+    uint64_t stalls_lost_{0};
+    SpscRing<StallRecord, 256> stalls_;
+};
+
+// Print queued stalls and a gap-percentile line for one monitor. `prev` is the
+// histogram at the previous call (updated); final=true prints the whole run.
+void report_jitter(JitterMonitor& m, Log2Histogram& prev, bool final);
@@ -1,46 +1,227 @@
 #pragma once
+#include "alloc_audit.h"
 #include "bypass_io.h"
+#include "decoder_registry.h"
+#include "feed_arbiter.h"
+#include "flight_recorder.h"
 #include "packet_filter.h"
 #include "spsc_ring.h"
 #include "common.h"
+#include "conflation.h"
+#include "jitter_monitor.h"
+#include "perf_counters.h"
+#include "run_to_completion.h"
+#include "tick_decode.h"
+#include "tick_shard.h"
+#include "wait_strategy.h"
 #include <functional>
 #include <thread>
 #include <atomic>
 #include <chrono>
 #include <memory>
+#include <vector>
 
 class PacketCapture {
 public:
     using Ring = SpscRing<Tick, 4096>;
 
-    PacketCapture(const BypassConfig& io_cfg, const FilterConfig& f_cfg);
+    // `decoders` maps UDP ports to payload decoders (default: md14 everywhere)
+    PacketCapture(const BypassConfig& io_cfg, const FilterConfig& f_cfg,
+                  DecoderRegistry decoders = DecoderRegistry());
 
     int pump(const std::function<bool(const PacketView&)>& cb);
 
+    // Also capture a redundant B line (same feed, another port or NIC) and
+    // arbitrate A/B by PackedHeader sequence number: the first copy of each
+    // datagram is decoded, the other dropped. Call before start(); returns
+    // false if the B line could not be opened.
+    bool add_line_b(const BypassConfig& cfg);
+
+    // Conflate instead of dropping when the tick ring is full: keep the latest
+    // pending tick per (instr_id, side) in a table of `slots` entries and drain
+    // it into the ring as space frees. With several rings each gets its own
+    // table. Call before start().
+    void enable_conflation(size_t slots);
+
+    // Signal `w` after each loop iteration that pushed ticks to ring `shard`,
+    // for an engine in WaitMode::Block (a fence and a load unless the engine
+    // is parked). Call before start().
+    void set_wakeup(ConsumerWakeup* w, size_t shard = 0) {
+        if (wakeups_.size() <= shard) wakeups_.resize(shard + 1, nullptr);
+        wakeups_[shard] = w;
+    }
+
     // Background capture: runs a producer thread that pushes Tick into ring
     // - running_flag: external stop flag (e.g., your g_running)
     // - end: stop time (pass max() if not timed)
     // - cpu_affinity: core to pin the capture thread (-1 = no pin)
+    // - rt_priority: SCHED_FIFO priority for the capture thread (0 = SCHED_OTHER)
     void start(std::shared_ptr<Ring> ring,
                std::atomic<bool>* running_flag,
                std::chrono::time_point<std::chrono::steady_clock> end,
-               int cpu_affinity = -1);
+               int cpu_affinity = -1,
+               int rt_priority = 0);
+
+    // Same, dispatching to one ring per engine worker (at most
+    // ShardSplitter::kMaxShards): each tick goes to rings[shard_of(instr_id)],
+    // so every instrument's ticks stay in order on one worker
+    void start(std::vector<std::shared_ptr<Ring>> rings,
+               std::atomic<bool>* running_flag,
+               std::chrono::time_point<std::chrono::steady_clock> end,
+               int cpu_affinity = -1,
+               int rt_priority = 0);
+
+    /**
+     * Run-to-completion instead: no ring and no engine thread. The capture
+     * thread decodes each accepted datagram and calls h(view, ticks, n) on the
+     * same core before touching the next packet, so capture, decode, strategy
+     * and an optional tx() all happen in one pass over a hot cache line.
+     * Handler is a template parameter, not a std::function, so the strategy
+     * inlines into the decode loop. A line only, no conflation; RX-to-decision
+     * latency goes to inline_stats().
+     */
+    template <typename Handler>
+    void start_inline(Handler h,
+                      std::atomic<bool>* running_flag,
+                      std::chrono::time_point<std::chrono::steady_clock> end,
+                      int cpu_affinity = -1,
+                      int rt_priority = 0);
 
     void stop();
     bool is_running() const { return running_.load(std::memory_order_relaxed); }
 
     const Stats& stats() const { return stats_; }
+    IoBackend backend() const { return io_.backend(); }
+    const RxTelemetry& rx_telemetry() const { return io_.telemetry(); }
+    const DecoderRegistry& decoders() const { return decoders_; }
+
+    // Filter rejections by reason, per line (empty with DROP_REASONS=0)
+    const FilterDrops& filter_drops() const { return filter_drops_; }
+    const FilterDrops& filter_drops_b() const { return filter_drops_b_; }
+
+    // Live filter: publish() new rules from any thread (see FilterControl)
+    PacketFilter& filter() { return filter_; }
+
+    // B line and arbitration state (only meaningful after add_line_b())
+    bool arbitrated() const { return io_b_ != nullptr; }
+    const Stats& stats_b() const { return stats_b_; }
+    IoBackend backend_b() const { return io_b_ ? io_b_->backend() : io_.backend(); }
+    const ArbiterStats& arbiter() const { return arbiter_->stats(); }
+
+    // Conflation state (only meaningful after enable_conflation()), summed
+    // over the per-ring tables
+    bool conflating() const { return conflate_slots_ != 0; }
+    ConflationStats conflation() const;
+    size_t conflation_pending() const;
+
+    // Dispatch to engine workers: ticks pushed and dropped per ring, and each
+    // ring's current depth (after start())
+    size_t shards() const { return rings_.size(); }
+    const ShardStats& shard_stats(size_t shard) const { return shard_stats_[shard]; }
+    size_t shard_depth(size_t shard) const { return rings_[shard]->size(); }
+
+    // Transmit on the A line; only from the capture thread, i.e. a
+    // start_inline() handler. Counted in inline_stats(), where len 0 (no frame
+    // could be built) is a failure.
+    int tx(const uint8_t* data, uint16_t len) {
+        const int r = len ? io_.tx(data, len) : -1;
+        ++(r < 0 ? inline_stats_.tx_failed : inline_stats_.tx);
+        return r;
+    }
+
+    // Run-to-completion latency and counts (only meaningful after start_inline())
+    const InlineStats& inline_stats() const { return inline_stats_; }
+
+    // Hardware counters around each non-empty pump() (make PERF=1, USPF_PERF=1)
+    PerfTotals perf() const { return perf_.totals(); }
+
+    // Loop-gap histogram and stall log of the capture thread (configure the
+    // threshold before start())
+    JitterMonitor& jitter() { return jitter_; }
+
+    // Last packets of the capture thread, both lines (flight_recorder_init())
+    const FlightRecorder& flight_recorder() const { return fdr_; }
 
 private:
-    void thread_main(std::shared_ptr<Ring> ring,
-                     std::atomic<bool>* running_flag,
+    int pump_io(BypassIO& io, Stats& st, FilterDrops& fd,
+        const std::function<bool(const PacketView&)>& cb);
+
+    void thread_main(std::atomic<bool>* running_flag,
                      std::chrono::time_point<std::chrono::steady_clock> end,
-                     int cpu_affinity);
+                     int cpu_affinity,
+                     int rt_priority);
+
+    // Shared by both capture loops: pinning, RT setup, perf/jitter/audit
+    // bracketing and the final stats snapshot
+    void thread_begin(int cpu_affinity, int rt_priority);
+    void thread_end();
+    bool keep_running(const std::atomic<bool>* running_flag,
+        std::chrono::time_point<std::chrono::steady_clock> end) const {
+        return running_.load(std::memory_order_relaxed) && running_flag &&
+            running_flag->load(std::memory_order_relaxed) &&
+            std::chrono::steady_clock::now() < end;
+    }
 
     BypassIO io_;
     PacketFilter filter_;
+    DecoderRegistry decoders_;
+    std::unique_ptr<BypassIO> io_b_;
+    Stats stats_b_{};
+    std::unique_ptr<FeedArbiter> arbiter_;
+    size_t conflate_slots_{0};
+    std::vector<std::unique_ptr<TickConflator>> conflators_;  // one per ring
+    std::vector<ConsumerWakeup*> wakeups_;                    // one per ring
+    std::vector<std::shared_ptr<Ring>> rings_;
+    std::vector<ShardStats> shard_stats_;
     Stats stats_{};
+    FilterDrops filter_drops_;
+    FilterDrops filter_drops_b_;
+    PerfCounters perf_;
+    JitterMonitor jitter_{"cap"};
+    AllocAuditGate audit_;
+    FlightRecorder fdr_{"cap", FlightRecorder::Kind::Packets};
+    uint32_t fdr_depth_{0};  // tick ring depth after the last push, for fdr_
+    InlineStats inline_stats_;
 
     std::atomic<bool> running_{false};
     std::thread worker_;
 };
+
+template <typename Handler>
+void PacketCapture::start_inline(Handler h, std::atomic<bool>* running_flag,
+    std::chrono::time_point<std::chrono::steady_clock> end, int cpu_affinity,
+    int rt_priority) {
+    bool expected = false;
+    if (!running_.compare_exchange_strong(expected, true)) return;
+
+    worker_ = std::thread([this, h = std::move(h), running_flag, end, cpu_affinity,
+                              rt_priority]() mutable {
+        // PacketView -> decoder -> handler, then the datagram's age once the
+        // handler is done with all of its ticks. Two pointers of captures, so
+        // the std::function pump() takes stores it inline.
+        auto decide = [this, &h](const PacketView& v) -> bool {
+            const size_t n = decoders_.decode(
+                v, [&](const Tick* t, size_t k) { h(v, t, k); });
+            if (n) {
+                InlineStats& st = inline_stats_;
+                ++st.datagrams;
+                st.ticks += n;
+                const uint64_t now = rdtsc();
+                if (now >= v.tsc) st.decide_latency.add(now - v.tsc);
+            }
+            return true;
+        };
+        const std::function<bool(const PacketView&)> cb = decide;
+
+        thread_begin(cpu_affinity, rt_priority);
+        while (keep_running(running_flag, end)) {
+            jitter_.tick();
+            audit_.tick();
+            fdr_.tick();
+            perf_.begin();
+            const int got = pump(cb);
+            perf_.end(got > 0 ? (uint64_t)got : 0);
+        }
+        thread_end();
+    });
+}
@@ -1,5 +1,8 @@
 #pragma once
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
+#include <mutex>
 #include <vector>
 #include "common.h"
 
@@ -8,14 +11,123 @@ struct FilterConfig {
     uint32_t dst_ip = 0;  // 0 = any
     bool require_udp = true;
     bool require_ipv4 = true;
+    uint16_t payload_len = 14;  // exact UDP payload length; 0 = any (decoders check)
+    bool verify_checksums = false;  // IPv4 header and UDP checksums (frame views)
 };
 
+// What the filter made of a frame: Accept, or why it was dropped
+enum class FilterVerdict : uint8_t {
+    Accept,
+    ShortFrame,    // shorter than an Ethernet header
+    NotIpv4,       // ethertype is not IPv4
+    BadIhl,        // IPv4 header length under 20 bytes or past the frame
+    NotUdp,        // IP protocol is not UDP, or no room for a UDP header
+    WrongPort,     // UDP destination port is not the configured one
+    BadUdpLen,     // UDP length under 8, or payload running past the frame
+    PayloadLen,    // payload length is not the configured one
+    EmptyPayload,  // payload-only view without data
+    BadChecksum,   // IPv4 header or UDP checksum wrong (verify_checksums)
+    kCount
+};
+
+// Short label for reports ("port", "ihl", ...)
+const char* verdict_name(FilterVerdict v);
+
+/**
+ * Drops per FilterVerdict for one capture line. Written only by the capture
+ * thread and read racily by the reporter, like Stats; aligned to its own cache
+ * lines so the reporter's reads never share one with the hot counters.
+ * Building with -DUSPF_NO_DROP_REASONS (make DROP_REASONS=0) removes the array
+ * and turns add() into nothing, for the leanest builds.
+ */
+struct alignas(CACHELINE_SIZE) FilterDrops {
+#ifndef USPF_NO_DROP_REASONS
+    static constexpr bool kEnabled = true;
+    uint64_t n[(size_t)FilterVerdict::kCount]{};
+    inline void add(FilterVerdict v) { ++n[(size_t)v]; }
+#else
+    static constexpr bool kEnabled = false;
+    inline void add(FilterVerdict) {}
+#endif
+};
+
+// One "drops[line]: reason=count ..." line of the interval's non-zero reasons
+void print_filter_drops(const char* line, const FilterDrops& now,
+    const FilterDrops& prev, bool final);
+
+/**
+ * L2-L4 packet filter whose rules can be replaced while capture runs.
+ *
+ * Rules are published as immutable, versioned snapshots behind an atomic
+ * pointer. The capture thread calls refresh() once per batch: if a newer
+ * snapshot is live it copies the rules into cfg_, which accept() reads exactly
+ * as before, and acknowledges the version. Per-packet cost is unchanged; the
+ * per-batch cost is one acquire load. A snapshot is freed by the next
+ * publish() once the reader has acknowledged a later version (epoch
+ * reclamation with a single reader), so a snapshot is never freed mid-copy.
+ */
 class PacketFilter {
    public:
-    explicit PacketFilter(const FilterConfig& cfg) : cfg_(cfg) {}
+    explicit PacketFilter(const FilterConfig& cfg);
+    ~PacketFilter();
+
+    PacketFilter(const PacketFilter&) = delete;
+    PacketFilter& operator=(const PacketFilter&) = delete;
+
+    // Reader (capture thread), at a batch boundary: adopt the latest rules
+    inline void refresh() {
+        const Snapshot* s = live_.load(std::memory_order_acquire);
+        if (__builtin_expect(s != adopted_, 0)) adopt(s);
+    }
+
+    // Writer (any thread): publish new rules; returns their version. They
+    // take effect at the reader's next refresh().
+    uint64_t publish(const FilterConfig& cfg);
+
+    // Latest published rules and version, and the version the reader runs
+    FilterConfig published(uint64_t* version = nullptr) const;
+    uint64_t adopted_version() const { return seen_.load(std::memory_order_acquire); }
+
+    // Verdict for an Ethernet frame: Accept if the packet should be kept
+    FilterVerdict classify(const uint8_t* p, uint16_t len) const;
+
+    // Same payload length check for payload-only views (socket backends), where
+    // the kernel has already done the L2-L4 and port matching
+    FilterVerdict classify_payload(const uint8_t* payload, uint16_t len) const;
+
+    // Dispatch on the view's layer
+    FilterVerdict classify(const PacketView& v) const {
+        return v.payload_only ? classify_payload(v.data, v.len) : classify(v.data, v.len);
+    }
+
     // Returns true if packet should be kept
-    bool accept(const uint8_t* p, uint16_t len) const;
+    bool accept(const uint8_t* p, uint16_t len) const {
+        return classify(p, len) == FilterVerdict::Accept;
+    }
+    bool accept_payload(const uint8_t* payload, uint16_t len) const {
+        return classify_payload(payload, len) == FilterVerdict::Accept;
+    }
+    bool accept(const PacketView& v) const {
+        return classify(v) == FilterVerdict::Accept;
+    }
 
    private:
+    struct Snapshot {
+        FilterConfig cfg;
+        uint64_t version;
+    };
+
+    void adopt(const Snapshot* s);
+
+    // Reader-owned: the rules accept() runs on and where they came from
     FilterConfig cfg_;
+    const Snapshot* adopted_{nullptr};
+
+    std::atomic<const Snapshot*> live_{nullptr};
+    std::atomic<uint64_t> seen_{0};  // version the reader last adopted
+
+    // Writer side
+    mutable std::mutex mu_;
+    uint64_t next_version_{1};
+    std::vector<const Snapshot*> retired_;
 };
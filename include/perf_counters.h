@@ -0,0 +1,96 @@
+#pragma once
+#include <cstdint>
+
+// Accumulated hardware counter deltas for one thread. `units` is whatever the
+// instrumented section processed (packets for capture, ticks for the engine),
+// so per-unit figures can be derived; sections that processed nothing are not
+// accumulated.
+struct PerfTotals {
+    uint64_t cycles{0};
+    uint64_t instructions{0};
+    uint64_t l1d_misses{0};
+    uint64_t llc_misses{0};
+    uint64_t branches{0};
+    uint64_t branch_misses{0};
+    uint64_t units{0};
+    uint64_t samples{0};
+};
+
+PerfTotals operator-(const PerfTotals& a, const PerfTotals& b);
+PerfTotals operator+(const PerfTotals& a, const PerfTotals& b);
+
+// Print one "perf[tag]: IPC=.. L1D/unit=.. LLC/unit=.. br-miss=..%" line
+void print_perf(const char* tag, const char* unit, const PerfTotals& d);
+
+#ifdef USPF_PERF_COUNTERS
+
+// Per-thread perf_event_open counter group (cycles, instructions, L1D read
+// misses, LLC misses, branches, branch misses), read in user space with rdpmc
+// from the mmap'ed event pages, or with one read() of the group when rdpmc is
+// unavailable. Built with `make PERF=1` and enabled at runtime with USPF_PERF=1.
+class PerfCounters {
+   public:
+    PerfCounters() = default;
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    // Open the group for the calling thread; no-op unless USPF_PERF is set
+    bool open(const char* tag);
+    void close();
+    bool enabled() const { return enabled_; }
+
+    inline void begin() {
+        if (!enabled_) return;
+        started_ = read_all(start_);
+    }
+
+    // Close the section opened by begin(); `units` == 0 discards it
+    inline void end(uint64_t units) {
+        if (!enabled_ || !started_ || units == 0) return;
+        uint64_t now[kEvents];
+        if (!read_all(now)) return;
+        totals_.cycles += now[0] - start_[0];
+        totals_.instructions += now[1] - start_[1];
+        totals_.l1d_misses += now[2] - start_[2];
+        totals_.llc_misses += now[3] - start_[3];
+        totals_.branches += now[4] - start_[4];
+        totals_.branch_misses += now[5] - start_[5];
+        totals_.units += units;
+        ++totals_.samples;
+    }
+
+    // Snapshot for a reporter thread (plain loads, like Stats)
+    PerfTotals totals() const { return totals_; }
+
+   private:
+    static constexpr int kEvents = 6;
+
+    bool read_all(uint64_t* out);
+    bool read_group(uint64_t* out);
+
+    bool enabled_{false};
+    bool use_rdpmc_{false};
+    bool started_{false};
+    int fds_[kEvents]{-1, -1, -1, -1, -1, -1};
+    void* pages_[kEvents]{};
+    uint64_t start_[kEvents]{};
+    PerfTotals totals_{};
+};
+
+#else
+
+// Compiled-out stand-in: every call is an empty inline, so the hot loops are
+// identical to an uninstrumented build.
+class PerfCounters {
+   public:
+    bool open(const char*) { return false; }
+    void close() {}
+    bool enabled() const { return false; }
+    void begin() {}
+    void end(uint64_t) {}
+    PerfTotals totals() const { return {}; }
+};
+
+#endif
@@ -0,0 +1,27 @@
+#pragma once
+#include <string>
+
+// Low-jitter runtime settings (--realtime and the per-thread core/priority
+// options). Core -1 leaves a thread unpinned; priority 0 keeps SCHED_OTHER.
+struct RealtimeConfig {
+    bool enabled = false;        // mlockall + prefault + startup report
+    int capture_core = -1;       // -c
+    int engine_core = -1;        // -e
+    int housekeeping_core = -1;  // -k: main thread and reporter
+    int fifo_priority = 0;       // --fifo: SCHED_FIFO for capture and engine
+};
+
+/**
+ * Lock current and future mappings (mlockall) and stop glibc from trimming or
+ * mmap'ing its heap, so nothing on the hot path page-faults after startup.
+ * Returns false if mlockall failed (usually RLIMIT_MEMLOCK without root).
+ */
+bool realtime_lock_memory();
+
+// Per-thread setup for a hot thread, called after pinning: optional
+// SCHED_FIFO, and stack pre-faulting when memory is locked
+void realtime_thread_init(const char* name, int fifo_priority);
+
+// Print what the host does (isolcpus, nohz_full, NIC IRQ affinity, governor,
+// RT throttling) for the configured cores, one line per finding
+void realtime_report(const RealtimeConfig& rt, const std::string& ifname);
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "common.h"
+#include "histogram.h"
+
+// Run-to-completion counters (capture thread writes, reporter reads, like
+// Stats). decide_latency is the inline counterpart of the two-thread
+// pipeline's WaitStats::decide_latency: RX to strategy done, ring hop or not.
+struct InlineStats {
+    Log2Histogram decide_latency;  // TSC ticks from RX of a datagram to its ticks
+                                   // decided (and any order queued)
+    uint64_t datagrams{0};         // reached the handler with at least one tick
+    uint64_t ticks{0};
+    uint64_t tx{0};         // order frames queued by PacketCapture::tx()
+    uint64_t tx_failed{0};  // not sent: no frame headers, TX ring full, or a
+                            // backend without TX (sockets, io_uring)
+};
+
+// Print run-to-completion counters for one interval (now - prev); final=true
+// prints the whole run
+void print_inline(const InlineStats& now, const InlineStats& prev, bool final);
+
+// Largest frame build_order_frame() writes: Ethernet, IPv4 with options, UDP
+// and one md14 record
+constexpr size_t kOrderFrameMax = 14 + 60 + 8 + 14;
+
+/**
+ * Order for a signal, as a reply to the frame that carried the tick: the
+ * received Ethernet/IPv4/UDP headers with MACs, addresses and ports swapped,
+ * carrying the tick as one md14 record whose side is the order's (a buy
+ * answers an ask). Checksums are recomputed; the IP ID and TTL are kept.
+ *
+ * @return frame length, or 0 for a payload-only view (socket backends) or a
+ *         frame that is not IPv4/UDP
+ */
+uint16_t build_order_frame(const PacketView& v, const Tick& t, uint8_t* out);
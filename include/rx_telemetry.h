@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include "histogram.h"
+
+// Per-ring RX telemetry, sampled at every sync of that ring. Together these
+// tell a receiver-bound run (high occupancy, take pinned at the burst cap)
+// from a generator-bound one (mostly empty polls) and show how close the
+// ring gets to overflowing, which is where the NIC starts dropping.
+struct RxRingTelemetry {
+    uint32_t ring_size{0};     // slots in this ring (0 = unknown)
+    Log2Histogram occupancy;   // frames available at sync (nm_ring_space)
+    Log2Histogram take;        // frames taken per non-empty call
+    uint64_t burst_capped{0};  // calls where take hit the burst limit
+    uint64_t empty{0};         // syncs that found this ring empty
+};
+
+struct RxTelemetry {
+    static constexpr int kMaxRings = 64;
+
+    int nrings{0};
+    uint64_t polls{0};        // rx_batch() calls
+    uint64_t empty_polls{0};  // calls that returned nothing from any ring
+    RxRingTelemetry ring[kMaxRings];
+
+    // Ring r had `avail` frames at sync and the caller took `take` of them
+    inline void record(int r, uint32_t avail, uint32_t take, uint32_t burst) {
+        RxRingTelemetry& t = ring[r < kMaxRings ? r : kMaxRings - 1];
+        t.occupancy.add(avail);
+        if (avail == 0) {
+            ++t.empty;
+            return;
+        }
+        t.take.add(take);
+        if (take >= burst) ++t.burst_capped;
+    }
+
+    // For backends that cannot see their queue depth (recvmmsg): take only
+    inline void record_take(int r, uint32_t take, uint32_t burst) {
+        RxRingTelemetry& t = ring[r < kMaxRings ? r : kMaxRings - 1];
+        if (take == 0) {
+            ++t.empty;
+            return;
+        }
+        t.take.add(take);
+        if (take >= burst) ++t.burst_capped;
+    }
+
+    inline void end_poll(int processed) {
+        ++polls;
+        if (processed <= 0) ++empty_polls;
+    }
+};
+
+// Print one interval (now - prev) of telemetry: a summary line with a
+// receiver/generator-bound hint, then one line per ring that saw traffic
+void print_rx_telemetry(const RxTelemetry& now, const RxTelemetry& prev, bool final);
@@ -0,0 +1,110 @@
+#pragma once
+#include <sys/types.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "common.h"
+#include "spsc_ring.h"
+#include "wait_strategy.h"
+
+/**
+ * First page of a shared tick ring file. Nothing in the file is a pointer: the
+ * ring sits at a fixed offset and its head/tail are indices, so each process
+ * may map it at a different address. A consumer refuses a file whose magic,
+ * version or geometry differ from its own build (bump kVersion whenever Tick
+ * or this header changes layout).
+ */
+struct ShmRingHeader {
+    static constexpr uint64_t kMagic = 0x31474E4952465055ull;  // "UPFRING1"
+    static constexpr uint32_t kVersion = 1;
+
+    uint64_t magic;
+    uint32_t version;
+    uint32_t header_bytes;  // offset of the ring from the start of the file
+    uint32_t slot_bytes;    // sizeof(Tick)
+    uint32_t slots;         // ring size N (capacity N - 1)
+    uint64_t ring_bytes;    // sizeof the ring object at header_bytes
+    uint64_t file_bytes;    // file size (rounded to the backing page size)
+
+    std::atomic<int32_t> producer_pid;  // 0 once the producer has closed it
+    std::atomic<int32_t> consumer_pid;  // 0 = no consumer attached
+    std::atomic<uint64_t> attaches;     // consumer attaches so far
+
+    // Eventcount for a consumer in WaitMode::Block (process-shared futex)
+    alignas(CACHELINE_SIZE) ConsumerWakeup wakeup{true};
+};
+
+/**
+ * The engine's tick ring (SpscRing<Tick, 4096>) in a named file under
+ * /dev/shm or a hugetlbfs mount, so capture and the strategy can run as
+ * separate processes and the strategy can crash or be redeployed without
+ * taking capture and its warm state down with it.
+ *
+ * The producer create()s the ring under a temporary name and renames it into
+ * place, so a consumer never maps a half-built one; a file left by a previous
+ * capture is replaced, and consumers still mapping it see its producer gone.
+ * On destruction the producer marks the ring closed and unlinks it.
+ *
+ * A consumer attach()es by claiming consumer_pid with a CAS (taking over from
+ * a dead pid), which keeps the ring single-consumer across processes. The
+ * indices live in the file, so a consumer that reattaches resumes from the
+ * last head its predecessor published; ticks a crashed consumer had popped
+ * but not yet published are delivered again. With no consumer attached the
+ * ring fills and capture drops (or conflates) exactly as for a slow engine.
+ *
+ * push/pop are the in-process SpscRing code on a MAP_SHARED mapping: the
+ * atomics are lock-free and address-free, so the fast path, its fences and
+ * its cache-line traffic are unchanged.
+ */
+class ShmRing : public std::enable_shared_from_this<ShmRing> {
+   public:
+    using Ring = SpscRing<Tick, 4096>;
+
+    // Producer: build a ring at `path`, preferring NUMA `node` (-1 = no policy)
+    static std::shared_ptr<ShmRing> create(const std::string& path, int node,
+        std::string& err);
+
+    // Consumer: map the ring at `path` and claim its consumer side
+    static std::shared_ptr<ShmRing> attach(const std::string& path, std::string& err);
+
+    ~ShmRing();
+
+    ShmRing(const ShmRing&) = delete;
+    ShmRing& operator=(const ShmRing&) = delete;
+
+    // The ring; holding it keeps this mapping (and the consumer claim) alive
+    std::shared_ptr<Ring> ring() {
+        return std::shared_ptr<Ring>(shared_from_this(), ring_);
+    }
+
+    // Hand to PacketCapture::set_wakeup() / TradingEngine::use_wakeup()
+    ConsumerWakeup* wakeup() { return &hdr_->wakeup; }
+
+    const ShmRingHeader& header() const { return *hdr_; }
+    const std::string& path() const { return path_; }
+    size_t page_size() const { return page_; }
+    size_t depth() const { return ring_->size(); }
+
+    // Consumer: false once the producer has closed the ring or died
+    bool producer_alive() const;
+    // Producer: pid of the attached consumer, 0 if none (or it died)
+    pid_t consumer() const;
+
+   private:
+    ShmRing(std::string path, bool producer, void* base, size_t bytes, size_t page);
+
+    std::string path_;
+    bool producer_;
+    void* base_;
+    size_t bytes_;
+    size_t page_;
+    bool owned_{false};  // producer: published the file; consumer: holds the claim
+    ino_t ino_{0};       // producer: the file it created, so it only unlinks its own
+    ShmRingHeader* hdr_;
+    Ring* ring_;
+};
+
+// One line of shared-ring state: consumer pid, attach count and depth
+void print_shm_ring(const ShmRing& r, bool final);
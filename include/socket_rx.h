@@ -0,0 +1,61 @@
+#pragma once
+#include <sys/socket.h>
+#include <functional>
+#include <vector>
+#include "bypass_io.h"
+#include "common.h"
+#include "rx_telemetry.h"
+
+// Open a non-blocking UDP socket bound per "udp:[addr:]port" (any "<prefix>:"
+// is accepted) and apply the sock_* tuning from cfg. Clears timestamps if
+// SO_TIMESTAMPNS could not be enabled. Returns the fd, or -1 on failure.
+int open_udp_socket(const BypassConfig& cfg, bool& timestamps);
+
+// Local port the socket is bound to (host order, 0 on error); payload-only
+// views carry it as their dport
+uint16_t udp_socket_port(int fd);
+
+// SCM_TIMESTAMPNS value carried in msg's control area, in ns (0 = none)
+uint64_t cmsg_rx_timestamp(const msghdr& msg);
+
+// Kernel-socket RX path used as the baseline against netmap. A UDP socket is
+// drained with recvmmsg() into a fixed array of buffers; each datagram is handed
+// to the callback as a payload-only PacketView.
+class SocketRx {
+   public:
+    explicit SocketRx(const BypassConfig& cfg);
+    ~SocketRx();
+
+    SocketRx(const SocketRx&) = delete;
+    SocketRx& operator=(const SocketRx&) = delete;
+
+    // Same contract as BypassIO::rx_batch(); updates the caller's stats and
+    // RX telemetry.
+    int rx_batch(const std::function<bool(const PacketView&)>& cb, Stats& stats,
+        RxTelemetry& tel);
+
+    bool ok() const { return fd_ >= 0; }
+
+   private:
+    // Max datagram we keep; longer ones are truncated (and fail the filter)
+    static constexpr size_t kBufSize = 2048;
+
+    // Room for one SCM_TIMESTAMPNS control message
+    static constexpr size_t kCtrlSize = 64;
+
+    int fd_{-1};
+    uint16_t port_{0};
+    bool busy_poll_{true};
+    bool timestamps_{false};
+    unsigned vlen_{0};
+
+    std::vector<uint8_t> bufs_;
+    std::vector<uint8_t> ctrl_;
+    std::vector<iovec> iov_;
+    std::vector<mmsghdr> msgs_;
+
+    // Datagrams already dequeued from the kernel but not yet handed out
+    // (the callback asked us to stop early)
+    unsigned next_{0};
+    unsigned count_{0};
+};
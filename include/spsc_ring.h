@@ -42,6 +42,17 @@ public:
         return true;
     }
 
+    // Push up to n items with a single tail publish; returns how many fit
+    size_t push_bulk(const T* items, size_t n) {
+        const size_t t = tail_.load(std::memory_order_relaxed);
+        const size_t h = head_.load(std::memory_order_acquire);
+        const size_t room = capacity() - (t - h);
+        if (n > room) n = room;
+        for (size_t i = 0; i < n; ++i) buffer_[(t + i) & mask_] = items[i];
+        if (n) tail_.store(t + n, std::memory_order_release);
+        return n;
+    }
+
     // Try to pop; returns false if empty
     bool pop(T& out) {
         const size_t h = head_.load(std::memory_order_relaxed);
@@ -52,6 +63,22 @@ public:
         return true;
     }
 
+    // Pop up to n items in place with a single head publish. f(const T* p,
+    // size_t k) is called once per contiguous span (twice when the items wrap
+    // past the end of the buffer); returns how many were consumed.
+    template <typename F>
+    size_t pop_bulk(size_t n, F&& f) {
+        const size_t h = head_.load(std::memory_order_relaxed);
+        const size_t t = tail_.load(std::memory_order_acquire);
+        if (n > t - h) n = t - h;
+        if (n == 0) return 0;
+        const size_t first = (h & mask_) + n > N ? N - (h & mask_) : n;
+        f(&buffer_[h & mask_], first);
+        if (first < n) f(&buffer_[0], n - first);
+        head_.store(h + n, std::memory_order_release);
+        return n;
+    }
+
     // Check empty/full
     bool empty() const {
         return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
@@ -64,6 +91,11 @@ public:
         return next == (head_.load(std::memory_order_acquire) & mask_);
     }
 
+    // Approximate number of queued items (exact from either endpoint's thread)
+    size_t size() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
     // Capacity usable (N-1)
     constexpr size_t capacity() const { return N - 1; }
 
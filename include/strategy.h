@@ -0,0 +1,94 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include "common.h"
+#include "instrument_stats.h"
+#include "tick_batch.h"
+
+// Signal counters (engine thread writes, reporter reads, like Stats)
+struct StrategyStats {
+    uint64_t ticks{0};
+    uint64_t batches{0};
+    uint64_t buys{0};         // asks offered below mean - k*sd
+    uint64_t sells{0};        // bids above mean + k*sd
+    uint64_t instruments{0};  // distinct instruments tracked
+    uint64_t untracked{0};    // ticks for instruments beyond capacity
+};
+
+// Totals over engine workers (each owns a disjoint set of instruments)
+inline StrategyStats& operator+=(StrategyStats& a, const StrategyStats& b) {
+    a.ticks += b.ticks;
+    a.batches += b.batches;
+    a.buys += b.buys;
+    a.sells += b.sells;
+    a.instruments += b.instruments;
+    a.untracked += b.untracked;
+    return a;
+}
+
+/**
+ * Mean reversion against each instrument's own rolling fit (InstrumentStats):
+ * an ask more than k standard deviations below the EWMA mean is a buy signal,
+ * a bid as far above it a sell. A tick is judged against the state before it
+ * was folded in, and only once the instrument has `warmup` ticks behind it.
+ *
+ * on_tick() is the per-tick reference. on_batch() updates the statistics in
+ * tick order (same-instrument ticks inside a batch depend on each other), then
+ * evaluates the rule branch-free over TickBatch columns so it vectorizes; the
+ * two must agree.
+ */
+class MeanReversion {
+   public:
+    explicit MeanReversion(size_t instruments = 1 << 17, float k = 2.0f,
+        uint32_t warmup = 32)
+        : inst_(instruments), k_(k), warmup_(warmup) {}
+
+    // Returns true if the tick signalled (a buy on an ask, a sell on a bid)
+    inline bool on_tick(const Tick& t) {
+        float lo, hi;
+        bounds(t, lo, hi);
+        const bool buy = (t.side == 1) & (t.px < lo);
+        const bool sell = (t.side == 0) & (t.px > hi);
+        stats_.buys += buy;
+        stats_.sells += sell;
+        ++stats_.ticks;
+        publish();
+        return buy | sell;
+    }
+
+    void on_batch(const TickBatch& b);
+
+    const StrategyStats& stats() const { return stats_; }
+    const InstrumentStats& instruments() const { return inst_; }
+
+   private:
+    // Update the tick's instrument and return the band it is judged against;
+    // (-inf, +inf) means no signal is possible
+    inline void bounds(const Tick& t, float& lo, float& hi) {
+        InstrumentStats::State before;
+        const uint32_t idx = inst_.update(t, &before);
+        if (idx == InstrumentStats::kNone || before.n < warmup_) {
+            lo = -std::numeric_limits<float>::infinity();
+            hi = std::numeric_limits<float>::infinity();
+            return;
+        }
+        const float band = k_ * InstrumentStats::stddev(before);
+        lo = before.mean - band;
+        hi = before.mean + band;
+    }
+
+    inline void publish() {
+        stats_.instruments = inst_.size();
+        stats_.untracked = inst_.untracked();
+    }
+
+    InstrumentStats inst_;
+    float k_;
+    uint32_t warmup_;
+    StrategyStats stats_;
+};
+
+// Print strategy counters for one interval (now - prev); final=true prints
+// the whole run
+void print_strategy(const StrategyStats& now, const StrategyStats& prev, bool final);
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "common.h"
+
+/**
+ * Columnar (struct-of-arrays) block of up to kMax ticks, each column on its
+ * own cache lines. Strategy kernels loop over one column at a time with unit
+ * stride, which the compiler turns into full-width SIMD (-march=native), where
+ * the 24-byte Tick would need gathers or per-lane shuffles.
+ */
+struct alignas(64) TickBatch {
+    static constexpr size_t kMax = 64;
+
+    alignas(64) uint64_t ts[kMax];
+    alignas(64) uint32_t instr_id[kMax];
+    alignas(64) float px[kMax];
+    alignas(64) float qty[kMax];
+    alignas(64) uint8_t side[kMax];
+    uint8_t instr_type[kMax];
+    size_t n{0};
+
+    inline void set(size_t i, const Tick& t) {
+        ts[i] = t.ts_ns;
+        instr_id[i] = t.instr_id;
+        px[i] = t.px;
+        qty[i] = t.qty;
+        side[i] = t.side;
+        instr_type[i] = t.instr_type;
+    }
+
+    // Transpose k contiguous ticks into columns [at, at + k)
+    inline void load(size_t at, const Tick* __restrict t, size_t k) {
+        for (size_t i = 0; i < k; ++i) ts[at + i] = t[i].ts_ns;
+        for (size_t i = 0; i < k; ++i) instr_id[at + i] = t[i].instr_id;
+        for (size_t i = 0; i < k; ++i) px[at + i] = t[i].px;
+        for (size_t i = 0; i < k; ++i) qty[at + i] = t[i].qty;
+        for (size_t i = 0; i < k; ++i) side[at + i] = t[i].side;
+        for (size_t i = 0; i < k; ++i) instr_type[at + i] = t[i].instr_type;
+    }
+
+    // Transpose up to kMax ticks out of `ring` with a single head publish;
+    // returns the batch size (0 = ring empty)
+    template <typename Ring>
+    size_t fill(Ring& ring) {
+        size_t at = 0;
+        n = ring.pop_bulk(kMax, [&](const Tick* t, size_t k) {
+            load(at, t, k);
+            at += k;
+        });
+        return n;
+    }
+};
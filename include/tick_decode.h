@@ -0,0 +1,215 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "common.h"
+#if defined(__SSSE3__)
+#include <immintrin.h>
+#endif
+
+// Payload decode helpers shared by the capture thread and the microbenchmarks.
+// Header-only so they inline into the per-packet callback.
+
+/**
+ * @brief Locate the UDP payload of an Ethernet/IPv4/UDP frame, any length.
+ *
+ * @param p pointer to the start of the Ethernet frame
+ * @param len length of p
+ * @param out output pointer to the start of the UDP payload
+ * @param paylen output payload length (from the UDP header, bounds-checked)
+ * @param dport output UDP destination port
+ * @return true if the frame is IPv4/UDP and the payload lies within it
+ */
+inline bool locate_udp_payload(const uint8_t* p, uint16_t len, const uint8_t*& out,
+    uint16_t& paylen, uint16_t& dport) {
+    if (!p || len < 14 + 20 + 8) return false;
+    const uint16_t etype = (uint16_t(p[12]) << 8) | uint16_t(p[13]);
+    if (etype != 0x0800) return false;
+
+    const uint8_t* ip = p + 14;
+    const uint8_t ihl = (ip[0] & 0x0F) * 4;
+    if (ihl < 20 || len < 14 + ihl + 8) return false;
+    if (ip[9] != 17) return false;
+
+    const uint8_t* udp = ip + ihl;
+    const uint16_t ulen = (uint16_t(udp[4]) << 8) | uint16_t(udp[5]);
+    if (ulen < 8) return false;
+    const uint8_t* payload = udp + 8;
+    if (payload + (ulen - 8) > p + len) return false;
+
+    out = payload;
+    paylen = ulen - 8;
+    dport = (uint16_t(udp[2]) << 8) | uint16_t(udp[3]);
+    return true;
+}
+
+/**
+ * @brief UDP payload, length and destination port of any PacketView.
+ *
+ * Payload-only views (socket backends) already are the payload; frame views
+ * go through locate_udp_payload().
+ *
+ * @return false if a frame view is not a well-formed IPv4/UDP frame
+ */
+inline bool view_payload(const PacketView& v, const uint8_t*& out, uint16_t& paylen,
+    uint16_t& dport) {
+    if (v.payload_only) {
+        out = v.data;
+        paylen = v.len;
+        dport = v.dport;
+        return v.data != nullptr;
+    }
+    return locate_udp_payload(v.data, v.len, out, paylen, dport);
+}
+
+/**
+ * @brief Locate UDP payload of exactly 14 bytes in a raw Ethernet frame.
+ *
+ * Assumes Ethernet + IPv4 + UDP. Validates lengths and boundaries.
+ *
+ * @param p pointer to the start of the Ethernet frame
+ * @param len length of p
+ * @param out output pointer to the start of the UDP payload (if found)
+ * @return true if found and out is set
+ * @return false if not found or invalid
+ */
+inline bool locate_udp_payload_14(const uint8_t* p, uint16_t len, const uint8_t*& out) {
+    const uint8_t* payload = nullptr;
+    uint16_t paylen = 0, dport = 0;
+    if (!locate_udp_payload(p, len, payload, paylen, dport)) return false;
+    if (paylen != 14) return false;
+    out = payload;
+    return true;
+}
+
+/**
+ * @brief Decode a Tick from a 14-byte UDP payload.
+ *
+ * @param payload pointer to the start of the UDP payload (14 bytes readable)
+ * @param tsc timestamp to set in the Tick
+ * @param out output Tick to populate
+ */
+inline void decode_tick_from_payload(const uint8_t* payload, uint64_t tsc, Tick& out) {
+    uint32_t instr_id = 0;
+    uint8_t instr_type = 0;
+    uint8_t side = 0;
+    float px = 0.f, qty = 0.f;
+
+    // We assume little-endian host; memcpy to avoid alignment issues
+    std::memcpy(&instr_id, payload + 0, 4);
+    std::memcpy(&instr_type, payload + 4, 1);
+    std::memcpy(&side, payload + 5, 1);
+    std::memcpy(&px, payload + 6, 4);
+    std::memcpy(&qty, payload + 10, 4);
+    out.ts_ns = tsc;
+    out.instr_id = instr_id;
+    out.instr_type = instr_type;
+    out.side = side;
+    out.px = px;
+    out.qty = qty;
+}
+
+/**
+ * @brief Decode a Tick from a UDP payload of exactly 14 bytes.
+ *
+ * Expects the payload to be located and validated by locate_udp_payload_14().
+ *
+ * @param p pointer to the start of the Ethernet frame
+ * @param len length of p
+ * @param tsc timestamp to set in the Tick
+ * @param out output Tick to populate
+ * @return true if successful
+ * @return false if not successful (e.g., payload not found)
+ */
+inline bool decode_tick_from_packet(const uint8_t* p, uint16_t len, uint64_t tsc,
+    Tick& out) {
+    const uint8_t* payload = nullptr;
+
+    // If it's not a valid UDP payload of 14 bytes, return false
+    if (!locate_udp_payload_14(p, len, payload)) return false;
+
+    decode_tick_from_payload(payload, tsc, out);
+    return true;
+}
+
+/**
+ * @brief Decode a Tick from either a full frame or a payload-only view.
+ *
+ * @param v packet view from any backend
+ * @param out output Tick to populate
+ * @return true if a Tick was decoded
+ */
+inline bool decode_tick(const PacketView& v, Tick& out) {
+    if (v.payload_only) {
+        if (!v.data || v.len != 14) return false;
+        decode_tick_from_payload(v.data, v.tsc, out);
+        return true;
+    }
+    return decode_tick_from_packet(v.data, v.len, v.tsc, out);
+}
+
+// Packed datagrams: an 8-byte little-endian header followed by `count`
+// back-to-back 14-byte records in the decode_tick_from_payload() layout
+struct PackedHeader {
+    uint32_t seq;      // datagram sequence number on this channel
+    uint16_t channel;  // feed channel
+    uint16_t count;    // records that follow
+};
+static_assert(sizeof(PackedHeader) == 8, "packed header is 8 bytes on the wire");
+
+constexpr uint16_t kRecordSize = 14;
+
+/**
+ * @brief Decode n back-to-back 14-byte records, one at a time.
+ *
+ * Records with side > 1 are skipped.
+ *
+ * @return number of Ticks written to out
+ */
+inline size_t decode_records_scalar(const uint8_t* p, size_t n, uint64_t tsc, Tick* out) {
+    size_t k = 0;
+    for (size_t i = 0; i < n; ++i) {
+        decode_tick_from_payload(p + i * kRecordSize, tsc, out[k]);
+        k += out[k].side <= 1;
+    }
+    return k;
+}
+
+/**
+ * @brief Decode n back-to-back 14-byte records into Ticks with SSSE3.
+ *
+ * A record is the Tick's bytes 8..23 without the two padding bytes, so one
+ * unaligned 16-byte load, one pshufb and one store rebuild it. Bad records
+ * (side > 1) are dropped by advancing the output index only for good ones,
+ * which keeps the loop branch-free. The last record is done scalar because its
+ * 16-byte load would read 2 bytes past the payload. Falls back to
+ * decode_records_scalar() without SSSE3.
+ *
+ * @param p   first record
+ * @param n   record count (p must hold n * 14 bytes)
+ * @param tsc timestamp for every Tick
+ * @param out room for n Ticks
+ * @return number of Ticks written to out
+ */
+inline size_t decode_records(const uint8_t* p, size_t n, uint64_t tsc, Tick* out) {
+#if defined(__SSSE3__)
+    static_assert(sizeof(Tick) == 24 && offsetof(Tick, instr_id) == 8 &&
+                      offsetof(Tick, px) == 16 && offsetof(Tick, qty) == 20,
+        "shuffle below assumes this Tick layout");
+    if (n == 0) return 0;
+    // Tick bytes 8..23 <- record bytes 0..5, two zero pad bytes, 6..13
+    const __m128i shuf =
+        _mm_setr_epi8(0, 1, 2, 3, 4, 5, -1, -1, 6, 7, 8, 9, 10, 11, 12, 13);
+    size_t k = 0;
+    for (size_t i = 0; i + 1 < n; ++i) {
+        const __m128i rec = _mm_loadu_si128((const __m128i*)(p + i * kRecordSize));
+        uint8_t* t = (uint8_t*)&out[k];
+        std::memcpy(t, &tsc, 8);
+        _mm_storeu_si128((__m128i*)(t + 8), _mm_shuffle_epi8(rec, shuf));
+        k += (_mm_extract_epi16(rec, 2) >> 8) <= 1;  // side byte; pextrb is SSE4.1
+    }
+    return k + decode_records_scalar(p + (n - 1) * kRecordSize, 1, tsc, out + k);
+#else
+    return decode_records_scalar(p, n, tsc, out);
+#endif
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "common.h"
+
+// Engine worker that owns an instrument: a Fibonacci hash of the id, mapped
+// onto [0, shards) with a multiply-shift rather than a modulo
+inline uint32_t shard_of(uint32_t instr_id, uint32_t shards) {
+    return (uint32_t)(((uint64_t)(instr_id * 0x9E3779B9u) * shards) >> 32);
+}
+
+// Per-shard dispatch counters (capture thread writes, reporter reads, like Stats)
+struct ShardStats {
+    uint64_t ticks{0};  // pushed to this shard's ring
+    uint64_t drops{0};  // did not fit (and no conflation table took them)
+};
+
+/**
+ * Splits one decoder emit (a datagram's ticks) into per-shard runs for
+ * PacketCapture's dispatch stage. A stable counting sort into a scratch array
+ * keeps arrival order within each shard, so every instrument's ticks reach
+ * its worker in order, and each shard still gets one push_bulk() (one tail
+ * publish) per datagram. Single-tick datagrams skip the sort.
+ */
+class ShardSplitter {
+   public:
+    static constexpr uint32_t kMaxShards = 64;
+    static constexpr size_t kChunk = 64;  // DecoderRegistry::kBatch
+
+    explicit ShardSplitter(uint32_t shards) : shards_(shards) {}
+
+    uint32_t shards() const { return shards_; }
+
+    // f(shard, const Tick*, n) once per shard with ticks, in shard order
+    template <typename F>
+    inline void split(const Tick* t, size_t n, F&& f) {
+        if (n == 1) {
+            f(shard_of(t[0].instr_id, shards_), t, 1);
+            return;
+        }
+        for (; n > kChunk; t += kChunk, n -= kChunk) split_chunk(t, kChunk, f);
+        if (n) split_chunk(t, n, f);
+    }
+
+   private:
+    template <typename F>
+    inline void split_chunk(const Tick* t, size_t n, F& f) {
+        uint8_t shard[kChunk];
+        uint32_t start[kMaxShards + 1];
+        for (uint32_t s = 0; s <= shards_; ++s) start[s] = 0;
+        for (size_t i = 0; i < n; ++i) {
+            shard[i] = (uint8_t)shard_of(t[i].instr_id, shards_);
+            ++start[shard[i] + 1];
+        }
+        for (uint32_t s = 0; s < shards_; ++s) start[s + 1] += start[s];
+        uint32_t at[kMaxShards];
+        for (uint32_t s = 0; s < shards_; ++s) at[s] = start[s];
+        for (size_t i = 0; i < n; ++i) scratch_[at[shard[i]]++] = t[i];
+        for (uint32_t s = 0; s < shards_; ++s) {
+            const uint32_t k = start[s + 1] - start[s];
+            if (k) f(s, scratch_ + start[s], (size_t)k);
+        }
+    }
+
+    uint32_t shards_;
+    Tick scratch_[kChunk];
+};
+
+// Per-shard ticks and drops for the interval, current ring depths, and the
+// imbalance (busiest shard's ticks over the mean; 1.00 = even)
+void print_shards(const ShardStats* now, const ShardStats* prev, const size_t* depth,
+    size_t shards, bool final);
@@ -1,33 +1,109 @@
 #pragma once
 #include <atomic>
+#include <functional>
 #include <memory>
 #include <thread>
 
+#include "alloc_audit.h"
 #include "common.h"
+#include "flight_recorder.h"
+#include "jitter_monitor.h"
+#include "perf_counters.h"
 #include "spsc_ring.h"
+#include "tick_batch.h"
+#include "wait_strategy.h"
 
 class TradingEngine {
 public:
     using Ring = SpscRing<Tick, 4096>;
+    using BatchHandler = std::function<void(const TickBatch&)>;
 
-    explicit TradingEngine(std::shared_ptr<Ring> ring);
+    // `name` tags this worker's jitter, perf and allocation-audit reports (a
+    // string literal or otherwise outliving the engine)
+    explicit TradingEngine(std::shared_ptr<Ring> ring, const char* name = "eng");
     ~TradingEngine();
 
     TradingEngine(const TradingEngine&) = delete;
     TradingEngine& operator=(const TradingEngine&) = delete;
 
-    void start();
+    // Launch the consumer thread, optionally pinned (-1 = no pin) and with a
+    // SCHED_FIFO priority (0 = SCHED_OTHER)
+    void start(int cpu_affinity = -1, int rt_priority = 0);
     void stop();
 
-    void run_once();
+    // Hand ticks to `h` as columnar batches instead of printing them one by
+    // one (call before start())
+    void set_batch_handler(BatchHandler h) { batch_handler_ = std::move(h); }
+
+    // What to do when the ring is empty; `budget` is the number of empty polls
+    // to spin through before yielding or parking (call before start()). For
+    // Block, hand wakeup() to the producer (PacketCapture::set_wakeup()).
+    void set_wait(WaitMode mode, uint32_t budget) {
+        wait_mode_ = mode;
+        wait_budget_ = budget;
+    }
+    WaitMode wait_mode() const { return wait_mode_; }
+    ConsumerWakeup* wakeup() { return wakeup_; }
+
+    // Park on `w` instead of the engine's own eventcount, e.g. the one in a
+    // ShmRing header when the producer is another process (call before start())
+    void use_wakeup(ConsumerWakeup* w) { wakeup_ = w; }
+
+    // Drain the ring once; returns the number of ticks processed
+    size_t run_once();
+    // Same, in TickBatch blocks of up to TickBatch::kMax through the handler
+    size_t run_batch();
     void run_loop();
 
+    // Hardware counters around each non-empty run_once() (make PERF=1, USPF_PERF=1)
+    PerfTotals perf() const { return perf_.totals(); }
+
+    // Loop-gap histogram and stall log of the engine thread
+    JitterMonitor& jitter() { return jitter_; }
+
+    // Last drains of the engine thread (flight_recorder_init())
+    const FlightRecorder& flight_recorder() const { return fdr_; }
+
+    // Pop latency and park/wake counts (racy snapshot), and the engine
+    // thread's CPU time so far (total once the thread has exited)
+    WaitStats wait_stats() const;
+    uint64_t cpu_ns() const;
+
 private:
-    void thread_main();
+    void thread_main(int cpu_affinity, int rt_priority);
+    void idle(uint32_t& empty_polls);
+
+    // Age of the first tick of a drain, RX TSC to now; returns now
+    inline uint64_t note_pop(uint64_t rx_tsc) {
+        const uint64_t now = rdtsc();
+        if (now >= rx_tsc) wait_stats_.pop_latency.add(now - rx_tsc);
+        return now;
+    }
+
+    // Same tick, once the drain has been handled, which is also when the
+    // flight recorder takes the drain
+    inline void note_done(const Tick& first, uint64_t pop_tsc, size_t n) {
+        const uint64_t now = rdtsc();
+        if (now >= first.ts_ns) wait_stats_.decide_latency.add(now - first.ts_ns);
+        if (fdr_.on()) fdr_.drain(first, pop_tsc, now, n, (uint32_t)ring_->size());
+    }
 
     std::shared_ptr<Ring> ring_;
+    const char*           name_;
+    BatchHandler          batch_handler_;
+    TickBatch             batch_;
     std::atomic<bool>     running_{false};
     std::thread           worker_;
+    PerfCounters          perf_;
+    JitterMonitor         jitter_;
+    AllocAuditGate        audit_;
+    FlightRecorder        fdr_;
+    WaitMode              wait_mode_{WaitMode::Yield};
+    uint32_t              wait_budget_{2000};
+    ConsumerWakeup        own_wakeup_;
+    ConsumerWakeup*       wakeup_{&own_wakeup_};
+    WaitStats             wait_stats_;
+    uint64_t              exit_cpu_ns_{0};
 };
 
 inline void engine_yield() {
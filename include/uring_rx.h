@@ -0,0 +1,87 @@
+#pragma once
+#include <sys/socket.h>
+#include <functional>
+#include <vector>
+#include "bypass_io.h"
+#include "common.h"
+#include "rx_telemetry.h"
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+struct io_uring_buf_ring;
+
+// io_uring RX path for hosts without netmap. One multishot RECVMSG stays armed
+// on the UDP socket and the kernel picks buffers from a registered provided-
+// buffer ring, so the steady state needs no syscalls at all with SQPOLL (and
+// none per datagram without it). Completions are drained in bursts as payload-
+// only PacketViews; their buffers go back to the ring once the batch is done.
+class UringRx {
+   public:
+    explicit UringRx(const BypassConfig& cfg);
+    ~UringRx();
+
+    UringRx(const UringRx&) = delete;
+    UringRx& operator=(const UringRx&) = delete;
+
+    // Same contract as BypassIO::rx_batch(); updates the caller's stats and
+    // RX telemetry.
+    int rx_batch(const std::function<bool(const PacketView&)>& cb, Stats& stats,
+        RxTelemetry& tel);
+
+    bool ok() const { return ok_; }
+
+    // Completions posted by the kernel and not yet reaped
+    unsigned backlog() const;
+    unsigned cq_size() const { return cq_mask_ ? *cq_mask_ + 1 : 0; }
+
+   private:
+    bool setup_ring(const BypassConfig& cfg);
+    bool setup_buffers();
+    bool arm();
+    int enter(unsigned to_submit, unsigned min_complete, unsigned flags);
+    void recycle(uint16_t bid);
+    void publish_recycled();
+
+    static constexpr size_t kBufSize = 2048;
+    static constexpr uint16_t kBufGroup = 0;
+
+    bool ok_{false};
+    bool busy_poll_{true};
+    bool sqpoll_{false};
+    bool timestamps_{false};
+    bool armed_{false};
+    unsigned burst_{0};
+
+    int sock_{-1};
+    uint16_t port_{0};
+    int ring_fd_{-1};
+
+    // SQ/CQ ring mappings (single mmap when IORING_FEAT_SINGLE_MMAP)
+    void* sq_map_{nullptr};
+    size_t sq_map_len_{0};
+    void* cq_map_{nullptr};
+    size_t cq_map_len_{0};
+    io_uring_sqe* sqes_{nullptr};
+    size_t sqes_len_{0};
+
+    unsigned* sq_head_{nullptr};
+    unsigned* sq_tail_{nullptr};
+    unsigned* sq_mask_{nullptr};
+    unsigned* sq_flags_{nullptr};
+    unsigned* sq_array_{nullptr};
+    unsigned* cq_head_{nullptr};
+    unsigned* cq_tail_{nullptr};
+    unsigned* cq_mask_{nullptr};
+    io_uring_cqe* cqes_{nullptr};
+
+    // Provided buffer ring + the buffers it hands to the kernel
+    io_uring_buf_ring* br_{nullptr};
+    size_t br_len_{0};
+    unsigned nbufs_{0};
+    uint16_t br_tail_{0};
+    uint8_t* bufs_{nullptr};
+    size_t bufs_len_{0};
+
+    // Template msghdr for the multishot recvmsg (only lengths are read)
+    msghdr msg_{};
+};
@@ -0,0 +1,87 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include "histogram.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// What the engine does when a drain finds the tick ring empty
+enum class WaitMode : uint8_t {
+    Yield,      // sched_yield() after every drain (the original loop)
+    Spin,       // _mm_pause() and poll again: lowest latency, 100% of a core
+    SpinYield,  // pause for a budget of empty polls, then sched_yield()
+    Block,      // pause for the budget, then sleep on a futex until the
+                // producer pushes (it only signals while the engine is parked)
+};
+
+const char* wait_mode_name(WaitMode m);
+
+// Parse "yield", "spin", "spinyield[:budget]" or "block[:budget]"; budget is
+// in empty polls and is left untouched when not given
+bool parse_wait_mode(const char* s, WaitMode& mode, uint32_t& budget);
+
+inline void cpu_pause() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#endif
+}
+
+// Wait counters (engine thread writes, reporter reads, like Stats)
+struct WaitStats {
+    // TSC ticks from RX of a drain's first tick to its pop, and to the end of
+    // the drain (strategy done; compare InlineStats::decide_latency)
+    Log2Histogram pop_latency;
+    Log2Histogram decide_latency;
+    uint64_t parks{0};          // futex sleeps (Block)
+    uint64_t wakeups{0};        // futex wakes issued by the producer (Block)
+};
+
+/**
+ * Producer -> consumer wakeup for WaitMode::Block, an eventcount on a futex
+ * word. The consumer announces it is about to sleep (prepare), re-checks the
+ * ring, then sleeps on the sequence it read. After publishing, the producer
+ * signals only if someone announced, so while the engine keeps up the
+ * producer's cost is one fence and one load per loop iteration that pushed.
+ * A futex is enough, no eventfd needed; a `shared` one lives in a MAP_SHARED
+ * mapping (ShmRingHeader) and uses process-shared futex ops.
+ */
+class ConsumerWakeup {
+   public:
+    explicit ConsumerWakeup(bool shared = false) : shared_(shared) {}
+
+    // Producer, after publishing to the ring
+    inline void notify() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (parked_.load(std::memory_order_relaxed) &&
+            parked_.exchange(0, std::memory_order_acq_rel)) {
+            seq_.fetch_add(1, std::memory_order_release);
+            wake();
+        }
+    }
+
+    // Consumer: announce; returns the sequence to pass to wait()
+    inline uint32_t prepare() {
+        parked_.store(1, std::memory_order_seq_cst);
+        return seq_.load(std::memory_order_acquire);
+    }
+    inline void cancel() { parked_.store(0, std::memory_order_relaxed); }
+
+    // Consumer: sleep until notify() or `timeout_ns`; returns true if woken
+    bool wait(uint32_t key, uint64_t timeout_ns);
+
+    uint64_t wakeups() const { return wakeups_.load(std::memory_order_relaxed); }
+
+   private:
+    void wake();
+
+    std::atomic<uint32_t> seq_{0};  // futex word
+    std::atomic<uint32_t> parked_{0};
+    std::atomic<uint64_t> wakeups_{0};
+    const bool shared_;
+};
+
+// Print pop-latency percentiles, parks and the engine's CPU use for one
+// interval; `cpu_ns`/`wall_ns` are the interval's thread CPU and wall time
+void print_wait(WaitMode mode, const WaitStats& now, const WaitStats& prev,
+    uint64_t cpu_ns, uint64_t wall_ns, bool final);
@@ -0,0 +1,85 @@
+#pragma once
+#include <functional>
+#include <vector>
+#include "bypass_io.h"
+#include "common.h"
+#include "rx_telemetry.h"
+
+// AF_XDP (XSK) path: netmap-like kernel bypass using only in-tree kernel code.
+// A UMEM of fixed-size frames is shared with the kernel through four rings
+// (fill/completion for buffer ownership, RX/TX for packets), and a tiny XDP
+// program redirects the bound queue into our socket. RX descriptors are full
+// Ethernet frames and map onto PacketView exactly like netmap slots.
+class XdpIo {
+   public:
+    explicit XdpIo(const BypassConfig& cfg);
+    ~XdpIo();
+
+    XdpIo(const XdpIo&) = delete;
+    XdpIo& operator=(const XdpIo&) = delete;
+
+    // Same contract as BypassIO::rx_batch(); updates the caller's stats and
+    // RX telemetry.
+    int rx_batch(const std::function<bool(const PacketView&)>& cb, Stats& stats,
+        RxTelemetry& tel);
+
+    // Copy one frame into a free TX frame and queue it; returns len or -1.
+    int tx(const uint8_t* data, uint16_t len);
+
+    bool ok() const { return ok_; }
+
+    // RX descriptors produced by the kernel and not yet consumed
+    uint32_t backlog() const;
+    uint32_t rx_ring_size() const { return ring_size_; }
+    bool zerocopy() const { return zerocopy_; }
+
+   private:
+    // Producer/consumer view of one of the four mmap'ed rings
+    struct Ring {
+        uint32_t* producer{nullptr};
+        uint32_t* consumer{nullptr};
+        uint32_t* flags{nullptr};
+        void* desc{nullptr};
+        uint32_t mask{0};
+        void* map{nullptr};
+        size_t map_len{0};
+    };
+
+    bool setup_umem();
+    bool setup_rings();
+    bool bind_socket(const BypassConfig& cfg);
+    bool load_program(const BypassConfig& cfg);
+    bool map_ring(Ring& r, uint64_t pgoff, size_t desc_size, uint32_t entries,
+        const void* off);
+    void refill(const uint64_t* addrs, uint32_t n);
+    void reclaim_tx();
+
+    static constexpr uint32_t kFrameSize = 2048;
+
+    bool ok_{false};
+    bool busy_poll_{true};
+    bool native_{false};  // program attached in driver mode (else generic/SKB)
+    bool zerocopy_{false};
+    unsigned burst_{0};
+    uint32_t prefetch_{0};  // RX lookahead in packets (BypassConfig::prefetch)
+    uint32_t nframes_{0};
+    uint32_t ring_size_{0};
+
+    int ifindex_{0};
+    uint32_t queue_{0};
+    int xsk_{-1};
+    int map_fd_{-1};
+    int prog_fd_{-1};
+    int link_fd_{-1};
+
+    uint8_t* umem_{nullptr};
+    size_t umem_len_{0};
+
+    Ring rx_, tx_, fill_, comp_;
+
+    // Frames owned by user space and free for TX
+    std::vector<uint64_t> tx_free_;
+
+    // Frame addresses consumed this batch, returned to the fill ring at its end
+    std::vector<uint64_t> recycled_;
+};
@@ -0,0 +1,166 @@
+#include "alloc_audit.h"
+
+#ifndef USPF_ALLOC_AUDIT
+
+uint64_t alloc_audit_report() {
+    return 0;
+}
+
+#else
+
+#ifndef __GLIBC__
+#error "ALLOC_AUDIT interposes malloc through glibc's __libc_* entry points"
+#endif
+
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <execinfo.h>
+#include <malloc.h>
+#include <unistd.h>
+
+extern "C" {
+void* __libc_malloc(size_t);
+void* __libc_calloc(size_t, size_t);
+void* __libc_realloc(void*, size_t);
+void* __libc_memalign(size_t, size_t);
+}
+
+namespace {
+
+constexpr int kMaxThreads = 16;
+constexpr unsigned kTracesPerThread = 8;
+
+struct ThreadSlot {
+    std::atomic<bool> used{false};
+    const char* name{nullptr};
+    std::atomic<bool> armed{false};
+    std::atomic<uint64_t> allocs{0};  // after warmup
+    std::atomic<uint64_t> bytes{0};
+};
+
+ThreadSlot g_slots[kMaxThreads];
+bool g_abort = false;
+
+thread_local ThreadSlot* t_slot = nullptr;
+thread_local bool t_armed = false;
+thread_local bool t_in_hook = false;
+thread_local unsigned t_traces = 0;
+
+void write_str(const char* s) {
+    ssize_t r = ::write(STDERR_FILENO, s, std::strlen(s));
+    (void)r;
+}
+
+// Runs inside malloc: no allocation, no stdio; backtrace() was primed in arm()
+void on_alloc(size_t n) {
+    if (__builtin_expect(!t_armed, 1) || t_in_hook) return;
+    t_in_hook = true;
+    t_slot->allocs.fetch_add(1, std::memory_order_relaxed);
+    t_slot->bytes.fetch_add(n, std::memory_order_relaxed);
+    if (t_traces < kTracesPerThread || g_abort) {
+        ++t_traces;
+        char msg[128];
+        std::snprintf(msg, sizeof(msg), "alloc-audit[%s]: %zu-byte allocation after warmup\n",
+            t_slot->name, n);
+        write_str(msg);
+        void* frames[32];
+        const int depth = backtrace(frames, 32);
+        backtrace_symbols_fd(frames, depth, STDERR_FILENO);
+        if (g_abort) std::abort();
+    }
+    t_in_hook = false;
+}
+
+}  // namespace
+
+extern "C" {
+
+void* malloc(size_t n) {
+    on_alloc(n);
+    return __libc_malloc(n);
+}
+
+void* calloc(size_t c, size_t n) {
+    on_alloc(c * n);
+    return __libc_calloc(c, n);
+}
+
+void* realloc(void* p, size_t n) {
+    on_alloc(n);
+    return __libc_realloc(p, n);
+}
+
+void* memalign(size_t align, size_t n) {
+    on_alloc(n);
+    return __libc_memalign(align, n);
+}
+
+void* aligned_alloc(size_t align, size_t n) {
+    on_alloc(n);
+    return __libc_memalign(align, n);
+}
+
+int posix_memalign(void** out, size_t align, size_t n) {
+    on_alloc(n);
+    void* p = __libc_memalign(align, n);
+    if (!p) return ENOMEM;
+    *out = p;
+    return 0;
+}
+
+}  // extern "C"
+
+void AllocAuditGate::begin(const char* name) {
+    for (ThreadSlot& s : g_slots) {
+        bool expected = false;
+        if (!s.used.compare_exchange_strong(expected, true)) continue;
+        s.name = name;
+        t_slot = &s;
+        break;
+    }
+    if (!t_slot) return;  // out of slots: this thread stays unaudited
+
+    const char* ms = std::getenv("USPF_ALLOC_WARMUP_MS");
+    const double warmup_ns = (ms ? std::atof(ms) : 2000.0) * 1e6;
+    const char* mode = std::getenv("USPF_ALLOC_AUDIT");
+    g_abort = mode && !std::strcmp(mode, "abort");
+    arm_at_ = rdtsc() + (uint64_t)(warmup_ns / tsc_ns_per_tick());
+    armed_ = false;
+}
+
+void AllocAuditGate::arm() {
+    armed_ = true;
+    // The first backtrace() loads libgcc's unwinder, which allocates
+    void* frames[4];
+    backtrace(frames, 4);
+    t_slot->armed.store(true, std::memory_order_relaxed);
+    t_armed = true;
+}
+
+void AllocAuditGate::end() {
+    t_armed = false;
+}
+
+/**
+ * @brief Print each audited thread's post-warmup allocation count.
+ *
+ * @return total allocations by audited threads after their warmup; non-zero
+ *         means a hot path allocates
+ */
+uint64_t alloc_audit_report() {
+    uint64_t total = 0;
+    for (const ThreadSlot& s : g_slots) {
+        if (!s.used.load()) continue;
+        const uint64_t n = s.allocs.load();
+        total += n;
+        std::printf("alloc-audit[%s]: %s, %llu allocations (%llu bytes) after warmup\n",
+            s.name, s.armed.load() ? "armed" : "never armed (warmup longer than run)",
+            (unsigned long long)n, (unsigned long long)s.bytes.load());
+    }
+    return total;
+}
+
+#endif
@@ -1,3 +1,4 @@
+#include "benchmarks.h"
 #include "bypass_io.h"
 #include "common.h"
 #include "packet_capture.h"
@@ -27,12 +28,17 @@ int run_rx_benchmark(BypassConfig cfg, int seconds) {
             uint64_t dbytes = s.bytes - last_bytes;
             double pps = (double)dpkts;
             double bps = (double)dbytes * 8.0;
-            std::printf("RX: %.0f pps  %.3f Gbps  drops=%llu  batches=%llu\n",
-                        pps, bps/1e9, (unsigned long long)s.drops, (unsigned long long)s.batches);
+            std::printf("RX[%s]: %.0f pps  %.3f Gbps  drops=%llu  batches=%llu\n",
+                        backend_name(io.backend()), pps, bps/1e9,
+                        (unsigned long long)s.drops, (unsigned long long)s.batches);
             last_pkts = s.pkts; last_bytes = s.bytes; last = now;
             if (--seconds == 0) break;
         }
     }
+
+    // Whole-run ring occupancy / batch-size summary
+    static RxTelemetry none;
+    print_rx_telemetry(io.telemetry(), none, true);
     return 0;
 }
 
@@ -4,10 +4,14 @@
 #include <chrono>
 #include <cstring>
 #include <iostream>
+#include <memory>
 #include <stdexcept>
 #include <thread>
 #include "common.h"
+#include "socket_rx.h"
 #include "spsc_ring.h"
+#include "uring_rx.h"
+#include "xdp_io.h"
 
 #ifdef USE_NETMAP
 #ifndef NETMAP_WITH_LIBS
@@ -34,7 +38,63 @@ void pin_thread_to_core(int core) {
 #endif
 }
 
+IoBackend backend_of(const std::string& ifname) {
+    if (ifname.rfind("udp:", 0) == 0) return IoBackend::Socket;
+    if (ifname.rfind("uring:", 0) == 0) return IoBackend::IoUring;
+    if (ifname.rfind("xdp:", 0) == 0) return IoBackend::Xdp;
+    return IoBackend::Netmap;
+}
+
+const char* backend_name(IoBackend b) {
+    switch (b) {
+        case IoBackend::Netmap:
+            return "netmap";
+        case IoBackend::Socket:
+            return "socket";
+        case IoBackend::IoUring:
+            return "io_uring";
+        case IoBackend::Xdp:
+            return "af_xdp";
+    }
+    return "unknown";
+}
+
+double tsc_ns_per_tick() {
+    static const double ns_per_tick = [] {
+        const auto t0 = std::chrono::steady_clock::now();
+        const uint64_t c0 = rdtsc();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        const uint64_t c1 = rdtsc();
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - t0)
+                            .count();
+        return c1 > c0 ? (double)ns / (double)(c1 - c0) : 0.0;
+    }();
+    return ns_per_tick;
+}
+
+std::string device_of(const std::string& ifname) {
+    std::string dev;
+    if (ifname.rfind("netmap:", 0) == 0)
+        dev = ifname.substr(7);
+    else if (ifname.rfind("xdp:", 0) == 0)
+        dev = ifname.substr(4);
+    else
+        return "";
+    const size_t cut = dev.find_first_of("-*^{}/@");
+    return cut == std::string::npos ? dev : dev.substr(0, cut);
+}
+
 struct BypassIO::Impl {
+    // Kernel socket backend (recvmmsg)
+    std::unique_ptr<SocketRx> sock;
+
+    // io_uring backend (multishot recvmsg + provided buffers)
+    std::unique_ptr<UringRx> uring;
+
+    // AF_XDP backend (UMEM + fill/completion/RX/TX rings)
+    std::unique_ptr<XdpIo> xdp;
+
 #ifdef USE_NETMAP
     // Netmap descriptor
     nm_desc* nmd{nullptr};
@@ -52,7 +112,29 @@ struct BypassIO::Impl {
     int vnet_len{0};
 };
 
-BypassIO::BypassIO(const BypassConfig& cfg) : cfg_(cfg), impl_(new Impl) {
+BypassIO::BypassIO(const BypassConfig& cfg)
+    : cfg_(cfg), backend_(backend_of(cfg.ifname)), impl_(new Impl) {
+    // The kernel-socket style backends expose a single queue
+    telemetry_.nrings = 1;
+    if (backend_ == IoBackend::Socket) {
+        impl_->sock = std::make_unique<SocketRx>(cfg_);
+        ok_ = impl_->sock->ok();
+        telemetry_.ring[0].ring_size = cfg_.burst > 0 ? (uint32_t)cfg_.burst : 1;
+        return;
+    }
+    if (backend_ == IoBackend::IoUring) {
+        impl_->uring = std::make_unique<UringRx>(cfg_);
+        ok_ = impl_->uring->ok();
+        telemetry_.ring[0].ring_size = impl_->uring->cq_size();
+        return;
+    }
+    if (backend_ == IoBackend::Xdp) {
+        impl_->xdp = std::make_unique<XdpIo>(cfg_);
+        ok_ = impl_->xdp->ok();
+        telemetry_.ring[0].ring_size = impl_->xdp->rx_ring_size();
+        return;
+    }
+
 #ifdef USE_NETMAP
     // Open the netmap interface
     nm_desc* nmd = nm_open(cfg_.ifname.c_str(), nullptr, 0, nullptr);
@@ -69,6 +151,14 @@ BypassIO::BypassIO(const BypassConfig& cfg) : cfg_(cfg), impl_(new Impl) {
     impl_->tx_first = (cfg_.tx_ring_first >= 0) ? cfg_.tx_ring_first : nmd->first_tx_ring;
     impl_->tx_last = (cfg_.tx_ring_last >= 0) ? cfg_.tx_ring_last : nmd->last_tx_ring;
 
+    telemetry_.nrings = impl_->rx_last - impl_->rx_first + 1;
+    if (telemetry_.nrings > RxTelemetry::kMaxRings)
+        telemetry_.nrings = RxTelemetry::kMaxRings;
+    for (int r = 0; r < telemetry_.nrings; ++r) {
+        telemetry_.ring[r].ring_size =
+            NETMAP_RXRING(nmd->nifp, impl_->rx_first + r)->num_slots;
+    }
+
     ok_ = true;
 #else
     ok_ = false;
@@ -82,6 +172,97 @@ BypassIO::~BypassIO() {
     delete impl_;
 }
 
+/**
+ * @brief Receive a burst from whichever backend this object was opened with.
+ *
+ * @param cb Callback applied to each packet (see rx_batch_netmap()).
+ * @return Number of packets consumed this batch, or -1 on error.
+ */
+int BypassIO::rx_batch(const std::function<bool(const PacketView&)>& cb) {
+    if (!ok_) return -1;
+    int got = 0;
+    switch (backend_) {
+        case IoBackend::Socket:
+            got = impl_->sock->rx_batch(cb, stats_, telemetry_);
+            break;
+        case IoBackend::IoUring:
+            got = impl_->uring->rx_batch(cb, stats_, telemetry_);
+            break;
+        case IoBackend::Xdp:
+            got = impl_->xdp->rx_batch(cb, stats_, telemetry_);
+            break;
+        case IoBackend::Netmap:
+            got = rx_batch_netmap(cb);
+            break;
+    }
+    telemetry_.end_poll(got);
+    return got;
+}
+
+/**
+ * @brief Frames waiting in the RX ring(s) as of the last sync.
+ *
+ * Reads producer/consumer indices only (no syscall), so it is cheap enough
+ * for stall diagnostics but may lag the NIC by one NIOCRXSYNC.
+ */
+int BypassIO::rx_backlog() const {
+    if (!ok_) return -1;
+    switch (backend_) {
+        case IoBackend::Socket:
+            return -1;
+        case IoBackend::IoUring:
+            return (int)impl_->uring->backlog();
+        case IoBackend::Xdp:
+            return (int)impl_->xdp->backlog();
+        case IoBackend::Netmap:
+            break;
+    }
+#ifdef USE_NETMAP
+    int total = 0;
+    for (int r = impl_->rx_first; r <= impl_->rx_last; ++r)
+        total += (int)nm_ring_space(NETMAP_RXRING(impl_->nmd->nifp, r));
+    return total;
+#else
+    return -1;
+#endif
+}
+
+/**
+ * @brief Queue one frame for transmission.
+ *
+ * netmap: copies into the next free slot of the first TX ring and issues
+ * NIOCTXSYNC. Callers sending bursts should prefer batching at a higher level;
+ * this is meant for occasional order/ack frames, not line-rate generation.
+ *
+ * @param data full Ethernet frame
+ * @param len frame length
+ * @return len on success, -1 if the ring is full or the backend has no TX path.
+ */
+int BypassIO::tx(const uint8_t* data, uint16_t len) {
+    if (!ok_) return -1;
+    if (backend_ == IoBackend::Xdp) return impl_->xdp->tx(data, len);
+    if (backend_ != IoBackend::Netmap) return -1;
+#ifdef USE_NETMAP
+    auto* ring = NETMAP_TXRING(impl_->nmd->nifp, impl_->tx_first);
+    if (nm_ring_space(ring) == 0) {
+        ioctl(impl_->fd, NIOCTXSYNC, nullptr);
+        if (nm_ring_space(ring) == 0) return -1;
+    }
+    if (len > ring->nr_buf_size) return -1;
+
+    uint32_t cur = ring->cur;
+    auto& slot = ring->slot[cur];
+    std::memcpy(NETMAP_BUF(ring, slot.buf_idx), data, len);
+    slot.len = len;
+    ring->head = ring->cur = nm_ring_next(ring, cur);
+    ioctl(impl_->fd, NIOCTXSYNC, nullptr);
+    return len;
+#else
+    (void)data;
+    return -1;
+#endif
+}
+
 /**
  * @brief Drain RX rings and invoke callback on each packet.
  *
@@ -101,8 +282,7 @@ BypassIO::~BypassIO() {
  * early.
  * @return Number of packets consumed from RX rings this batch, or -1 on error.
  */
-int BypassIO::rx_batch(const std::function<bool(const PacketView&)>& cb) {
-    if (!ok_) return -1;
+int BypassIO::rx_batch_netmap(const std::function<bool(const PacketView&)>& cb) {
 #ifdef USE_NETMAP
     auto* nmd = impl_->nmd;
     int processed = 0;
@@ -144,45 +324,62 @@ int BypassIO::rx_batch(const std::function<bool(const PacketView&)>& cb) {
         // the next ring. If non-zero, we will process up to limit_per_ring
         // packets from this ring.
         uint32_t avail = nm_ring_space(ring);
-        if (avail == 0) continue;
         uint32_t take =
             (avail > (uint32_t)limit_per_ring) ? (uint32_t)limit_per_ring : avail;
 
+        // Occupancy at this sync and how much of it we take (telemetry)
+        telemetry_.record(r - impl_->rx_first, avail, take, (uint32_t)limit_per_ring);
+        if (avail == 0) continue;
+
         // The cur is the wakeup pointer where we start processing packets if
         // tail has advanced past it.
-        uint32_t cur = ring->cur;
-
-        // Process up to `take` packets from this ring
-        for (uint32_t i = 0; i < take; ++i) {
-            // Get a reference to the current slot and construct a PacketView
-            auto& slot = ring->slot[cur];
-
-            // Get the packet buffer from the memory-mapped region
-            auto* buf = (uint8_t*)NETMAP_BUF(ring, slot.buf_idx);
-
-            PacketView v{buf, (uint16_t)slot.len, rdtsc()};
-            ++processed;
-            ++stats_.pkts;
-            stats_.bytes += slot.len;
-
-            // Invoke the user callback. If it returns false, we stop processing
-            // early and save our position for the next call.
-            if (!cb(v)) {
-                ring->head = ring->cur = cur;
-                return processed;
-            }
-
-            // Advance to the next slot in the ring
-            cur = nm_ring_next(ring, cur);
-        }
+        const uint32_t cur = ring->cur;
+        const uint32_t nslots = ring->num_slots;
+
+        // Slot index of the i-th packet of this batch
+        auto slot_at = [cur, nslots](uint32_t i) {
+            const uint32_t s = cur + i;
+            return s >= nslots ? s - nslots : s;
+        };
 
-        // Head is where the user can read from next, so we set head=cur because
-        // we processed everything up to cur.
-        ring->head = ring->cur = cur;
+        // Process up to `take` packets from this ring, prefetching the slots
+        // and buffers of the packets cfg_.prefetch ahead (see rx_pipeline())
+        bool stopped = false;
+        const uint32_t done = rx_pipeline(
+            take, cfg_.prefetch > 0 ? (uint32_t)cfg_.prefetch : 0,
+            [&](uint32_t i) { prefetch_line(&ring->slot[slot_at(i)]); },
+            [&](uint32_t i) {
+                const auto& slot = ring->slot[slot_at(i)];
+                prefetch_frame((const uint8_t*)NETMAP_BUF(ring, slot.buf_idx), slot.len);
+            },
+            [&](uint32_t i) {
+                // Get the packet buffer from the memory-mapped region
+                const auto& slot = ring->slot[slot_at(i)];
+                auto* buf = (uint8_t*)NETMAP_BUF(ring, slot.buf_idx);
+
+                PacketView v{buf, (uint16_t)slot.len, rdtsc()};
+                ++stats_.pkts;
+                stats_.bytes += slot.len;
+
+                // Invoke the user callback. If it returns false, we stop
+                // processing early and save our position for the next call.
+                if (!cb(v)) stopped = true;
+                return !stopped;
+            });
+        processed += (int)done;
+
+        // Head is where the user can read from next: past everything we
+        // processed, or at the packet whose callback asked us to stop
+        if (stopped) {
+            ring->head = ring->cur = slot_at(done - 1);
+            return processed;
+        }
+        ring->head = ring->cur = slot_at(done);
         ++stats_.batches;
     }
     return processed;
 #else
+    (void)cb;
     return -1;
 #endif
 }
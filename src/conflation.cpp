@@ -0,0 +1,44 @@
+#include "conflation.h"
+#include <cstdio>
+
+TickConflator::TickConflator(size_t slots) {
+    size_t n = 64;
+    shift_ = 26;
+    while (n < slots && shift_ > 1) {
+        n <<= 1;
+        --shift_;
+    }
+    mask_ = (uint32_t)(n - 1);
+    slots_.assign(n, Slot{});  // gen 0 never matches gen_, so all slots start free
+    fifo_.assign(n, 0);
+}
+
+/**
+ * @brief Print conflation counters for one reporting interval.
+ *
+ * The ratio is ticks absorbed per tick flushed: 1.0 means the table only
+ * delayed ticks, 4.0 means four updates collapsed into each one the consumer
+ * saw. "dropped" is non-zero only when an episode touched more distinct
+ * (instrument, side) keys than the table can probe for; raise the slot count.
+ *
+ * @param now     current counters
+ * @param prev    counters at the previous report (ignored when final)
+ * @param pending ticks still waiting in the table
+ * @param final   print whole-run figures
+ */
+void print_conflation(const ConflationStats& now, const ConflationStats& prev,
+    size_t pending, bool final) {
+    static const ConflationStats kZero{};
+    const ConflationStats& base = final ? kZero : prev;
+
+    const uint64_t in = now.absorbed - base.absorbed;
+    const uint64_t out = now.flushed - base.flushed;
+    if (in == 0 && out == 0) return;
+
+    std::printf("%sconflate: episodes=%llu absorbed=%llu overwritten=%llu flushed=%llu "
+                "ratio=%.2f dropped=%llu pending=%zu\n",
+        final ? "[final] " : "", (unsigned long long)(now.episodes - base.episodes),
+        (unsigned long long)in, (unsigned long long)(now.overwritten - base.overwritten),
+        (unsigned long long)out, out ? (double)in / (double)out : 0.0,
+        (unsigned long long)(now.dropped - base.dropped), pending);
+}
@@ -0,0 +1,269 @@
+#include "decoder_registry.h"
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+struct TypeName {
+    const char* name;
+    FieldType type;
+    uint16_t width;
+};
+
+constexpr TypeName kTypes[] = {
+    {"u8", FieldType::U8, 1},
+    {"u16", FieldType::U16, 2},
+    {"u32", FieldType::U32, 4},
+    {"u64", FieldType::U64, 8},
+    {"i32", FieldType::I32, 4},
+    {"i64", FieldType::I64, 8},
+    {"f32", FieldType::F32, 4},
+    {"f64", FieldType::F64, 8},
+};
+
+struct TargetName {
+    const char* name;
+    TickField target;
+};
+
+constexpr TargetName kTargets[] = {
+    {"instr", TickField::InstrId},
+    {"type", TickField::InstrType},
+    {"side", TickField::Side},
+    {"px", TickField::Px},
+    {"qty", TickField::Qty},
+};
+
+bool parse_uint(const std::string& s, unsigned long max, unsigned long& out) {
+    if (s.empty()) return false;
+    char* end = nullptr;
+    out = std::strtoul(s.c_str(), &end, 10);
+    return *end == '\0' && out <= max;
+}
+
+// "<type>[be]@<offset>[/div|*mul]"
+bool parse_field(const std::string& target, const std::string& val, FieldSpec& f,
+    uint16_t& width, std::string& err) {
+    bool found = false;
+    for (const TargetName& t : kTargets) {
+        if (target == t.name) {
+            f.target = t.target;
+            found = true;
+        }
+    }
+    if (!found) {
+        err = target == "ts" ? "field 'ts' is not supported (ticks carry the RX TSC)"
+                             : "unknown field '" + target + "'";
+        return false;
+    }
+
+    const size_t at = val.find('@');
+    if (at == std::string::npos) {
+        err = "field '" + target + "' needs <type>@<offset>";
+        return false;
+    }
+    std::string type = val.substr(0, at);
+    f.big_endian = type.size() > 2 && type.compare(type.size() - 2, 2, "be") == 0;
+    if (f.big_endian) type.resize(type.size() - 2);
+    found = false;
+    for (const TypeName& t : kTypes) {
+        if (type == t.name) {
+            f.type = t.type;
+            width = t.width;
+            found = true;
+        }
+    }
+    if (!found) {
+        err = "unknown type '" + type + "' for field '" + target + "'";
+        return false;
+    }
+
+    std::string off = val.substr(at + 1);
+    f.scale = 1.0;
+    const size_t op = off.find_first_of("/*");
+    if (op != std::string::npos) {
+        const double k = std::strtod(off.c_str() + op + 1, nullptr);
+        if (k == 0) {
+            err = "bad scale for field '" + target + "'";
+            return false;
+        }
+        f.scale = off[op] == '/' ? 1.0 / k : k;
+        off.resize(op);
+    }
+    unsigned long o = 0;
+    if (!parse_uint(off, 65535, o)) {
+        err = "bad offset for field '" + target + "'";
+        return false;
+    }
+    f.offset = (uint16_t)o;
+    return true;
+}
+
+}  // namespace
+
+/**
+ * @brief Parse a comma-separated table schema (see decoder_registry.h).
+ *
+ * All validation happens here so run_table() can read fields without bounds
+ * checks: each field must lie inside the record, and a record size is required.
+ *
+ * @param spec schema text, without the "table:" prefix
+ * @param out  schema to fill
+ * @param err  set to a description of the first error
+ * @return true if the schema is usable
+ */
+bool parse_table_schema(const std::string& spec, TableSchema& out, std::string& err) {
+    out = TableSchema{};
+    std::vector<uint16_t> widths;
+    size_t pos = 0;
+    while (pos <= spec.size()) {
+        size_t comma = spec.find(',', pos);
+        if (comma == std::string::npos) comma = spec.size();
+        const std::string item = spec.substr(pos, comma - pos);
+        pos = comma + 1;
+        if (item.empty()) continue;
+
+        const size_t eq = item.find('=');
+        if (eq == std::string::npos) {
+            err = "expected key=value, got '" + item + "'";
+            return false;
+        }
+        const std::string key = item.substr(0, eq), val = item.substr(eq + 1);
+        unsigned long n = 0;
+        if (key == "rec" || key == "hdr") {
+            if (!parse_uint(val, 65535, n)) {
+                err = "bad " + key + " size '" + val + "'";
+                return false;
+            }
+            (key == "rec" ? out.record : out.header) = (uint16_t)n;
+            continue;
+        }
+        FieldSpec f{};
+        uint16_t width = 0;
+        if (!parse_field(key, val, f, width, err)) return false;
+        out.fields.push_back(f);
+        widths.push_back(width);
+    }
+
+    if (out.record == 0) {
+        err = "missing rec=<record bytes>";
+        return false;
+    }
+    if (out.fields.empty()) {
+        err = "no fields";
+        return false;
+    }
+    for (size_t i = 0; i < out.fields.size(); ++i) {
+        if (out.fields[i].offset + widths[i] > out.record) {
+            err = "field at offset " + std::to_string(out.fields[i].offset) +
+                  " runs past the " + std::to_string(out.record) + "-byte record";
+            return false;
+        }
+    }
+    return true;
+}
+
+DecoderRegistry::DecoderRegistry() {
+    std::string err;
+    default_id_ = add("md14", err);
+}
+
+/**
+ * @brief Register a decoder.
+ *
+ * @param spec "md14", "md14x" (PackedHeader + records), "px8be" or
+ *             "table:<schema>"
+ * @param err  set on failure
+ * @return the decoder id, or -1 if the spec is invalid
+ */
+int DecoderRegistry::add(const std::string& spec, std::string& err) {
+    Entry e{};
+    e.name = spec;
+    if (spec == Md14Layout::kName) {
+        e.kind = DecoderKind::Md14;
+    } else if (spec == "md14x") {
+        e.kind = DecoderKind::Md14Packed;
+    } else if (spec == Px8BeLayout::kName) {
+        e.kind = DecoderKind::Px8Be;
+    } else if (spec.rfind("table:", 0) == 0) {
+        TableSchema s;
+        if (!parse_table_schema(spec.substr(6), s, err)) return -1;
+        e.kind = DecoderKind::Table;
+        e.table = (uint16_t)tables_.size();
+        e.name = "table#" + std::to_string(tables_.size());
+        tables_.push_back(std::move(s));
+    } else {
+        err = "unknown decoder '" + spec + "' (md14, md14x, px8be, table:...)";
+        return -1;
+    }
+
+    // Reuse an identical fixed decoder so its counters stay in one place
+    if (e.kind != DecoderKind::Table) {
+        for (size_t i = 0; i < entries_.size(); ++i)
+            if (entries_[i].kind == e.kind) return (int)i;
+    }
+    entries_.push_back(std::move(e));
+    return (int)entries_.size() - 1;
+}
+
+void DecoderRegistry::route(uint16_t port, int id) {
+    routed_ = true;
+    if (port == 0) {
+        default_id_ = id;
+        return;
+    }
+    for (Route& r : routes_) {
+        if (r.port == port) {
+            r.id = id;
+            return;
+        }
+    }
+    routes_.push_back(Route{port, id});
+}
+
+void DecoderRegistry::restrict_to_routes(uint16_t port) {
+    if (default_id_ < 0) return;
+    if (lookup(port) == default_id_) route(port, default_id_);
+    default_id_ = -1;
+}
+
+bool DecoderRegistry::all_routes(DecoderKind kind) const {
+    if (default_id_ >= 0 && entries_[default_id_].kind != kind) return false;
+    for (const Route& r : routes_)
+        if (entries_[r.id].kind != kind) return false;
+    return true;
+}
+
+bool DecoderRegistry::configure(const std::string& rule, std::string& err) {
+    const size_t eq = rule.find('=');
+    unsigned long port = 0;
+    if (eq == std::string::npos || !parse_uint(rule.substr(0, eq), 65535, port)) {
+        err = "expected <port>=<decoder>, got '" + rule + "'";
+        return false;
+    }
+    const int id = add(rule.substr(eq + 1), err);
+    if (id < 0) return false;
+    route((uint16_t)port, id);
+    return true;
+}
+
+/**
+ * @brief Print per-decoder counters, one line per decoder that saw traffic.
+ *
+ * Runs on the reporter thread; counters are read racily, like Stats.
+ */
+void DecoderRegistry::print_stats() const {
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        const DecoderStats& s = entries_[i].stats;
+        if (s.datagrams == 0) continue;
+        std::printf("decoder[%s]: dgrams=%llu ticks=%llu records/dgram=%.1f bad_len=%llu "
+                    "bad_val=%llu\n",
+            entries_[i].name.c_str(), (unsigned long long)s.datagrams,
+            (unsigned long long)s.ticks,
+            (double)(s.ticks + s.bad_value) / (double)s.datagrams,
+            (unsigned long long)s.bad_length, (unsigned long long)s.bad_value);
+    }
+    if (unrouted_ || malformed_)
+        std::printf("decoder: unrouted=%llu malformed=%llu\n",
+            (unsigned long long)unrouted_, (unsigned long long)malformed_);
+}
@@ -0,0 +1,175 @@
+// Standalone trading engine (build/uspf_engine): consumes the tick ring that
+// `user_space_packet_filter --shm <path>` publishes, so the strategy runs in
+// its own process and can be restarted without touching capture. When the
+// capture process goes away it waits for the next one and reattaches.
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "alloc_audit.h"
+#include "common.h"
+#include "flight_recorder.h"
+#include "realtime.h"
+#include "shm_ring.h"
+#include "strategy.h"
+#include "trading_engine.h"
+
+static void usage(const char* prog) {
+    std::fprintf(stderr,
+        "Usage: %s ring_path [-e engine_core] [-k housekeeping_core] [--realtime]\n"
+        "          [--fifo priority] [-r seconds] [-J stall_usecs] [--batch]\n"
+        "          [-W yield|spin|spinyield[:polls]|block[:polls]]\n"
+        "          [--fdr entries] [--fdr-breach usecs] [--fdr-dir dir]\n",
+        prog);
+}
+
+static std::atomic<bool> g_running{true};
+
+static void on_signal(int) {
+    g_running = false;
+}
+
+int main(int argc, char** argv) {
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+
+    std::string path;
+    RealtimeConfig rt{};
+    int run_seconds = 0;
+    uint64_t stall_us = 100;
+    bool batch = false;
+    WaitMode wait_mode = WaitMode::Yield;
+    uint32_t wait_budget = 2000;
+    size_t fdr_records = 1024;
+    uint64_t fdr_breach_us = 0;
+    std::string fdr_dir = "/tmp";
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "-e") && i + 1 < argc)
+            rt.engine_core = std::stoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "-k") && i + 1 < argc)
+            rt.housekeeping_core = std::stoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--realtime"))
+            rt.enabled = true;
+        else if (!std::strcmp(argv[i], "--fifo") && i + 1 < argc)
+            rt.fifo_priority = std::stoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "-r") && i + 1 < argc)
+            run_seconds = std::stoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "-J") && i + 1 < argc)
+            stall_us = std::stoull(argv[++i]);
+        else if (!std::strcmp(argv[i], "--batch"))
+            batch = true;
+        else if (!std::strcmp(argv[i], "--fdr") && i + 1 < argc)
+            fdr_records = std::stoul(argv[++i]);
+        else if (!std::strcmp(argv[i], "--fdr-breach") && i + 1 < argc)
+            fdr_breach_us = std::stoull(argv[++i]);
+        else if (!std::strcmp(argv[i], "--fdr-dir") && i + 1 < argc)
+            fdr_dir = argv[++i];
+        else if (!std::strcmp(argv[i], "-W") && i + 1 < argc) {
+            if (!parse_wait_mode(argv[++i], wait_mode, wait_budget)) {
+                std::fprintf(stderr, "bad -W %s\n", argv[i]);
+                return 2;
+            }
+        } else if (argv[i][0] != '-' && path.empty())
+            path = argv[i];
+        else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (path.empty()) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    if (rt.enabled) realtime_lock_memory();
+    flight_recorder_init(fdr_records, fdr_breach_us * 1000, fdr_dir.c_str());
+    pin_thread_to_core(rt.housekeeping_core);
+
+    const auto end = run_seconds > 0
+        ? std::chrono::steady_clock::now() + std::chrono::seconds(run_seconds)
+        : std::chrono::steady_clock::time_point::max();
+    auto live = [&] { return g_running && std::chrono::steady_clock::now() < end; };
+
+    // Strategy state outlives attachments: a new capture process feeds the
+    // same instruments, so the rolling statistics stay warm across reattaches
+    MeanReversion strategy;
+    StrategyStats last_strat{};
+
+    std::string last_err;
+    while (live()) {
+        std::string err;
+        std::shared_ptr<ShmRing> shm = ShmRing::attach(path, err);
+        if (!shm) {
+            if (err != last_err) std::fprintf(stderr, "waiting: %s\n", err.c_str());
+            last_err = err;
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            continue;
+        }
+        last_err.clear();
+        std::printf("Attached to %s (producer pid %d, attach #%llu, %zu ticks queued)\n",
+            path.c_str(), (int)shm->header().producer_pid.load(),
+            (unsigned long long)shm->header().attaches.load(), shm->depth());
+
+        TradingEngine engine{shm->ring()};
+        if (batch)
+            engine.set_batch_handler([&](const TickBatch& b) { strategy.on_batch(b); });
+        engine.set_wait(wait_mode, wait_budget);
+        engine.use_wakeup(shm->wakeup());
+        engine.jitter().set_threshold_ns(stall_us * 1000);
+        engine.start(rt.engine_core, rt.fifo_priority);
+
+        WaitStats last_wait{};
+        uint64_t last_cpu = 0;
+        Log2Histogram last_gaps{};
+        auto last_wall = std::chrono::steady_clock::now();
+        const auto first_wall = last_wall;
+        auto print_once = [&](bool final) {
+            if (batch) {
+                const StrategyStats st = strategy.stats();
+                print_strategy(st, last_strat, final);
+                last_strat = st;
+            }
+            const WaitStats ws = engine.wait_stats();
+            const uint64_t cpu = engine.cpu_ns();
+            const auto wall = std::chrono::steady_clock::now();
+            const auto dwall = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                wall - (final ? first_wall : last_wall));
+            print_wait(engine.wait_mode(), ws, last_wait, final ? cpu : cpu - last_cpu,
+                (uint64_t)dwall.count(), final);
+            last_wait = ws;
+            last_cpu = cpu;
+            last_wall = wall;
+            report_jitter(engine.jitter(), last_gaps, final);
+            std::fflush(stdout);
+        };
+
+        // Report every 5 s; detach when the producer closes the ring or dies
+        auto next_report = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        bool producer_gone = false;
+        while (live()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            flight_recorder_service();
+            if (!shm->producer_alive()) {
+                producer_gone = true;
+                break;
+            }
+            if (std::chrono::steady_clock::now() >= next_report) {
+                print_once(false);
+                next_report += std::chrono::seconds(5);
+            }
+        }
+        engine.stop();
+        flight_recorder_service();
+        print_once(true);
+        if (producer_gone) std::printf("Producer of %s is gone; reattaching\n", path.c_str());
+    }
+
+    if (alloc_audit_report() != 0) return 3;
+    return 0;
+}
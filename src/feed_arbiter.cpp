@@ -0,0 +1,47 @@
+#include "feed_arbiter.h"
+#include <cstdio>
+#include "common.h"
+
+/**
+ * @brief Print A/B arbitration counters for one reporting interval.
+ *
+ * "won" is the share of forwarded datagrams whose first copy came from each
+ * line. The lead percentiles say by how much the winner beat the other copy;
+ * a line that wins often by a wide margin is the one to favour when placing
+ * the capture core.
+ *
+ * @param now   current counters
+ * @param prev  counters at the previous report (ignored when final)
+ * @param final print whole-run figures
+ */
+void print_arbiter(const ArbiterStats& now, const ArbiterStats& prev, bool final) {
+    static const ArbiterStats kZero{};
+    const ArbiterStats& base = final ? kZero : prev;
+
+    const uint64_t fa = now.forwarded[0] - base.forwarded[0];
+    const uint64_t fb = now.forwarded[1] - base.forwarded[1];
+    const uint64_t dup = now.duplicates - base.duplicates;
+    if (fa + fb + dup == 0 && now.unsequenced == base.unsequenced) return;
+
+    const double won_a = fa + fb ? 100.0 * (double)fa / (double)(fa + fb) : 0.0;
+    std::printf("%sarb: fwd A=%llu B=%llu (A won %.1f%%) dup=%llu gaps=%llu missing=%llu "
+                "recovered=%llu stale=%llu unseq=%llu\n",
+        final ? "[final] " : "", (unsigned long long)fa, (unsigned long long)fb, won_a,
+        (unsigned long long)dup, (unsigned long long)(now.gaps - base.gaps),
+        (unsigned long long)now.missing,
+        (unsigned long long)(now.recovered - base.recovered),
+        (unsigned long long)(now.stale - base.stale),
+        (unsigned long long)(now.unsequenced - base.unsequenced));
+
+    const double k = tsc_ns_per_tick();
+    const Log2Histogram* leads[2] = {&now.a_lead, &now.b_lead};
+    const Log2Histogram* bases[2] = {&base.a_lead, &base.b_lead};
+    for (int l = 0; l < 2; ++l) {
+        const Log2Histogram h = leads[l]->since(*bases[l]);
+        if (h.total == 0) continue;
+        std::printf("%sarb: %c led by p50<=%.1fus p99<=%.1fus max=%.1fus (%llu pairs)\n",
+            final ? "[final] " : "", l == 0 ? 'A' : 'B',
+            (double)h.percentile(50) * k / 1e3, (double)h.percentile(99) * k / 1e3,
+            (double)h.max * k / 1e3, (unsigned long long)h.total);
+    }
+}
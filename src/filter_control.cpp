@@ -0,0 +1,134 @@
+#include "filter_control.h"
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+FilterControl::FilterControl(PacketFilter& filter, std::string path)
+    : filter_(filter), path_(std::move(path)) {}
+
+FilterControl::~FilterControl() {
+    stop();
+}
+
+bool FilterControl::start() {
+    sockaddr_un addr{};
+    if (path_.size() >= sizeof(addr.sun_path)) {
+        std::fprintf(stderr, "control: socket path too long: %s\n", path_.c_str());
+        return false;
+    }
+    listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) return false;
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path_.c_str(), path_.size() + 1);
+    ::unlink(path_.c_str());
+    if (::bind(listen_fd_, (const sockaddr*)&addr, sizeof(addr)) < 0 ||
+        ::listen(listen_fd_, 4) < 0) {
+        std::fprintf(stderr, "control: %s: %s\n", path_.c_str(), std::strerror(errno));
+        ::close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+    running_.store(true);
+    worker_ = std::thread(&FilterControl::serve, this);
+    return true;
+}
+
+void FilterControl::stop() {
+    if (!running_.exchange(false)) return;
+    if (worker_.joinable()) worker_.join();
+    ::close(listen_fd_);
+    listen_fd_ = -1;
+    ::unlink(path_.c_str());
+}
+
+// Accept loop; polls with a timeout so stop() is noticed
+void FilterControl::serve() {
+    while (running_.load(std::memory_order_relaxed)) {
+        pollfd pfd{listen_fd_, POLLIN, 0};
+        if (::poll(&pfd, 1, 200) <= 0) continue;
+        const int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) continue;
+        serve_client(fd);
+        ::close(fd);
+    }
+}
+
+// One client: answer each line until EOF, an error, or 5 s of silence
+void FilterControl::serve_client(int fd) {
+    std::string buf;
+    char chunk[512];
+    while (running_.load(std::memory_order_relaxed)) {
+        pollfd pfd{fd, POLLIN, 0};
+        if (::poll(&pfd, 1, 5000) <= 0) return;
+        const ssize_t n = ::read(fd, chunk, sizeof(chunk));
+        if (n <= 0) return;
+        buf.append(chunk, (size_t)n);
+        size_t nl;
+        while ((nl = buf.find('\n')) != std::string::npos) {
+            const std::string reply = handle(buf.substr(0, nl)) + "\n";
+            buf.erase(0, nl + 1);
+            if (::write(fd, reply.data(), reply.size()) < 0) return;
+        }
+    }
+}
+
+namespace {
+
+std::string describe(const FilterConfig& c) {
+    std::ostringstream os;
+    os << "udp_port=" << c.udp_port << " payload_len=" << c.payload_len
+       << " csum=" << (int)c.verify_checksums;
+    return os.str();
+}
+
+}  // namespace
+
+/**
+ * @brief Parse and apply one control command.
+ *
+ * @param line "show" or space-separated key=value pairs
+ * @return "ok ..." with the resulting rules, or "error: ..."
+ */
+std::string FilterControl::handle(const std::string& line) {
+    uint64_t version = 0;
+    FilterConfig cfg = filter_.published(&version);
+
+    std::istringstream in(line);
+    std::string tok;
+    bool changed = false;
+    while (in >> tok) {
+        if (tok == "show") continue;
+        const size_t eq = tok.find('=');
+        if (eq == std::string::npos) return "error: expected key=value, got " + tok;
+        const std::string key = tok.substr(0, eq);
+        char* end = nullptr;
+        const unsigned long v = std::strtoul(tok.c_str() + eq + 1, &end, 10);
+        if (*end != '\0' || v > 65535) return "error: bad value in " + tok;
+        if (key == "udp_port")
+            cfg.udp_port = (uint16_t)v;
+        else if (key == "payload_len")
+            cfg.payload_len = (uint16_t)v;
+        else if (key == "csum" && v <= 1)
+            cfg.verify_checksums = v != 0;
+        else
+            return "error: unknown key " + key;
+        changed = true;
+    }
+
+    if (changed) {
+        version = filter_.publish(cfg);
+        std::printf("control: published filter v%llu: %s\n", (unsigned long long)version,
+            describe(cfg).c_str());
+        std::fflush(stdout);
+    }
+    std::ostringstream os;
+    os << "ok version=" << version << " active=" << filter_.adopted_version() << " "
+       << describe(cfg);
+    return os.str();
+}
@@ -0,0 +1,404 @@
+#include "flight_recorder.h"
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include "packet_filter.h"
+#include "tick_shard.h"
+
+namespace {
+
+// The capture thread and one engine per shard
+constexpr uint32_t kMaxRecorders = ShardSplitter::kMaxShards + 1;
+// Per hot thread, for the crash handler: a stack overflow leaves it no room
+// on the thread's own stack
+constexpr size_t kAltStackSize = 64 << 10;
+// A threshold set too low must not fill the disk: past this many breach
+// dumps, breached recorders are re-armed without writing
+constexpr uint32_t kMaxBreachDumps = 64;
+
+// Set by flight_recorder_init(), read by begin_thread() and the dumpers
+size_t g_records = 0;
+uint64_t g_breach_ns = 0;
+char g_dir[256] = "/tmp";
+
+std::atomic<FlightRecorder*> g_recorders[kMaxRecorders];
+std::atomic<uint32_t> g_dumps{0};
+uint32_t g_breach_dumps = 0;  // main thread only
+volatile sig_atomic_t g_dump_requested = 0;
+
+void write_all(int fd, const char* s, size_t n) {
+    while (n) {
+        const ssize_t w = ::write(fd, s, n);
+        if (w <= 0) return;
+        s += w;
+        n -= (size_t)w;
+    }
+}
+
+void write_str(int fd, const char* s) {
+    write_all(fd, s, std::strlen(s));
+}
+
+// Text line built on the stack by integer code only: the crash handler may
+// run with the heap corrupted, and printf's float formatting can allocate.
+// Output past the capacity is cut off.
+class LineBuf {
+   public:
+    void str(const char* s) {
+        while (*s) chr(*s++);
+    }
+    void chr(char c) {
+        if (n_ < sizeof(buf_) - 1) buf_[n_++] = c;
+    }
+    void u64(uint64_t v) {
+        char d[20];
+        int k = 0;
+        do d[k++] = (char)('0' + v % 10);
+        while (v /= 10);
+        while (k) chr(d[--k]);
+    }
+    void i64(int64_t v) {
+        if (v < 0) {
+            chr('-');
+            u64(0 - (uint64_t)v);
+        } else {
+            u64((uint64_t)v);
+        }
+    }
+    // `digits` decimals, rounded
+    void fixed(double v, int digits) {
+        if (v != v) return str("nan");
+        if (v < 0) {
+            chr('-');
+            v = -v;
+        }
+        uint64_t scale = 1;
+        for (int i = 0; i < digits; ++i) scale *= 10;
+        if (v >= 1e18 / (double)scale) return str("inf");
+        const uint64_t q = (uint64_t)(v * (double)scale + 0.5);
+        u64(q / scale);
+        if (!digits) return;
+        chr('.');
+        for (uint64_t d = scale / 10; d; d /= 10) chr((char)('0' + q / d % 10));
+    }
+    void hex(const uint8_t* p, size_t n) {
+        static const char kHex[] = "0123456789abcdef";
+        for (size_t i = 0; i < n; ++i) {
+            chr(kHex[p[i] >> 4]);
+            chr(kHex[p[i] & 15]);
+        }
+    }
+
+    const char* c_str() {
+        buf_[n_] = '\0';
+        return buf_;
+    }
+    void write(int fd) {
+        write_all(fd, buf_, n_);
+        n_ = 0;
+    }
+
+   private:
+    char buf_[512];
+    size_t n_{0};
+};
+
+// <dir>/fdr-<pid>-<name>-<k>.txt
+void dump_path(const FlightRecorder& r, LineBuf& out) {
+    out.str(g_dir);
+    out.str("/fdr-");
+    out.i64(::getpid());
+    out.chr('-');
+    out.str(r.name());
+    out.chr('-');
+    out.u64(g_dumps.fetch_add(1, std::memory_order_relaxed));
+    out.str(".txt");
+}
+
+// The calling thread's alternate signal stack, released when the thread exits
+struct AltStack {
+    void* mem{nullptr};
+    ~AltStack() {
+        if (!mem) return;
+        stack_t ss{};
+        ss.ss_flags = SS_DISABLE;
+        ::sigaltstack(&ss, nullptr);
+        std::free(mem);
+    }
+};
+thread_local AltStack t_alt_stack;
+
+void install_alt_stack() {
+    if (t_alt_stack.mem) return;
+    void* mem = std::malloc(kAltStackSize);
+    if (!mem) return;
+    std::memset(mem, 0, kAltStackSize);  // prefault
+    stack_t ss{};
+    ss.ss_sp = mem;
+    ss.ss_size = kAltStackSize;
+    if (::sigaltstack(&ss, nullptr) != 0) {
+        std::free(mem);
+        return;
+    }
+    t_alt_stack.mem = mem;
+}
+
+void on_sigusr1(int) {
+    g_dump_requested = 1;
+}
+
+// Dump every recorder, then die by the same signal (SA_RESETHAND restored the
+// default action)
+void on_crash(int sig) {
+    LineBuf reason;
+    reason.str("crash (signal ");
+    reason.i64(sig);
+    reason.chr(')');
+    for (auto& slot : g_recorders) {
+        const FlightRecorder* r = slot.load(std::memory_order_acquire);
+        if (!r || !r->on()) continue;
+        LineBuf path;
+        dump_path(*r, path);
+        if (r->dump(path.c_str(), reason.c_str())) {
+            write_str(STDERR_FILENO, "flight recorder: wrote ");
+            write_str(STDERR_FILENO, path.c_str());
+            write_str(STDERR_FILENO, "\n");
+        }
+    }
+    ::raise(sig);
+}
+
+}  // namespace
+
+FlightRecorder::~FlightRecorder() {
+    for (auto& slot : g_recorders) {
+        FlightRecorder* self = this;
+        if (slot.compare_exchange_strong(self, nullptr)) break;
+    }
+    std::free(recs_);
+}
+
+void FlightRecorder::begin_thread() {
+    if (g_records == 0 || recs_) return;
+    size_t n = 1;
+    while (n < g_records) n <<= 1;
+    recs_ = static_cast<FlightRecord*>(std::aligned_alloc(alignof(FlightRecord),
+        n * sizeof(FlightRecord)));
+    if (!recs_) return;
+    std::memset(static_cast<void*>(recs_), 0, n * sizeof(FlightRecord));
+    records_ = n;
+    base_ = recs_;
+    mask_ = n - 1;
+    ns_per_tick_ = tsc_ns_per_tick();
+    if (g_breach_ns) breach_ticks_ = (int64_t)((double)g_breach_ns / ns_per_tick_);
+
+    bool registered = false;
+    for (auto& slot : g_recorders) {
+        FlightRecorder* expected = nullptr;
+        if ((registered = slot.compare_exchange_strong(expected, this))) break;
+    }
+    if (!registered) {
+        // Recording what no dump would ever write is pure cost
+        std::fprintf(stderr, "flight recorder %s: all %u slots taken, recorder off\n",
+            name_, kMaxRecorders);
+        std::free(recs_);
+        recs_ = nullptr;
+        records_ = 0;
+        base_ = &scratch_;
+        mask_ = 0;
+        return;
+    }
+    install_alt_stack();
+    on_ = true;
+}
+
+void FlightRecorder::stamp_batch(uint64_t from) {
+    const uint64_t now = rdtsc();
+    uint64_t end = pos_;
+    if (frozen_.load(std::memory_order_relaxed) && end > frozen_end_) end = frozen_end_;
+    if (from >= end) return;
+    if (end - from > records_) from = end - records_;
+    for (uint64_t i = from; i < end; ++i) {
+        FlightRecord& r = recs_[i & (records_ - 1)];
+        r.done_tsc = now;
+        check(now - r.rx_tsc);
+    }
+}
+
+// Breach: keep recording half a ring past the entry that breached
+void FlightRecorder::trigger() {
+    ++breaches_;
+    if (stop_at_ == kNever && !frozen_.load(std::memory_order_relaxed))
+        stop_at_ = pos_ + (records_ >> 1);
+}
+
+void FlightRecorder::freeze() {
+    frozen_end_ = pos_;
+    base_ = &scratch_;
+    mask_ = 0;
+    stop_at_ = kNever;
+    frozen_.store(true, std::memory_order_release);
+}
+
+void FlightRecorder::resume() {
+    rearm_.store(false, std::memory_order_relaxed);
+    if (!frozen_.load(std::memory_order_relaxed)) return;
+    valid_from_ = pos_;
+    base_ = recs_;
+    mask_ = records_ - 1;
+    frozen_.store(false, std::memory_order_release);
+}
+
+/**
+ * @brief Write the recorder's entries to a text file, oldest first.
+ *
+ * A frozen recorder dumps the ring as it was at the freeze; a live one dumps
+ * the last `records` entries as they are now. Times are relative to each
+ * entry's RX TSC, so a spike reads directly off the done column. Lines are
+ * formatted by LineBuf, never printf, as the crash handler calls this.
+ *
+ * @param path   file to create (truncated if it exists)
+ * @param reason first-line tag: "signal", "breach", "crash (signal N)"
+ * @return false if the recorder is off or the file could not be created
+ */
+bool FlightRecorder::dump(const char* path, const char* reason) const {
+    if (!on_) return false;
+    const int fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+
+    const bool frozen = frozen_.load(std::memory_order_acquire);
+    const uint64_t end = frozen ? frozen_end_ : pos_;
+    uint64_t first = end > records_ ? end - records_ : 0;
+    if (first < valid_from_) first = valid_from_;
+    const double k = ns_per_tick_;
+
+    LineBuf line;
+    line.str("# flight recorder ");
+    line.str(name_);
+    line.str(": ");
+    line.str(reason);
+    line.str(", pid ");
+    line.i64(::getpid());
+    line.str(", entries ");
+    line.u64(first);
+    line.str("..");
+    line.u64(end);
+    line.str(" of ");
+    line.u64(records_);
+    line.str(frozen ? ", frozen" : ", live");
+    line.str(", breaches=");
+    line.u64(breaches_);
+    line.str(" threshold=");
+    line.u64(g_breach_ns);
+    line.str("ns, ");
+    line.fixed(k, 4);
+    line.str(" ns/tsc\n");
+    line.write(fd);
+    write_str(fd, kind_ == Kind::Packets
+            ? "# seq rx_tsc done_ns line verdict len depth frame_bytes\n"
+            : "# seq rx_tsc pop_ns done_ns ticks depth instr type side px qty\n");
+
+    for (uint64_t i = first; i < end; ++i) {
+        FlightRecord r;
+        std::memcpy(static_cast<void*>(&r), &recs_[i & (records_ - 1)], sizeof(r));
+        line.u64(i);
+        line.chr(' ');
+        line.u64(r.rx_tsc);
+        line.chr(' ');
+        if (kind_ == Kind::Packets) {
+            line.i64((int64_t)((double)(int64_t)(r.done_tsc - r.rx_tsc) * k));
+            line.str(r.line ? " B " : " A ");
+            line.str(r.verdict < (uint8_t)FilterVerdict::kCount
+                    ? verdict_name((FilterVerdict)r.verdict)
+                    : "?");
+            line.chr(' ');
+            line.u64(r.len);
+            line.chr(' ');
+            line.u64(r.depth);
+            line.chr(' ');
+            line.hex(r.snap, r.len < kSnap ? r.len : kSnap);
+        } else {
+            Tick t;
+            std::memcpy(&t, r.snap, sizeof(t));
+            line.i64((int64_t)((double)(int64_t)(r.pop_tsc - r.rx_tsc) * k));
+            line.chr(' ');
+            line.i64((int64_t)((double)(int64_t)(r.done_tsc - r.rx_tsc) * k));
+            line.chr(' ');
+            line.u64(r.len);
+            line.chr(' ');
+            line.u64(r.depth);
+            line.chr(' ');
+            line.u64(t.instr_id);
+            line.chr(' ');
+            line.u64(t.instr_type);
+            line.chr(' ');
+            line.u64(t.side);
+            line.chr(' ');
+            line.fixed(t.px, 6);
+            line.chr(' ');
+            line.fixed(t.qty, 6);
+        }
+        line.chr('\n');
+        line.write(fd);
+    }
+    ::close(fd);
+    return true;
+}
+
+/**
+ * @brief Set up flight recording for this process.
+ *
+ * @param records   entries per hot thread (0 = recorders off)
+ * @param breach_ns RX-to-done time that freezes and dumps a recorder (0 = none)
+ * @param dir       directory for dump files
+ */
+void flight_recorder_init(size_t records, uint64_t breach_ns, const char* dir) {
+    g_records = records;
+    g_breach_ns = breach_ns;
+    std::snprintf(g_dir, sizeof(g_dir), "%s", dir);
+    if (!records) return;
+
+    struct sigaction sa {};
+    sigemptyset(&sa.sa_mask);
+    sa.sa_handler = on_sigusr1;
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &sa, nullptr);
+
+    // On the alternate stack of the crashing thread (begin_thread() gives
+    // each hot thread one, this gives the main thread one)
+    install_alt_stack();
+    sa.sa_handler = on_crash;
+    sa.sa_flags = SA_RESETHAND | SA_ONSTACK;
+    for (int sig : {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT}) sigaction(sig, &sa, nullptr);
+}
+
+size_t flight_recorder_service() {
+    const bool all = g_dump_requested != 0;
+    g_dump_requested = 0;
+    size_t written = 0;
+    for (auto& slot : g_recorders) {
+        FlightRecorder* r = slot.load(std::memory_order_acquire);
+        if (!r || !r->on()) continue;
+        const bool breached = r->frozen() && !r->rearming();
+        if (!all && !breached) continue;
+        if (breached && !all && g_breach_dumps >= kMaxBreachDumps) {
+            r->rearm();
+            continue;
+        }
+        if (breached && ++g_breach_dumps == kMaxBreachDumps)
+            std::printf("flight recorder: %u breach dumps, writing no more\n",
+                kMaxBreachDumps);
+        LineBuf path;
+        dump_path(*r, path);
+        if (r->dump(path.c_str(), breached ? "breach" : "signal")) {
+            std::printf("flight recorder: wrote %s (%s)\n", path.c_str(),
+                breached ? "breach" : "SIGUSR1");
+            std::fflush(stdout);
+            ++written;
+        }
+        if (breached) r->rearm();
+    }
+    return written;
+}
@@ -0,0 +1,129 @@
+#include "huge_alloc.h"
+#include "bypass_io.h"
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+
+// <numaif.h> lives in libnuma-dev; the two syscalls we need are called directly
+static constexpr int kMpolPreferred = 1;
+static constexpr unsigned kMpolFNode = 1 << 0;
+static constexpr unsigned kMpolFAddr = 1 << 1;
+
+static constexpr size_t k2M = size_t(1) << 21;
+static constexpr size_t k1G = size_t(1) << 30;
+
+static size_t round_up(size_t v, size_t a) {
+    return (v + a - 1) / a * a;
+}
+
+static int read_int_file(const char* path, int fallback) {
+    FILE* f = std::fopen(path, "r");
+    if (!f) return fallback;
+    int v = fallback;
+    if (std::fscanf(f, "%d", &v) != 1) v = fallback;
+    std::fclose(f);
+    return v;
+}
+
+int nic_numa_node(const std::string& ifname) {
+    const std::string dev = device_of(ifname);
+    if (dev.empty()) return -1;
+    const std::string path = "/sys/class/net/" + dev + "/device/numa_node";
+    return read_int_file(path.c_str(), -1);
+}
+
+int cpu_numa_node(int cpu) {
+    if (cpu < 0) return -1;
+    char path[64];
+    std::snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+    DIR* d = opendir(path);
+    if (!d) return -1;
+    int node = -1;
+    while (dirent* e = readdir(d)) {
+        if (std::strncmp(e->d_name, "node", 4) == 0) {
+            node = std::atoi(e->d_name + 4);
+            break;
+        }
+    }
+    closedir(d);
+    return node;
+}
+
+static void* map_pages(size_t len, int extra_flags) {
+    void* p = mmap(nullptr, len, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | extra_flags, -1, 0);
+    return p == MAP_FAILED ? nullptr : p;
+}
+
+/**
+ * @brief Allocate zeroed, pre-faulted, preferably huge-page-backed memory.
+ *
+ * The node policy is MPOL_PREFERRED rather than MPOL_BIND: a hugetlb fault
+ * that cannot be satisfied under a strict binding kills the process with
+ * SIGBUS, whereas a preferred node degrades to remote memory. Pages are
+ * touched here so the hot path never takes a first-touch fault.
+ *
+ * @param bytes size of the object
+ * @param node  preferred NUMA node (-1 = leave the default policy)
+ * @param info  optional out: page size and node actually obtained
+ * @return pointer to the mapping, or nullptr
+ */
+void* huge_alloc(size_t bytes, int node, HugeInfo* info) {
+    const size_t base = (size_t)sysconf(_SC_PAGESIZE);
+    size_t page = 0, len = 0;
+    void* p = nullptr;
+
+    if (bytes >= k1G) {
+        len = round_up(bytes, k1G);
+        if ((p = map_pages(len, MAP_HUGETLB | MAP_HUGE_1GB))) page = k1G;
+    }
+    if (!p) {
+        len = round_up(bytes, k2M);
+        if ((p = map_pages(len, MAP_HUGETLB | MAP_HUGE_2MB))) page = k2M;
+    }
+    if (!p) {
+        // No hugetlb pool: base pages, but let THP back them where it can
+        len = round_up(bytes, base);
+        if (!(p = map_pages(len, 0))) return nullptr;
+        page = base;
+        madvise(p, len, MADV_HUGEPAGE);
+    }
+
+    if (node >= 0 && node < 64) {
+        unsigned long mask = 1UL << node;
+        syscall(__NR_mbind, p, len, kMpolPreferred, &mask, 64, 0);
+    }
+
+    // Prefault (one write per page; anonymous memory is already zero)
+    auto* c = static_cast<volatile char*>(p);
+    for (size_t off = 0; off < len; off += page) c[off] = 0;
+
+    if (info) {
+        info->page_size = page;
+        int got = -1;
+        const unsigned flags = kMpolFNode | kMpolFAddr;
+        if (syscall(__NR_get_mempolicy, &got, nullptr, 0, p, flags) != 0) got = -1;
+        info->node = got;
+    }
+    return p;
+}
+
+void huge_free(void* p, size_t bytes, size_t page_size) {
+    if (!p) return;
+    if (page_size == 0) page_size = (size_t)sysconf(_SC_PAGESIZE);
+    munmap(p, round_up(bytes, page_size));
+}
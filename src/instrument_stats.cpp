@@ -0,0 +1,15 @@
+#include "instrument_stats.h"
+
+InstrumentStats::InstrumentStats(size_t capacity, float alpha, float vol_alpha)
+    : alpha_(alpha), vol_alpha_(vol_alpha) {
+    // Index table at least twice the capacity keeps probe chains short
+    size_t n = 64;
+    shift_ = 26;
+    while (n < 2 * capacity && shift_ > 1) {
+        n <<= 1;
+        --shift_;
+    }
+    mask_ = (uint32_t)(n - 1);
+    slots_.assign(n, Slot{0, kNone});
+    state_.assign(capacity, State{});
+}
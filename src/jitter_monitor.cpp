@@ -0,0 +1,117 @@
+#include "jitter_monitor.h"
+#include <sys/resource.h>
+#include <cstdio>
+#include <ctime>
+
+namespace {
+
+// Window for getrusage sampling; bounds how far back a stall's ctx switches go
+constexpr uint64_t kSampleNs = 10'000'000;
+
+void thread_ctx_switches(uint64_t& nvcsw, uint64_t& nivcsw) {
+    rusage ru{};
+    if (getrusage(RUSAGE_THREAD, &ru) != 0) return;
+    nvcsw = (uint64_t)ru.ru_nvcsw;
+    nivcsw = (uint64_t)ru.ru_nivcsw;
+}
+
+uint64_t realtime_ns() {
+    timespec ts{};
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+const char* stall_cause(const StallRecord& r) {
+    if (r.ivcsw) return "preempted";
+    if (r.vcsw) return "blocked";
+    return "irq/smi";
+}
+
+}  // namespace
+
+/**
+ * @brief Arm the monitor on the calling thread.
+ *
+ * Converts the ns threshold to TSC ticks and takes the first rusage snapshot.
+ * Leaves the monitor off if the threshold is 0 or the TSC is unusable.
+ */
+void JitterMonitor::begin_thread() {
+    ns_per_tick_ = tsc_ns_per_tick();
+    enabled_ = threshold_ns_ > 0 && ns_per_tick_ > 0;
+    if (!enabled_) return;
+    stall_ticks_ = (uint64_t)((double)threshold_ns_ / ns_per_tick_);
+    sample_ticks_ = (uint64_t)((double)kSampleNs / ns_per_tick_);
+    thread_ctx_switches(nvcsw_, nivcsw_);
+    last_ = rdtsc();
+    next_sample_ = last_ + sample_ticks_;
+}
+
+void JitterMonitor::sample_rusage(uint64_t now) {
+    thread_ctx_switches(nvcsw_, nivcsw_);
+    next_sample_ = now + sample_ticks_;
+}
+
+// Slow path: build the record, then restart the sampling window so the next
+// stall's counts start from here
+void JitterMonitor::on_stall(uint64_t gap_ticks) {
+    ++stall_count_;
+    StallRecord r;
+    r.wall_ns = realtime_ns();
+    r.gap_ns = (uint64_t)((double)gap_ticks * ns_per_tick_);
+    if (ring_fill_) r.ring_fill = ring_fill_();
+    if (rx_backlog_) r.rx_backlog = rx_backlog_();
+
+    uint64_t nv = nvcsw_, niv = nivcsw_;
+    thread_ctx_switches(nv, niv);
+    r.vcsw = (uint32_t)(nv - nvcsw_);
+    r.ivcsw = (uint32_t)(niv - nivcsw_);
+    nvcsw_ = nv;
+    nivcsw_ = niv;
+
+    if (!stalls_.push(r)) ++stalls_lost_;
+
+    // Don't charge our own bookkeeping to the next iteration
+    last_ = rdtsc();
+    next_sample_ = last_ + sample_ticks_;
+}
+
+/**
+ * @brief Print pending stalls and gap percentiles for one monitor.
+ *
+ * Runs on the reporter thread. Each stall line carries its wall-clock time,
+ * gap, fill levels, context switches and a best-guess cause.
+ *
+ * @param m     monitor to drain
+ * @param prev  histogram snapshot from the previous call (updated here)
+ * @param final print whole-run percentiles instead of the interval
+ */
+void report_jitter(JitterMonitor& m, Log2Histogram& prev, bool final) {
+    if (!m.enabled()) return;
+
+    StallRecord r;
+    while (m.pop_stall(r)) {
+        const time_t secs = (time_t)(r.wall_ns / 1000000000ull);
+        std::tm tm{};
+        localtime_r(&secs, &tm);
+        std::printf("stall[%s]: %02d:%02d:%02d.%06llu gap=%.1fus ring=%lld rx_backlog=%lld "
+                    "vcsw=+%u ivcsw=+%u (%s)\n",
+            m.name(), tm.tm_hour, tm.tm_min, tm.tm_sec,
+            (unsigned long long)(r.wall_ns % 1000000000ull / 1000), (double)r.gap_ns / 1e3,
+            (long long)r.ring_fill, (long long)r.rx_backlog, r.vcsw, r.ivcsw,
+            stall_cause(r));
+    }
+
+    const Log2Histogram cur = m.gaps();
+    const Log2Histogram h = final ? cur : cur.since(prev);
+    prev = cur;
+    if (h.total == 0) return;
+
+    const double k = tsc_ns_per_tick();
+    std::printf("%sjitter[%s]: iters=%llu  gap p50<=%.0fns p99<=%.0fns p99.9<=%.0fns "
+                "p99.99<=%.0fns max=%.1fus  stalls(>%lluus)=%llu%s\n",
+        final ? "[final] " : "", m.name(), (unsigned long long)h.total,
+        (double)h.percentile(50) * k, (double)h.percentile(99) * k,
+        (double)h.percentile(99.9) * k, (double)h.percentile(99.99) * k,
+        (double)h.max * k / 1e3, (unsigned long long)(m.threshold_ns() / 1000),
+        (unsigned long long)m.stalls(), m.stalls_lost() ? " (some not logged)" : "");
+}
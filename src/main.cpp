@@ -7,16 +7,36 @@
 #include <cstring>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <thread>
+#include <utility>
+#include <vector>
 
+#include "alloc_audit.h"
 #include "common.h"
+#include "filter_control.h"
+#include "flight_recorder.h"
+#include "huge_alloc.h"
 #include "packet_capture.h"
+#include "realtime.h"
+#include "shm_ring.h"
+#include "strategy.h"
 #include "trading_engine.h"
 
 static void usage(const char* prog) {
     std::fprintf(stderr,
-        "Usage: %s -i netmap:ethX [-p udp_port] [-c core] [-b burst] [-r seconds]\n",
+        "Usage: %s -i netmap:ethX|udp:[addr:]port|uring:[addr:]port|xdp:ethX[@queue]\n"
+        "          [-p udp_port] [-c core] [-b burst] [-r seconds] [-R rcvbuf_bytes]\n"
+        "          [-P busy_poll_usecs] [-Q sqpoll_core] [-x native|generic|copy]\n"
+        "          [-N numa_node] [-e engine_core] [-k housekeeping_core]\n"
+        "          [--realtime] [--fifo priority] [-J stall_usecs]\n"
+        "          [-d port=md14|md14x|px8be|table:<schema>]... [-I line_b_ifname]\n"
+        "          [--conflate slots] [--batch] [--verify-csum]\n"
+        "          [-W yield|spin|spinyield[:polls]|block[:polls]] [--control socket_path]\n"
+        "          [--shm ring_path] [--shards workers] [--prefetch distance]\n"
+        "          [--inline [--inline-tx]] [--fdr entries] [--fdr-breach usecs]\n"
+        "          [--fdr-dir dir]\n",
         prog);
 }
 
@@ -59,15 +79,29 @@ static void log_debug(const char* fmt, ...) {
 }
 
 int main(int argc, char** argv) {
-#ifndef USE_NETMAP
-    std::fprintf(stderr, "Build with -DUSE_NETMAP and netmap user libs.\n");
-    return 1;
-#else
     std::signal(SIGINT, on_sigint);
 
     BypassConfig io{};
     FilterConfig fc{};
     int run_seconds = 0;
+    int numa_node = -2;  // -2 = detect from the NIC, -1 = no placement
+    RealtimeConfig rt{};
+    uint64_t stall_us = 100;  // loop-gap stall threshold (0 = jitter monitor off)
+    DecoderRegistry decoders;
+    std::vector<uint16_t> decoder_ports;  // ports with an explicit -d route
+    std::string ifname_b;  // redundant B line for A/B arbitration (-I)
+    size_t conflate_slots = 0;  // 0 = drop ticks when the ring is full
+    bool batch = false;  // engine runs MeanReversion on TickBatch blocks
+    WaitMode wait_mode = WaitMode::Yield;  // engine idle behaviour (-W)
+    uint32_t wait_budget = 2000;           // empty polls before yield/park
+    std::string control_path;  // unix socket for live filter changes
+    std::string shm_path;  // publish ticks to a shared ring for uspf_engine
+    size_t shards = 1;     // engine workers, each fed its instruments' ticks
+    bool run_inline = false;  // strategy runs on the capture thread, no ring
+    bool inline_tx = false;   // ... and answers each signal with an order frame
+    size_t fdr_records = 1024;  // flight recorder entries per hot thread (0 = off)
+    uint64_t fdr_breach_us = 0;  // RX-to-done time that triggers a dump (0 = none)
+    std::string fdr_dir = "/tmp";
     for (int i = 1; i < argc; i++) {
         if (!std::strcmp(argv[i], "-i") && i + 1 < argc)
             io.ifname = argv[++i];
@@ -77,27 +111,201 @@ int main(int argc, char** argv) {
             io.cpu_affinity = std::stoi(argv[++i]);
         else if (!std::strcmp(argv[i], "-b") && i + 1 < argc)
             io.burst = std::stoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--prefetch") && i + 1 < argc)
+            io.prefetch = std::stoi(argv[++i]);
         else if (!std::strcmp(argv[i], "-r") && i + 1 < argc)
             run_seconds = std::stoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "-R") && i + 1 < argc)
+            io.sock_rcvbuf = std::stoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "-P") && i + 1 < argc)
+            io.sock_busy_poll_us = std::stoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "-Q") && i + 1 < argc) {
+            io.uring_sqpoll = true;
+            io.uring_sq_cpu = std::stoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "-x") && i + 1 < argc) {
+            const char* mode = argv[++i];
+            io.xdp_generic = !std::strcmp(mode, "generic");
+            io.xdp_zerocopy = !std::strcmp(mode, "native");
+        } else if (!std::strcmp(argv[i], "-N") && i + 1 < argc)
+            numa_node = std::stoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "-e") && i + 1 < argc)
+            rt.engine_core = std::stoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "-k") && i + 1 < argc)
+            rt.housekeeping_core = std::stoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--realtime"))
+            rt.enabled = true;
+        else if (!std::strcmp(argv[i], "--fifo") && i + 1 < argc)
+            rt.fifo_priority = std::stoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "-J") && i + 1 < argc)
+            stall_us = std::stoull(argv[++i]);
+        else if (!std::strcmp(argv[i], "-d") && i + 1 < argc) {
+            std::string err;
+            if (!decoders.configure(argv[++i], err)) {
+                std::fprintf(stderr, "-d: %s\n", err.c_str());
+                return 2;
+            }
+            const int port = std::atoi(argv[i]);
+            if (port) decoder_ports.push_back((uint16_t)port);
+        } else if (!std::strcmp(argv[i], "-I") && i + 1 < argc)
+            ifname_b = argv[++i];
+        else if (!std::strcmp(argv[i], "--conflate") && i + 1 < argc)
+            conflate_slots = std::stoul(argv[++i]);
+        else if (!std::strcmp(argv[i], "--control") && i + 1 < argc)
+            control_path = argv[++i];
+        else if (!std::strcmp(argv[i], "--shm") && i + 1 < argc)
+            shm_path = argv[++i];
+        else if (!std::strcmp(argv[i], "--shards") && i + 1 < argc)
+            shards = std::stoul(argv[++i]);
+        else if (!std::strcmp(argv[i], "--batch"))
+            batch = true;
+        else if (!std::strcmp(argv[i], "--fdr") && i + 1 < argc)
+            fdr_records = std::stoul(argv[++i]);
+        else if (!std::strcmp(argv[i], "--fdr-breach") && i + 1 < argc)
+            fdr_breach_us = std::stoull(argv[++i]);
+        else if (!std::strcmp(argv[i], "--fdr-dir") && i + 1 < argc)
+            fdr_dir = argv[++i];
+        else if (!std::strcmp(argv[i], "--inline"))
+            run_inline = true;
+        else if (!std::strcmp(argv[i], "--inline-tx"))
+            run_inline = inline_tx = true;
+        else if (!std::strcmp(argv[i], "--verify-csum"))
+            fc.verify_checksums = true;
+        else if (!std::strcmp(argv[i], "-W") && i + 1 < argc) {
+            if (!parse_wait_mode(argv[++i], wait_mode, wait_budget)) {
+                std::fprintf(stderr, "bad -W %s\n", argv[i]);
+                return 2;
+            }
+        }
         else {
             usage(argv[0]);
             return 2;
         }
     }
 
+    if (shards < 1 || shards > ShardSplitter::kMaxShards ||
+        (shards > 1 && !shm_path.empty())) {
+        std::fprintf(stderr, "--shards takes 1..%u in-process workers (not with --shm)\n",
+            ShardSplitter::kMaxShards);
+        return 2;
+    }
+    if (run_inline && (shards > 1 || !shm_path.empty() || !ifname_b.empty() ||
+                          conflate_slots)) {
+        std::fprintf(stderr,
+            "--inline runs without a tick ring (not with --shards, --shm, -I or "
+            "--conflate)\n");
+        return 2;
+    }
+
+#ifndef USE_NETMAP
+    if (backend_of(io.ifname) == IoBackend::Netmap) {
+        std::fprintf(stderr, "Build with -DUSE_NETMAP and netmap user libs.\n");
+        return 1;
+    }
+#endif
+
+    // Arbitration reads sequence numbers from every datagram, so every route
+    // must decode packed datagrams
+    if (!ifname_b.empty()) {
+        std::string err;
+        if (!decoders.routed()) decoders.configure("0=md14x", err);
+        if (!decoders.all_routes(DecoderKind::Md14Packed)) {
+            std::fprintf(stderr,
+                "-I needs md14x on every port: -d routes may only use md14x\n");
+            return 2;
+        }
+    }
+
+    // Decoders check record lengths themselves once anything but the fixed
+    // 14-byte feed is routed. Routes to other ports widen the frame filter to
+    // every port, so the registry then takes only the -p port and the routed
+    // ones and counts the rest as unrouted instead of decoding stray traffic
+    fc.payload_len = decoders.fixed_payload_len();
+    bool other_ports = false;
+    for (uint16_t port : decoder_ports) other_ports |= port != fc.udp_port;
+    if (fc.udp_port && other_ports) {
+        decoders.restrict_to_routes(fc.udp_port);
+        fc.udp_port = 0;
+        log_debug("Filter: any UDP port, decoders take -p and -d ports only");
+    }
+
     if (debug_enabled()) {
         log_debug("Config:");
         log_debug("  ifname         = %s", io.ifname.c_str());
+        log_debug("  backend        = %s", backend_name(backend_of(io.ifname)));
         log_debug("  udp_port       = %u", (unsigned)fc.udp_port);
+        log_debug("  verify_csum    = %d", (int)fc.verify_checksums);
         log_debug("  cpu_affinity   = %d", io.cpu_affinity);
         log_debug("  burst          = %d", io.burst);
+        log_debug("  prefetch       = %d", io.prefetch);
+        log_debug("  inline         = %d (tx %d)", (int)run_inline, (int)inline_tx);
+        log_debug("  fdr            = %zu entries, breach %llu us, dir %s", fdr_records,
+            (unsigned long long)fdr_breach_us, fdr_dir.c_str());
         log_debug("  run_seconds    = %d", run_seconds);
+        log_debug("  sock_rcvbuf    = %d", io.sock_rcvbuf);
+        log_debug("  sock_busy_poll = %d", io.sock_busy_poll_us);
+        log_debug("  uring_sqpoll   = %d (cpu %d)", (int)io.uring_sqpoll,
+            io.uring_sq_cpu);
+        log_debug("  xdp            = generic=%d zerocopy=%d", (int)io.xdp_generic,
+            (int)io.xdp_zerocopy);
+        log_debug("  realtime       = %d (engine core %d, housekeeping core %d, fifo %d)",
+            (int)rt.enabled, rt.engine_core, rt.housekeeping_core, rt.fifo_priority);
     }
 
-    // Create an SPSC ring for Ticks to be passed to TradingEngine
-    auto ring = std::make_shared<SpscRing<Tick, 4096> >();
+    // Lock memory before anything large is mapped so rings, netmap/UMEM areas
+    // and thread stacks are all resident before the first packet
+    rt.capture_core = io.cpu_affinity;
+    if (rt.enabled) realtime_lock_memory();
 
-    PacketCapture cap(io, fc);
+    // Per-hot-thread flight recorders, dumped on SIGUSR1, a breach or a crash
+    flight_recorder_init(fdr_records, fdr_breach_us * 1000, fdr_dir.c_str());
+
+    // Place hot-path memory on the NIC's node (or the capture core's node when
+    // the NIC's is unknown) and warn if -c put the capture thread off-node
+    const int nic_node = nic_numa_node(io.ifname);
+    const int core_node = cpu_numa_node(io.cpu_affinity);
+    if (numa_node == -2) numa_node = nic_node >= 0 ? nic_node : core_node;
+    if (nic_node >= 0 && core_node >= 0 && nic_node != core_node) {
+        std::fprintf(stderr,
+            "warning: -c %d is on NUMA node %d but %s is on node %d; every packet "
+            "will cross the socket interconnect\n",
+            io.cpu_affinity, core_node, io.ifname.c_str(), nic_node);
+    }
+
+    // Create an SPSC ring for Ticks to be passed to TradingEngine (one per
+    // worker with --shards), in this process or, with --shm, in another one
+    // (uspf_engine) through a named file; none with --inline
+    std::vector<std::shared_ptr<TradingEngine::Ring> > rings;
+    std::shared_ptr<ShmRing> shm;
+    if (run_inline) {
+        log_debug("Tick ring: none (run to completion)");
+    } else if (!shm_path.empty()) {
+        std::string err;
+        shm = ShmRing::create(shm_path, numa_node, err);
+        if (!shm) {
+            std::fprintf(stderr, "--shm: %s\n", err.c_str());
+            return 1;
+        }
+        rings.push_back(shm->ring());
+        log_debug("Tick ring: %s, %zu KB pages", shm_path.c_str(),
+            shm->page_size() >> 10);
+    } else {
+        HugeInfo ring_mem;
+        for (size_t i = 0; i < shards; ++i)
+            rings.push_back(make_shared_huge<TradingEngine::Ring>(numa_node, &ring_mem));
+        log_debug("Tick rings: %zu x %zu KB pages, node %d (wanted %d)", shards,
+            ring_mem.page_size >> 10, ring_mem.node, numa_node);
+    }
+
+    PacketCapture cap(io, fc, std::move(decoders));
+    if (!ifname_b.empty()) {
+        BypassConfig io_b = io;
+        io_b.ifname = ifname_b;
+        if (!cap.add_line_b(io_b)) {
+            std::fprintf(stderr, "cannot open B line %s\n", ifname_b.c_str());
+            return 1;
+        }
+    }
+    if (conflate_slots) cap.enable_conflation(conflate_slots);
 
     // Sanityb check: ingle pump with no-op; print why if it fails or returns 0
     log_debug("Performing sanity pump...");
@@ -113,22 +321,172 @@ int main(int argc, char** argv) {
         return 1;
     }
 
-    // Start the trading engine consumer
-    TradingEngine engine{ring};
-    engine.start();
+    std::printf("Capturing on %s (backend=%s)\n", io.ifname.c_str(),
+        backend_name(cap.backend()));
+    if (rt.enabled) realtime_report(rt, io.ifname);
+
+    // Start the trading engine consumers, one per ring, each with its own
+    // strategy state; worker i is pinned to -e core + i. With --shm there are
+    // none here: uspf_engine attaches instead, and since its wait mode is
+    // unknown, capture always signals the ring's shared eventcount.
+    std::vector<std::unique_ptr<TradingEngine> > engines;
+    std::vector<std::unique_ptr<MeanReversion> > strategies;
+    std::vector<std::string> engine_names(shards);
+    cap.jitter().set_threshold_ns(stall_us * 1000);
+    if (shm) {
+        cap.set_wakeup(shm->wakeup());
+        std::printf("Publishing ticks to %s (attach with uspf_engine %s)\n",
+            shm_path.c_str(), shm_path.c_str());
+    }
+    for (size_t i = 0; !shm && !run_inline && i < shards; ++i) {
+        engine_names[i] = shards == 1 ? "eng" : "eng" + std::to_string(i);
+        engines.push_back(
+            std::make_unique<TradingEngine>(rings[i], engine_names[i].c_str()));
+        strategies.push_back(std::make_unique<MeanReversion>());
+        TradingEngine& engine = *engines.back();
+        MeanReversion& strategy = *strategies.back();
+        if (batch) {
+            engine.set_batch_handler(
+                [&strategy](const TickBatch& b) { strategy.on_batch(b); });
+        }
+        engine.set_wait(wait_mode, wait_budget);
+        if (wait_mode == WaitMode::Block) cap.set_wakeup(engine.wakeup(), i);
+        engine.jitter().set_threshold_ns(stall_us * 1000);
+        engine.start(rt.engine_core < 0 ? -1 : rt.engine_core + (int)i, rt.fifo_priority);
+    }
 
     // Stats printer (delta pps/gbps)
-    uint64_t last_pkts = 0, last_bytes = 0;
+    uint64_t last_pkts = 0, last_bytes = 0, last_b_pkts = 0;
+    ArbiterStats last_arb{};
+    FilterDrops last_drops{}, last_drops_b{};
+    ConflationStats last_conf{};
+    std::vector<ShardStats> last_shards(shards), shard_now(shards);
+    std::vector<size_t> shard_depth(shards);
+    StrategyStats last_strat{};
+    WaitStats last_wait{};
+    InlineStats last_inline{};
+    uint64_t last_eng_cpu = 0;
+    auto last_wall = std::chrono::steady_clock::now();
+    const auto first_wall = last_wall;
+    PerfTotals last_cap_perf{}, last_eng_perf{};
+    Log2Histogram last_cap_gaps{};
+    std::vector<Log2Histogram> last_eng_gaps(engines.size());
+    auto last_rxq = std::make_unique<RxTelemetry>();
+    auto rxq = std::make_unique<RxTelemetry>();
     auto print_once = [&](bool final) {
         const auto& s = cap.stats();
         uint64_t dpkts = s.pkts - last_pkts;
         uint64_t dbytes = s.bytes - last_bytes;
         last_pkts = s.pkts;
         last_bytes = s.bytes;
-        std::printf("%sRX: %llu pkts  %llu bytes  drops=%llu  +%llu pps  +%.3f Gbps\n",
-            final ? "[final] " : "", (unsigned long long)s.pkts,
-            (unsigned long long)s.bytes, (unsigned long long)s.drops,
-            (unsigned long long)dpkts, (double)dbytes * 8.0 / 1e9);
+        std::printf(
+            "%sRX[%s]: %llu pkts  %llu bytes  drops=%llu  +%llu pps  +%.3f Gbps\n",
+            final ? "[final] " : "", backend_name(cap.backend()),
+            (unsigned long long)s.pkts, (unsigned long long)s.bytes,
+            (unsigned long long)s.drops, (unsigned long long)dpkts, (double)dbytes * 8.0 / 1e9);
+
+        // Why the filter dropped what it did, per reason (DROP_REASONS=1)
+        const FilterDrops drops = cap.filter_drops();
+        print_filter_drops("A", drops, last_drops, final);
+        last_drops = drops;
+
+        // B line and first-arrival arbitration (-I)
+        if (cap.arbitrated()) {
+            const auto& sb = cap.stats_b();
+            std::printf("%sRX-B[%s]: %llu pkts  %llu bytes  drops=%llu  +%llu pps\n",
+                final ? "[final] " : "", backend_name(cap.backend_b()),
+                (unsigned long long)sb.pkts, (unsigned long long)sb.bytes,
+                (unsigned long long)sb.drops, (unsigned long long)(sb.pkts - last_b_pkts));
+            last_b_pkts = sb.pkts;
+            const FilterDrops drops_b = cap.filter_drops_b();
+            print_filter_drops("B", drops_b, last_drops_b, final);
+            last_drops_b = drops_b;
+            const ArbiterStats arb = cap.arbiter();
+            print_arbiter(arb, last_arb, final);
+            last_arb = arb;
+        }
+
+        // Ticks collapsed per (instrument, side) while the ring was full
+        if (cap.conflating()) {
+            const ConflationStats conf = cap.conflation();
+            print_conflation(conf, last_conf, cap.conflation_pending(), final);
+            last_conf = conf;
+        }
+
+        // Shared ring consumer and backlog (--shm)
+        if (shm) print_shm_ring(*shm, final);
+
+        // Per-worker dispatch, queue depth and imbalance (--shards)
+        if (shards > 1) {
+            for (size_t i = 0; i < shards; ++i) {
+                shard_now[i] = cap.shard_stats(i);
+                shard_depth[i] = cap.shard_depth(i);
+            }
+            print_shards(shard_now.data(), last_shards.data(), shard_depth.data(), shards,
+                final);
+            last_shards = shard_now;
+        }
+
+        // RX ring occupancy / batch sizes / empty polls for this interval
+        *rxq = cap.rx_telemetry();
+        print_rx_telemetry(*rxq, *last_rxq, final);
+        std::swap(rxq, last_rxq);
+
+        // Hardware counter summary (only prints when built with PERF=1 and enabled)
+        const PerfTotals cap_perf = cap.perf();
+        PerfTotals eng_perf{};
+        for (const auto& e : engines) eng_perf = eng_perf + e->perf();
+        print_perf("cap", "pkt", cap_perf - last_cap_perf);
+        print_perf("eng", "tick", eng_perf - last_eng_perf);
+        last_cap_perf = cap_perf;
+        last_eng_perf = eng_perf;
+
+        // Mean reversion signals (--batch, --inline), summed over workers
+        if ((batch || run_inline) && !strategies.empty()) {
+            StrategyStats st{};
+            for (const auto& m : strategies) st += m->stats();
+            print_strategy(st, last_strat, final);
+            last_strat = st;
+        }
+
+        // Engine pop latency and CPU use under its wait mode (-W); with
+        // several workers, their merged latencies and summed CPU (can be >100%)
+        if (!engines.empty()) {
+            WaitStats ws{};
+            uint64_t cpu = 0;
+            for (const auto& e : engines) {
+                const WaitStats w = e->wait_stats();
+                ws.pop_latency.merge(w.pop_latency);
+                ws.decide_latency.merge(w.decide_latency);
+                ws.parks += w.parks;
+                ws.wakeups += w.wakeups;
+                cpu += e->cpu_ns();
+            }
+            const auto wall = std::chrono::steady_clock::now();
+            const auto dwall = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                wall - (final ? first_wall : last_wall));
+            print_wait(wait_mode, ws, last_wait, final ? cpu : cpu - last_eng_cpu,
+                (uint64_t)dwall.count(), final);
+            last_wait = ws;
+            last_eng_cpu = cpu;
+            last_wall = wall;
+        }
+
+        // RX-to-decision latency on the capture thread (--inline), the
+        // counterpart of the wait line's decide percentiles
+        if (run_inline) {
+            const InlineStats is = cap.inline_stats();
+            print_inline(is, last_inline, final);
+            last_inline = is;
+        }
+
+        // Stall log and loop-gap percentiles (-J)
+        report_jitter(cap.jitter(), last_cap_gaps, final);
+        for (size_t i = 0; i < engines.size(); ++i)
+            report_jitter(engines[i]->jitter(), last_eng_gaps[i], final);
+
+        // Per-decoder datagram/tick/error counts (-d)
+        if (final) cap.decoders().print_stats();
         std::fflush(stdout);
 
         if (debug_enabled()) {
@@ -149,10 +507,35 @@ int main(int argc, char** argv) {
         ? (std::chrono::steady_clock::now() + std::chrono::seconds(run_seconds))
         : std::chrono::time_point<std::chrono::steady_clock>::max();
 
-    // Start background capture owned by PacketCapture
+    // Start background capture owned by PacketCapture. With --inline the
+    // strategy runs inside its RX callback instead: decode, signal and (with
+    // --inline-tx) the order frame before the next packet is looked at.
     log_debug("Starting PacketCapture background thread (affinity=%d)...",
         io.cpu_affinity);
-    cap.start(ring, &g_running, end, io.cpu_affinity);
+    if (run_inline) {
+        strategies.push_back(std::make_unique<MeanReversion>());
+        MeanReversion& strategy = *strategies.back();
+        cap.start_inline(
+            [&strategy, &cap, inline_tx](const PacketView& v, const Tick* t, size_t n) {
+                for (size_t i = 0; i < n; ++i) {
+                    if (!strategy.on_tick(t[i]) || !inline_tx) continue;
+                    uint8_t frame[kOrderFrameMax];
+                    cap.tx(frame, build_order_frame(v, t[i], frame));
+                }
+            },
+            &g_running, end, io.cpu_affinity, rt.fifo_priority);
+    } else {
+        cap.start(rings, &g_running, end, io.cpu_affinity, rt.fifo_priority);
+    }
+
+    // Main thread and reporter stay off the hot cores (threads started above
+    // have already pinned themselves, so they do not inherit this)
+    pin_thread_to_core(rt.housekeeping_core);
+
+    // Live filter changes over a unix socket (--control)
+    FilterControl control(cap.filter(), control_path);
+    if (!control_path.empty() && control.start())
+        std::printf("Filter control on %s\n", control_path.c_str());
 
     // Background thread for logging
     std::thread reporter([&] {
@@ -166,20 +549,28 @@ int main(int argc, char** argv) {
     if (timed) {
         while (g_running && std::chrono::steady_clock::now() < end) {
             std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            flight_recorder_service();
         }
         g_running = false;
     } else {
-        while (g_running) { std::this_thread::sleep_for(std::chrono::milliseconds(100)); }
+        while (g_running) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            flight_recorder_service();
+        }
     }
 
     // Stop threads
     log_debug("Stopping PacketCapture and TradingEngine...");
     reporter.join();
+    control.stop();
     cap.stop();
-    engine.stop();
+    for (auto& e : engines) e->stop();
+    flight_recorder_service();
 
     print_once(true);
+
+    // ALLOC_AUDIT builds: a hot thread that allocated after warmup fails the run
+    if (alloc_audit_report() != 0) return 3;
     log_debug("Shutdown complete.");
     return 0;
-#endif
 }
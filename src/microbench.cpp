@@ -0,0 +1,1056 @@
+// Standalone hot-path microbenchmarks (make bench -> build/uspf_bench).
+//
+// Every case runs `warmup` untimed repetitions and then `reps` timed ones of
+// `ops` operations each, and reports the median ns/op, TSC cycles/op and
+// throughput, plus min/max/stddev across repetitions. Nothing here needs a
+// NIC; frames are synthesized into in-memory corpora.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "benchmarks.h"
+#include "bypass_io.h"
+#include "common.h"
+#include "conflation.h"
+#include "decoder_registry.h"
+#include "flight_recorder.h"
+#include "histogram.h"
+#include "inet_checksum.h"
+#include "instrument_stats.h"
+#include "packet_filter.h"
+#include "rx_prefetch.h"
+#include "shm_ring.h"
+#include "spsc_ring.h"
+#include "strategy.h"
+#include "tick_batch.h"
+#include "tick_shard.h"
+#include "trading_engine.h"
+
+namespace {
+
+struct BenchOpts {
+    int warmup = 3;
+    int reps = 10;
+    size_t ops = 1u << 20;
+    int core_a = -1;  // producer / main core
+    int core_b = -1;  // consumer core for cross-core cases
+    std::vector<std::string> only;  // case-name prefixes to run (empty = all)
+};
+
+// Accumulates wall time and TSC ticks over one or more start/stop windows, so
+// a case can exclude its own setup (e.g. refilling a ring) from the timing.
+struct Timer {
+    uint64_t ns = 0;
+    uint64_t cyc = 0;
+    std::chrono::steady_clock::time_point t0;
+    uint64_t c0 = 0;
+
+    void start() {
+        t0 = std::chrono::steady_clock::now();
+        c0 = rdtsc();
+    }
+    void stop() {
+        cyc += rdtsc() - c0;
+        ns += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - t0)
+                  .count();
+    }
+};
+
+// Sink to keep the optimizer from discarding benchmark bodies
+volatile uint64_t g_sink = 0;
+
+bool selected(const BenchOpts& o, const std::string& name) {
+    if (o.only.empty()) return true;
+    for (const auto& p : o.only) {
+        if (name.rfind(p, 0) == 0) return true;
+    }
+    return false;
+}
+
+void print_header() {
+    std::printf("%-30s %9s %9s %9s %7s %9s %10s\n", "case", "ns/op", "min", "max",
+        "sd", "cyc/op", "Mops/s");
+}
+
+/**
+ * @brief Run one case with warmup and repetitions, then print its statistics.
+ *
+ * @param name  case name (also used for prefix selection)
+ * @param o     options (warmup, reps)
+ * @param ops   operations per repetition (the ns/op denominator)
+ * @param body  workload; called as body(ops, timer) and must start/stop timer
+ */
+void run_case(const std::string& name, const BenchOpts& o, size_t ops,
+    const std::function<void(size_t, Timer&)>& body) {
+    if (!selected(o, name) || ops == 0) return;
+
+    for (int i = 0; i < o.warmup; ++i) {
+        Timer t;
+        body(ops, t);
+    }
+
+    std::vector<double> ns(o.reps), cyc(o.reps);
+    for (int i = 0; i < o.reps; ++i) {
+        Timer t;
+        body(ops, t);
+        ns[i] = (double)t.ns / (double)ops;
+        cyc[i] = (double)t.cyc / (double)ops;
+    }
+
+    std::vector<double> sorted = ns;
+    std::sort(sorted.begin(), sorted.end());
+    std::vector<double> csorted = cyc;
+    std::sort(csorted.begin(), csorted.end());
+    const double med = sorted[sorted.size() / 2];
+    double mean = 0, var = 0;
+    for (double v : ns) mean += v;
+    mean /= (double)ns.size();
+    for (double v : ns) var += (v - mean) * (v - mean);
+    const double sd = std::sqrt(var / (double)ns.size());
+
+    std::printf("%-30s %9.2f %9.2f %9.2f %7.2f %9.1f %10.2f\n", name.c_str(), med,
+        sorted.front(), sorted.back(), sd, csorted[csorted.size() / 2],
+        med > 0 ? 1e3 / med : 0.0);
+    std::fflush(stdout);
+}
+
+// ---------------------------------------------------------------------------
+// Synthetic frame corpora
+// ---------------------------------------------------------------------------
+
+enum class FrameKind {
+    Valid,
+    WrongPort,
+    NotIpv4,
+    NotUdp,
+    Short,
+    BadIhl,
+    BadUdpLen,
+    BadPayloadLen,
+    Truncated,
+};
+
+constexpr uint16_t kBenchPort = 5001;
+
+/**
+ * @brief Write one Ethernet/IPv4/UDP market data frame of the requested kind.
+ *
+ * @return frame length to present to the filter
+ */
+uint16_t build_frame(uint8_t* f, FrameKind kind, std::mt19937& rng) {
+    std::memset(f, 0, 64);
+    uint16_t port = kBenchPort;
+    uint16_t paylen = 14;
+    if (kind == FrameKind::WrongPort) port = (uint16_t)(kBenchPort + 1 + rng() % 1000);
+    if (kind == FrameKind::BadPayloadLen) paylen = 13;
+
+    // Ethernet
+    std::memset(f, 0xff, 6);
+    f[6] = 0x02;
+    f[12] = 0x08;
+    f[13] = kind == FrameKind::NotIpv4 ? 0xdd : 0x00;  // 0x86dd = IPv6
+    if (kind == FrameKind::NotIpv4) f[12] = 0x86;
+
+    // IPv4
+    uint8_t* ip = f + 14;
+    ip[0] = kind == FrameKind::BadIhl ? 0x43 : 0x45;
+    const uint16_t tot = (uint16_t)(20 + 8 + paylen);
+    ip[2] = (uint8_t)(tot >> 8);
+    ip[3] = (uint8_t)tot;
+    ip[8] = 64;
+    ip[9] = kind == FrameKind::NotUdp ? 6 : 17;
+
+    // UDP
+    uint8_t* udp = ip + 20;
+    udp[0] = 0x30;
+    udp[1] = 0x39;
+    udp[2] = (uint8_t)(port >> 8);
+    udp[3] = (uint8_t)port;
+    const uint16_t ulen = kind == FrameKind::BadUdpLen ? 4 : (uint16_t)(8 + paylen);
+    udp[4] = (uint8_t)(ulen >> 8);
+    udp[5] = (uint8_t)ulen;
+
+    // Payload: <u32 instr, u8 type, u8 side, f32 px, f32 qty> little-endian
+    uint8_t* payload = udp + 8;
+    const uint32_t instr = rng() & 0xFFFFFF;
+    const float px = 90.f + (float)(rng() % 2000) / 100.f;
+    const float qty = 1.f + (float)(rng() % 100);
+    std::memcpy(payload, &instr, 4);
+    payload[4] = (uint8_t)(rng() % 3);
+    payload[5] = (uint8_t)(rng() & 1);
+    std::memcpy(payload + 6, &px, 4);
+    std::memcpy(payload + 10, &qty, 4);
+
+    // Valid checksums, for the filter's verify_checksums cases
+    const uint16_t ip_csum = csum_finish(csum_partial(ip, 20, 0));
+    std::memcpy(ip + 10, &ip_csum, 2);
+    const uint16_t udp_csum =
+        udp_csum_finish(csum_partial(udp, 8u + paylen, udp_pseudo_sum(ip, udp + 4)));
+    std::memcpy(udp + 6, &udp_csum, 2);
+
+    uint16_t len = (uint16_t)(14 + 20 + 8 + paylen);
+    if (kind == FrameKind::Short) len = 12;
+    if (kind == FrameKind::Truncated) len = (uint16_t)(14 + 20 + 8 + 6);
+    return len;
+}
+
+struct Corpus {
+    static constexpr size_t kStride = 128;
+
+    std::string name;
+    std::vector<uint8_t> data;
+    std::vector<uint16_t> lens;
+
+    size_t size() const { return lens.size(); }
+    const uint8_t* frame(size_t i) const { return data.data() + i * kStride; }
+};
+
+/**
+ * @brief Build a corpus of n frames whose kinds are drawn from `kinds`.
+ *
+ * @param accept_pct percentage of Valid frames; the rest are drawn uniformly
+ *                   from the non-Valid entries of `kinds`
+ */
+Corpus make_corpus(const std::string& name, size_t n, int accept_pct,
+    const std::vector<FrameKind>& kinds) {
+    Corpus c;
+    c.name = name;
+    c.data.resize(n * Corpus::kStride);
+    c.lens.resize(n);
+    std::mt19937 rng(12345);
+    for (size_t i = 0; i < n; ++i) {
+        FrameKind k = FrameKind::Valid;
+        if ((int)(rng() % 100) >= accept_pct && !kinds.empty())
+            k = kinds[rng() % kinds.size()];
+        c.lens[i] = build_frame(c.data.data() + i * Corpus::kStride, k, rng);
+    }
+    return c;
+}
+
+std::vector<Corpus> make_corpora() {
+    constexpr size_t n = 4096;
+    std::vector<Corpus> v;
+    v.push_back(make_corpus("all-accept", n, 100, {}));
+    v.push_back(make_corpus("reject90", n, 10,
+        {FrameKind::WrongPort, FrameKind::WrongPort, FrameKind::WrongPort,
+            FrameKind::NotIpv4}));
+    v.push_back(make_corpus("malformed", n, 25,
+        {FrameKind::NotUdp, FrameKind::Short, FrameKind::BadIhl, FrameKind::BadUdpLen,
+            FrameKind::BadPayloadLen, FrameKind::Truncated}));
+    return v;
+}
+
+// ---------------------------------------------------------------------------
+// Cases
+// ---------------------------------------------------------------------------
+
+void bench_filter_decode(const BenchOpts& o, const std::vector<Corpus>& corpora) {
+    FilterConfig fc{};
+    fc.udp_port = kBenchPort;
+    PacketFilter filter(fc);
+
+    for (const auto& c : corpora) {
+        run_case("filter/" + c.name, o, o.ops, [&](size_t ops, Timer& t) {
+            const size_t mask = c.size() - 1;
+            uint64_t acc = 0;
+            t.start();
+            for (size_t i = 0; i < ops; ++i) {
+                const size_t k = i & mask;
+                acc += filter.accept(c.frame(k), c.lens[k]);
+            }
+            t.stop();
+            g_sink = g_sink + acc;
+        });
+    }
+
+    // classify() plus the per-reason counter pump_io() keeps; compare with
+    // filter/malformed (the add is empty under DROP_REASONS=0)
+    {
+        const Corpus& c = corpora.back();
+        FilterDrops drops{};
+        run_case("filter/" + c.name + "+reasons", o, o.ops, [&](size_t ops, Timer& t) {
+            const size_t mask = c.size() - 1;
+            uint64_t acc = 0;
+            t.start();
+            for (size_t i = 0; i < ops; ++i) {
+                const size_t k = i & mask;
+                const FilterVerdict v = filter.classify(c.frame(k), c.lens[k]);
+                drops.add(v);
+                acc += v == FilterVerdict::Accept;
+            }
+            t.stop();
+            g_sink = g_sink + acc;
+        });
+    }
+
+    // IPv4 header and UDP checksum verification on top of filter/all-accept
+    {
+        FilterConfig vc = fc;
+        vc.verify_checksums = true;
+        PacketFilter verify(vc);
+        const Corpus& c = corpora.front();
+        run_case("filter/all-accept+csum", o, o.ops, [&](size_t ops, Timer& t) {
+            const size_t mask = c.size() - 1;
+            uint64_t acc = 0;
+            t.start();
+            for (size_t i = 0; i < ops; ++i) {
+                const size_t k = i & mask;
+                acc += verify.accept(c.frame(k), c.lens[k]);
+            }
+            t.stop();
+            if (acc != ops) std::fprintf(stderr, "filter/all-accept+csum: rejects\n");
+            g_sink = g_sink + acc;
+        });
+    }
+
+    // Live reconfiguration: the all-accept corpus in 32-frame batches with a
+    // refresh() per batch as pump_io() does, while a writer thread republishes
+    // the same rules every 100 us; compare with filter/all-accept
+    {
+        const Corpus& c = corpora.front();
+        std::atomic<bool> stop{false};
+        std::thread writer([&] {
+            while (!stop.load(std::memory_order_relaxed)) {
+                filter.publish(fc);
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        });
+        run_case("filter/all-accept+swaps", o, o.ops, [&](size_t ops, Timer& t) {
+            const size_t mask = c.size() - 1;
+            uint64_t acc = 0;
+            t.start();
+            for (size_t i = 0; i < ops; ++i) {
+                if ((i & 31) == 0) filter.refresh();
+                const size_t k = i & mask;
+                acc += filter.accept(c.frame(k), c.lens[k]);
+            }
+            t.stop();
+            g_sink = g_sink + acc;
+        });
+        stop.store(true);
+        writer.join();
+    }
+
+    // Full per-packet path as in PacketCapture: filter + registry decode
+    DecoderRegistry md14;
+    for (const auto& c : corpora) {
+        run_case("decode/" + c.name, o, o.ops, [&](size_t ops, Timer& t) {
+            const size_t mask = c.size() - 1;
+            uint64_t acc = 0;
+            auto emit = [&](const Tick* ticks, size_t n) {
+                acc += ticks[n - 1].instr_id;
+            };
+            t.start();
+            for (size_t i = 0; i < ops; ++i) {
+                const size_t k = i & mask;
+                PacketView v{c.frame(k), c.lens[k], i};
+                if (filter.accept(v)) md14.decode(v, emit);
+            }
+            t.stop();
+            g_sink = g_sink + acc;
+        });
+    }
+
+    // Same feed through the table-driven decoder: the cost of the generic path
+    // over the compile-time Md14Layout
+    DecoderRegistry table;
+    std::string err;
+    table.configure(
+        "0=table:rec=14,instr=u32@0,type=u8@4,side=u8@5,px=f32@6,qty=f32@10", err);
+    const Corpus& c = corpora.front();
+    run_case("decode/table-" + c.name, o, o.ops, [&](size_t ops, Timer& t) {
+        const size_t mask = c.size() - 1;
+        uint64_t acc = 0;
+        auto emit = [&](const Tick* ticks, size_t n) { acc += ticks[n - 1].instr_id; };
+        t.start();
+        for (size_t i = 0; i < ops; ++i) {
+            const size_t k = i & mask;
+            PacketView v{c.frame(k), c.lens[k], i};
+            if (filter.accept(v)) table.decode(v, emit);
+        }
+        t.stop();
+        g_sink = g_sink + acc;
+    });
+}
+
+// Packed datagrams of 16 md14 records: ns/op is per record
+void bench_packed(const BenchOpts& o) {
+    constexpr size_t kRecs = 16, kDgrams = 1024;
+    constexpr size_t kLen = sizeof(PackedHeader) + kRecs * kRecordSize;
+    std::vector<uint8_t> data(kDgrams * kLen);
+    std::mt19937 rng(777);
+    for (size_t d = 0; d < kDgrams; ++d) {
+        uint8_t* p = data.data() + d * kLen;
+        const PackedHeader h{(uint32_t)d, 0, (uint16_t)kRecs};
+        std::memcpy(p, &h, sizeof(h));
+        for (size_t r = 0; r < kRecs; ++r) {
+            uint8_t* rec = p + sizeof(h) + r * kRecordSize;
+            const uint32_t instr = rng() & 0xFFFFFF;
+            const float px = 90.f + (float)(rng() % 2000) / 100.f, qty = 1.f;
+            std::memcpy(rec, &instr, 4);
+            rec[4] = (uint8_t)(rng() % 3);
+            rec[5] = (uint8_t)(rng() & 1);
+            std::memcpy(rec + 6, &px, 4);
+            std::memcpy(rec + 10, &qty, 4);
+        }
+    }
+
+    Tick out[kRecs];
+    auto kernel = [&](const char* name, auto decode) {
+        run_case(name, o, o.ops, [&](size_t ops, Timer& t) {
+            uint64_t acc = 0;
+            t.start();
+            for (size_t i = 0; i < ops; i += kRecs) {
+                const uint8_t* p = data.data() + ((i / kRecs) % kDgrams) * kLen;
+                acc += decode(p + sizeof(PackedHeader), kRecs, i, out);
+                acc += out[kRecs - 1].instr_id;
+            }
+            t.stop();
+            g_sink = g_sink + acc;
+        });
+    };
+    kernel("packed/records-scalar", decode_records_scalar);
+    kernel("packed/records-simd", decode_records);
+
+    // Whole registry path for payload-only views into the tick ring
+    DecoderRegistry reg;
+    std::string err;
+    reg.configure("0=md14x", err);
+    auto ring = std::make_unique<SpscRing<Tick, 4096> >();
+    run_case("packed/registry+push_bulk", o, o.ops, [&](size_t ops, Timer& t) {
+        uint64_t acc = 0;
+        Tick drain;
+        auto emit = [&](const Tick* ticks, size_t n) { ring->push_bulk(ticks, n); };
+        t.start();
+        for (size_t i = 0; i < ops; i += kRecs) {
+            const uint8_t* p = data.data() + ((i / kRecs) % kDgrams) * kLen;
+            reg.decode_payload(0, p, (uint16_t)kLen, i, emit);
+            while (ring->pop(drain)) acc += drain.instr_id;
+        }
+        t.stop();
+        g_sink = g_sink + acc;
+    });
+}
+
+// The 16-bit-at-a-time sum nm_md_sender used before csum_partial()
+uint16_t csum_scalar16(const uint8_t* d, size_t n) {
+    uint32_t sum = 0;
+    for (size_t i = 0; i + 1 < n; i += 2) sum += (uint16_t)(d[i] << 8 | d[i + 1]);
+    if (n & 1) sum += (uint16_t)(d[n - 1] << 8);
+    while (sum >> 16) sum = (sum & 0xffff) + (sum >> 16);
+    return (uint16_t)~sum;
+}
+
+// Checksum kernels alone, per header or datagram: a 20-byte IPv4 header and a
+// 1400-byte UDP datagram, old scalar loop vs csum_partial()
+void bench_checksum(const BenchOpts& o) {
+    constexpr size_t kBufs = 256, kStride = 1536;
+    std::vector<uint8_t> data(kBufs * kStride);
+    std::mt19937 rng(99);
+    for (auto& b : data) b = (uint8_t)rng();
+
+    for (size_t len : {(size_t)20, (size_t)1400}) {
+        const std::string what = len == 20 ? "ipv4-hdr" : "udp-1400B";
+        run_case("csum/" + what + " scalar16", o, o.ops, [&](size_t ops, Timer& t) {
+            uint64_t acc = 0;
+            t.start();
+            for (size_t i = 0; i < ops; ++i)
+                acc += csum_scalar16(data.data() + (i % kBufs) * kStride, len);
+            t.stop();
+            g_sink = g_sink + acc;
+        });
+        run_case("csum/" + what + " simd", o, o.ops, [&](size_t ops, Timer& t) {
+            uint64_t acc = 0;
+            t.start();
+            for (size_t i = 0; i < ops; ++i)
+                acc += csum_finish(csum_partial(data.data() + (i % kBufs) * kStride, len, 0));
+            t.stop();
+            g_sink = g_sink + acc;
+        });
+    }
+}
+
+// Flight recorder entries as the hot threads write them: one per packet (the
+// header stores and a frame snapshot of up to 96 bytes, plus a share of the
+// per-batch done stamp at burst 32) and one per engine drain (its TSC reads
+// are the pop latency's, so none here)
+void bench_flight_recorder(const BenchOpts& o, const Corpus& c) {
+    flight_recorder_init(1024, 0, "/tmp");
+    FlightRecorder pkts("bench", FlightRecorder::Kind::Packets);
+    FlightRecorder drains("bench", FlightRecorder::Kind::Drains);
+    pkts.begin_thread();
+    drains.begin_thread();
+    const size_t n = c.size();
+
+    run_case("fdr/packet " + c.name, o, o.ops, [&](size_t ops, Timer& t) {
+        const uint64_t tsc = rdtsc();
+        t.start();
+        uint64_t from = pkts.position();
+        for (size_t i = 0, j = 0; i < ops; ++i) {
+            pkts.packet(c.frame(j), c.lens[j], tsc, 0, 0, (uint32_t)j);
+            if (++j == n) j = 0;
+            if ((i & 31) == 31) {
+                pkts.end_batch(from);
+                from = pkts.position();
+            }
+        }
+        t.stop();
+    });
+
+    std::vector<Tick> ticks(1024);
+    for (size_t i = 0; i < ticks.size(); ++i)
+        ticks[i] = {rdtsc(), (uint32_t)i, 0, (uint8_t)(i & 1), 100.f, 1.f};
+    run_case("fdr/drain", o, o.ops, [&](size_t ops, Timer& t) {
+        t.start();
+        for (size_t i = 0; i < ops; ++i) {
+            const Tick& k = ticks[i & 1023];
+            drains.drain(k, k.ts_ns + 100, k.ts_ns + 200, 1, 0);
+        }
+        t.stop();
+    });
+}
+
+/**
+ * The netmap RX loop's rx_pipeline() over a synthetic ring: 4096 16-byte slots
+ * whose 2 KB buffers come back in shuffled order, as a NIC recycles them, each
+ * packet filtered, decoded and pushed to the tick ring (drained untimed).
+ * `cold` flushes each burst's slots and frames from the cache first, as a DMA
+ * write would leave them; `warm` leaves them where the previous lap did.
+ * Cases are named by burst (b) and prefetch distance (d); d0 is the old loop.
+ */
+void bench_rx_prefetch(const BenchOpts& o, const Corpus& c) {
+    struct Slot {
+        uint32_t buf_idx;
+        uint16_t len;
+        uint16_t flags;
+        uint64_t ptr;
+    };
+    constexpr uint32_t kSlots = 4096, kBufSize = 2048;
+    std::vector<Slot> slots(kSlots);
+    std::vector<uint8_t> pool((size_t)kSlots * kBufSize + 64);
+    uint8_t* bufs = pool.data() + (64 - ((uintptr_t)pool.data() & 63)) % 64;
+    std::vector<uint32_t> perm(kSlots);
+    for (uint32_t i = 0; i < kSlots; ++i) perm[i] = i;
+    std::shuffle(perm.begin(), perm.end(), std::mt19937(4242));
+    const size_t mask = c.size() - 1;
+    for (uint32_t s = 0; s < kSlots; ++s) {
+        slots[s] = Slot{perm[s], c.lens[s & mask], 0, 0};
+        std::memcpy(bufs + (size_t)perm[s] * kBufSize, c.frame(s & mask), c.lens[s & mask]);
+    }
+    auto buf_of = [&](const Slot& s) { return bufs + (size_t)s.buf_idx * kBufSize; };
+
+    FilterConfig fc{};
+    fc.udp_port = kBenchPort;
+    PacketFilter filter(fc);
+    DecoderRegistry md14;
+    auto ring = std::make_unique<SpscRing<Tick, 4096> >();
+
+    auto evict = [&](uint32_t cur, uint32_t n) {
+#if defined(__x86_64__)
+        for (uint32_t i = 0; i < n; ++i) {
+            const Slot& s = slots[(cur + i) & (kSlots - 1)];
+            _mm_clflush(buf_of(s));
+            if (s.len > 64) _mm_clflush(buf_of(s) + 64);
+            _mm_clflush(&s);
+        }
+        _mm_mfence();
+#else
+        (void)cur;
+        (void)n;
+#endif
+    };
+
+    struct Variant {
+        bool cold;
+        uint32_t burst;
+        uint32_t dist;
+    };
+    const Variant variants[] = {{true, 32, 0}, {true, 32, 4}, {true, 32, 8},
+        {true, 32, 16}, {true, 256, 0}, {true, 256, 4}, {true, 256, 8}, {true, 256, 16},
+        {false, 256, 0}, {false, 256, 8}};
+    for (const Variant& var : variants) {
+        const std::string name = std::string("rxpf/") + (var.cold ? "cold" : "warm") +
+            " b" + std::to_string(var.burst) + " d" + std::to_string(var.dist);
+        run_case(name, o, o.ops, [&](size_t ops, Timer& t) {
+            uint64_t acc = 0;
+            uint32_t cur = 0;
+            Tick drain;
+            auto emit = [&](const Tick* ticks, size_t n) { ring->push_bulk(ticks, n); };
+            auto slot = [&](uint32_t i) -> const Slot& {
+                return slots[(cur + i) & (kSlots - 1)];
+            };
+            for (size_t done = 0; done < ops; done += var.burst) {
+                if (var.cold) evict(cur, var.burst);
+                t.start();
+                rx_pipeline(
+                    var.burst, var.dist,
+                    [&](uint32_t i) { prefetch_line(&slot(i)); },
+                    [&](uint32_t i) { prefetch_frame(buf_of(slot(i)), slot(i).len); },
+                    [&](uint32_t i) {
+                        const Slot& s = slot(i);
+                        PacketView v{buf_of(s), s.len, i};
+                        if (filter.accept(v)) md14.decode(v, emit);
+                        return true;
+                    });
+                t.stop();
+                while (ring->pop(drain)) acc += drain.instr_id;
+                cur = (cur + var.burst) & (kSlots - 1);
+            }
+            g_sink = g_sink + acc;
+        });
+    }
+}
+
+void bench_ring(const BenchOpts& o) {
+    using Ring = SpscRing<Tick, 4096>;
+    auto ring = std::make_unique<Ring>();
+
+    run_case("ring/same-core push+pop", o, o.ops, [&](size_t ops, Timer& t) {
+        Tick in{}, out{};
+        uint64_t acc = 0;
+        t.start();
+        for (size_t i = 0; i < ops; ++i) {
+            in.ts_ns = i;
+            ring->push(in);
+            ring->pop(out);
+            acc += out.ts_ns;
+        }
+        t.stop();
+        g_sink = g_sink + acc;
+    });
+
+    run_case("ring/same-core burst64", o, o.ops, [&](size_t ops, Timer& t) {
+        Tick in{}, out{};
+        uint64_t acc = 0;
+        t.start();
+        for (size_t i = 0; i < ops; i += 64) {
+            for (size_t j = 0; j < 64; ++j) {
+                in.ts_ns = i + j;
+                ring->push(in);
+            }
+            for (size_t j = 0; j < 64; ++j) {
+                ring->pop(out);
+                acc += out.ts_ns;
+            }
+        }
+        t.stop();
+        g_sink = g_sink + acc;
+    });
+
+    run_case("ring/same-core push_bulk64", o, o.ops, [&](size_t ops, Timer& t) {
+        Tick in[64]{}, out{};
+        uint64_t acc = 0;
+        t.start();
+        for (size_t i = 0; i < ops; i += 64) {
+            in[0].ts_ns = i;
+            ring->push_bulk(in, 64);
+            for (size_t j = 0; j < 64; ++j) {
+                ring->pop(out);
+                acc += out.ts_ns;
+            }
+        }
+        t.stop();
+        g_sink = g_sink + acc;
+    });
+
+    // Backed-up ring: every tick goes through the conflation table, and the
+    // "consumer" frees room for a quarter of them, so ns/op is put() plus a
+    // share of flush() at a steady ~4:1 conflation over 1000 instruments
+    run_case("ring/conflate 1k instr", o, o.ops, [&](size_t ops, Timer& t) {
+        TickConflator conf(4096);
+        std::mt19937 rng(11);
+        std::vector<Tick> in(4096);
+        for (auto& x : in) {
+            x.instr_id = 1 + rng() % 1000;
+            x.side = (uint8_t)(rng() & 1);
+        }
+        Tick out{};
+        uint64_t acc = 0;
+        while (ring->pop(out)) {}
+        t.start();
+        for (size_t i = 0; i < ops; ++i) {
+            conf.put(in[i & 4095]);
+            if ((i & 63) == 63) {
+                conf.flush(*ring);
+                for (int j = 0; j < 16 && ring->pop(out); ++j) acc += out.instr_id;
+            }
+        }
+        t.stop();
+        while (ring->pop(out)) {}
+        g_sink = g_sink + acc;
+    });
+
+    // Producer on core_a, consumer (this thread) on core_b; ns/op is per item
+    // end to end, so it includes cache-line transfers between the two cores.
+    run_case("ring/cross-core", o, o.ops, [&](size_t ops, Timer& t) {
+        std::atomic<bool> go{false};
+        std::thread producer([&] {
+            pin_thread_to_core(o.core_a);
+            while (!go.load(std::memory_order_acquire)) {}
+            Tick in{};
+            for (size_t i = 0; i < ops; ++i) {
+                in.ts_ns = i;
+                while (!ring->push(in)) {}
+            }
+        });
+        pin_thread_to_core(o.core_b);
+        Tick out{};
+        uint64_t acc = 0;
+        t.start();
+        go.store(true, std::memory_order_release);
+        for (size_t i = 0; i < ops; ++i) {
+            while (!ring->pop(out)) {}
+            acc += out.ts_ns;
+        }
+        t.stop();
+        producer.join();
+        g_sink = g_sink + acc;
+    });
+    pin_thread_to_core(o.core_a);
+
+    // Dispatch stage for --shards 4: 64-tick datagrams over 1000 instruments
+    // split per worker (stable counting sort) and pushed with one publish per
+    // ring. Draining is untimed and checks that each ring's ticks, and so each
+    // instrument's, come out in arrival order.
+    run_case("ring/shard4 split64", o, o.ops, [&](size_t ops, Timer& t) {
+        std::vector<std::unique_ptr<Ring> > rings;
+        for (int i = 0; i < 4; ++i) rings.push_back(std::make_unique<Ring>());
+        ShardSplitter split(4);
+        std::mt19937 rng(5);
+        Tick in[64]{};
+        for (auto& x : in) x.instr_id = 1 + rng() % 1000;
+        uint64_t last[4] = {0, 0, 0, 0}, out_of_order = 0;
+        for (size_t i = 0; i < ops; i += 64) {
+            for (size_t j = 0; j < 64; ++j) in[j].ts_ns = i + j + 1;
+            t.start();
+            split.split(in, 64,
+                [&](uint32_t s, const Tick* p, size_t k) { rings[s]->push_bulk(p, k); });
+            t.stop();
+            for (int s = 0; s < 4; ++s) {
+                rings[s]->pop_bulk(64, [&](const Tick* p, size_t k) {
+                    for (size_t j = 0; j < k; ++j) {
+                        out_of_order += p[j].ts_ns <= last[s];
+                        last[s] = p[j].ts_ns;
+                    }
+                });
+            }
+        }
+        if (out_of_order) std::fprintf(stderr, "shard4: %llu ticks out of order\n",
+            (unsigned long long)out_of_order);
+    });
+
+    // The same ring in a /dev/shm file (ShmRing): same-core cost should match
+    // push_bulk64 above; cross-process forks a consumer that attaches by path
+    // and times end to end from the parent, like ring/cross-core
+    const std::string shm_path = "/dev/shm/uspf_bench." + std::to_string(::getpid());
+    std::string err;
+    auto shm = ShmRing::create(shm_path, -1, err);
+    if (!shm) {
+        std::fprintf(stderr, "ring/shm: %s\n", err.c_str());
+        return;
+    }
+    Ring* sr = shm->ring().get();
+
+    run_case("ring/shm push_bulk64", o, o.ops, [&](size_t ops, Timer& t) {
+        Tick in[64]{}, out{};
+        uint64_t acc = 0;
+        t.start();
+        for (size_t i = 0; i < ops; i += 64) {
+            in[0].ts_ns = i;
+            sr->push_bulk(in, 64);
+            for (size_t j = 0; j < 64; ++j) {
+                sr->pop(out);
+                acc += out.ts_ns;
+            }
+        }
+        t.stop();
+        g_sink = g_sink + acc;
+    });
+
+    run_case("ring/shm cross-process", o, o.ops, [&](size_t ops, Timer& t) {
+        const pid_t child = ::fork();
+        if (child == 0) {
+            pin_thread_to_core(o.core_b);
+            std::string e;
+            auto c = ShmRing::attach(shm_path, e);
+            if (!c) ::_exit(1);
+            Ring* cr = c->ring().get();
+            Tick out{};
+            for (size_t i = 0; i < ops; ++i) {
+                while (!cr->pop(out)) {}
+            }
+            c.reset();
+            ::_exit(0);
+        }
+        int status = 0;
+        while (!shm->consumer()) {
+            if (::waitpid(child, &status, WNOHANG) == child) return;  // attach failed
+            std::this_thread::yield();
+        }
+        Tick in{};
+        t.start();
+        for (size_t i = 0; i < ops; ++i) {
+            in.ts_ns = i;
+            while (!sr->push(in)) {}
+        }
+        ::waitpid(child, &status, 0);
+        t.stop();
+    });
+}
+
+// Discards everything written to it (engine output during the engine case)
+struct NullBuf : std::streambuf {
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+void bench_engine(const BenchOpts& o) {
+    auto ring = std::make_shared<TradingEngine::Ring>();
+    TradingEngine engine(ring);
+    const size_t chunk = ring->capacity();
+
+    std::mt19937 rng(7);
+    std::vector<Tick> ticks(chunk);
+    for (auto& t : ticks) {
+        t.instr_id = rng() & 0xFFFFFF;
+        t.instr_type = (uint8_t)(rng() % 3);
+        t.side = (uint8_t)(rng() & 1);
+        t.px = 90.f + (float)(rng() % 2000) / 100.f;
+        t.qty = 1.f + (float)(rng() % 100);
+    }
+
+    NullBuf null;
+    std::streambuf* old = std::cout.rdbuf(&null);
+
+    // Only run_once() is timed; refilling the ring happens outside the window
+    run_case("engine/run_once", o, o.ops, [&](size_t ops, Timer& t) {
+        for (size_t done = 0; done < ops; done += chunk) {
+            const size_t n = std::min(chunk, ops - done);
+            for (size_t i = 0; i < n; ++i) ring->push(ticks[i]);
+            t.start();
+            engine.run_once();
+            t.stop();
+        }
+    });
+
+    std::cout.rdbuf(old);
+}
+
+// Ticks for `instruments` instruments, quoting around 100 with some noise
+std::vector<Tick> make_tick_stream(size_t n, uint32_t instruments, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> noise(0.f, 0.5f);
+    std::vector<Tick> ticks(n);
+    for (auto& t : ticks) {
+        t.instr_id = 1 + rng() % instruments;
+        t.side = (uint8_t)(rng() & 1);
+        t.px = 100.f + noise(rng) + (t.side ? 0.05f : -0.05f);
+        t.qty = 1.f + (float)(rng() % 100);
+    }
+    return ticks;
+}
+
+// Mean reversion, per tick (AoS) vs per TickBatch (SoA). Both include the
+// InstrumentStats update; the ring cases add popping/transposing, the eval
+// cases run on ticks already in cache.
+void bench_strategy(const BenchOpts& o) {
+    using Ring = SpscRing<Tick, 4096>;
+    auto ring = std::make_unique<Ring>();
+    const size_t chunk = ring->capacity() & ~(TickBatch::kMax - 1);
+    const std::vector<Tick> ticks = make_tick_stream(chunk, 1000, 13);
+    auto batch = std::make_unique<TickBatch>();
+
+    // The two forms of the rule must agree on the same ticks
+    {
+        MeanReversion by_tick, by_batch;
+        for (const Tick& t : ticks) by_tick.on_tick(t);
+        for (size_t i = 0; i < chunk; i += TickBatch::kMax) {
+            batch->load(0, &ticks[i], TickBatch::kMax);
+            batch->n = TickBatch::kMax;
+            by_batch.on_batch(*batch);
+        }
+        if (by_tick.stats().buys != by_batch.stats().buys ||
+            by_tick.stats().sells != by_batch.stats().sells)
+            std::fprintf(stderr, "strategy: aos/soa signal mismatch\n");
+    }
+
+    MeanReversion aos, soa;
+    auto timed_drain = [&](size_t ops, Timer& t, auto&& drain) {
+        for (size_t done = 0; done < ops; done += chunk) {
+            const size_t n = std::min(chunk, ops - done);
+            ring->push_bulk(ticks.data(), n);
+            t.start();
+            drain();
+            t.stop();
+        }
+    };
+
+    run_case("strategy/ring per-tick", o, o.ops, [&](size_t ops, Timer& t) {
+        timed_drain(ops, t, [&] {
+            Tick x;
+            while (ring->pop(x)) aos.on_tick(x);
+        });
+    });
+
+    run_case("strategy/ring batch64", o, o.ops, [&](size_t ops, Timer& t) {
+        timed_drain(ops, t, [&] {
+            while (batch->fill(*ring)) soa.on_batch(*batch);
+        });
+    });
+
+    run_case("strategy/eval per-tick", o, o.ops, [&](size_t ops, Timer& t) {
+        t.start();
+        for (size_t i = 0, j = 0; i < ops; ++i) {
+            aos.on_tick(ticks[j]);
+            if (++j == chunk) j = 0;
+        }
+        t.stop();
+    });
+
+    // Pre-transposed, so this is update + vector rule only
+    std::vector<TickBatch> batches(chunk / TickBatch::kMax);
+    for (size_t j = 0; j < batches.size(); ++j) {
+        batches[j].load(0, &ticks[j * TickBatch::kMax], TickBatch::kMax);
+        batches[j].n = TickBatch::kMax;
+    }
+    run_case("strategy/eval batch64", o, o.ops, [&](size_t ops, Timer& t) {
+        t.start();
+        for (size_t i = 0, j = 0; i < ops; i += TickBatch::kMax) {
+            soa.on_batch(batches[j]);
+            if (++j == batches.size()) j = 0;
+        }
+        t.stop();
+    });
+
+    const StrategyStats &a = aos.stats(), &b = soa.stats();
+    g_sink = g_sink + a.buys + b.sells;
+}
+
+// InstrumentStats::update() back to back over a small and a large universe.
+// At 100K instruments the 3.2 MB state array plus 2 MB index no longer fit in
+// L2, so this is the per-tick consumer cost at production breadth.
+void bench_instrument_stats(const BenchOpts& o) {
+    for (uint32_t universe : {1000u, 100000u}) {
+        const std::vector<Tick> ticks = make_tick_stream(1u << 20, universe, 17);
+        InstrumentStats st(universe);
+        for (const Tick& t : ticks) st.update(t);  // assign every dense index
+        char name[64];
+        std::snprintf(name, sizeof(name), "stats/update %uk instr", universe / 1000);
+        run_case(name, o, o.ops, [&](size_t ops, Timer& t) {
+            t.start();
+            for (size_t i = 0; i < ops; ++i) st.update(ticks[i & (ticks.size() - 1)]);
+            t.stop();
+        });
+        g_sink = g_sink + st.size();
+    }
+
+    // Paced: 1M ticks/s over 100K instruments for one second, the rate the
+    // engine has to sustain. Between ticks the core idles, as a real consumer
+    // would, so each update is timed with whatever cache state that leaves.
+    if (!selected(o, "stats/paced")) return;
+    const std::vector<Tick> ticks = make_tick_stream(1u << 20, 100000, 19);
+    InstrumentStats st(100000);
+    Log2Histogram lat;
+    const double k = tsc_ns_per_tick();
+    const uint64_t period = (uint64_t)(1000.0 / k);  // 1 us in TSC ticks
+    uint64_t busy = 0, next = rdtsc();
+    const uint64_t t0 = next;
+    for (size_t i = 0; i < 1000000; ++i) {
+        while (rdtsc() < next) {}
+        const uint64_t c0 = rdtsc();
+        st.update(ticks[i & (ticks.size() - 1)]);
+        const uint64_t d = rdtsc() - c0;
+        lat.add(d);
+        busy += d;
+        next += period;
+    }
+    const double wall = (double)(rdtsc() - t0);
+    std::printf("stats/paced 1M/s 100k instr: p50<=%.0fns p99<=%.0fns p99.9<=%.0fns "
+                "max=%.0fns busy=%.1f%% of a core (%zu instruments)\n",
+        (double)lat.percentile(50) * k, (double)lat.percentile(99) * k,
+        (double)lat.percentile(99.9) * k, (double)lat.max * k,
+        100.0 * (double)busy / wall, st.size());
+}
+
+void usage(const char* prog) {
+    std::fprintf(stderr,
+        "Usage: %s [-w warmup] [-r reps] [-n ops] [-c core_a[,core_b]] [case-prefix...]\n"
+        "       %s rx <ifname> <seconds>   (live RX soak on any backend)\n"
+        "cases: filter/ decode/ packed/ csum/ rxpf/ fdr/ ring/ engine/ strategy/\n"
+        "       stats/\n",
+        prog, prog);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc >= 2 && !std::strcmp(argv[1], "rx")) {
+        if (argc < 4) {
+            usage(argv[0]);
+            return 2;
+        }
+        BypassConfig cfg{};
+        cfg.ifname = argv[2];
+        return run_rx_benchmark(cfg, std::atoi(argv[3]));
+    }
+
+    BenchOpts o;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "-w") && i + 1 < argc)
+            o.warmup = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "-r") && i + 1 < argc)
+            o.reps = std::max(1, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "-n") && i + 1 < argc)
+            o.ops = (size_t)std::strtoull(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "-c") && i + 1 < argc) {
+            const char* s = argv[++i];
+            o.core_a = std::atoi(s);
+            const char* comma = std::strchr(s, ',');
+            o.core_b = comma ? std::atoi(comma + 1) : o.core_a + 1;
+        } else if (argv[i][0] == '-') {
+            usage(argv[0]);
+            return 2;
+        } else {
+            o.only.push_back(argv[i]);
+        }
+    }
+
+    pin_thread_to_core(o.core_a);
+    if (std::thread::hardware_concurrency() < 2)
+        std::fprintf(stderr, "note: single CPU, ring/cross-core is time-sliced\n");
+
+    std::printf("warmup=%d reps=%d ops=%zu (ns/op and cyc/op are medians)\n",
+        o.warmup, o.reps, o.ops);
+    print_header();
+
+    const auto corpora = make_corpora();
+    bench_filter_decode(o, corpora);
+    bench_packed(o);
+    bench_checksum(o);
+    bench_rx_prefetch(o, corpora.front());
+    bench_flight_recorder(o, corpora.front());
+    bench_ring(o);
+    bench_engine(o);
+    bench_strategy(o);
+    bench_instrument_stats(o);
+    return 0;
+}
@@ -7,85 +7,12 @@
 #include <cstdlib>
 #include <cstring>
 #include "common.h"
+#include "realtime.h"
+#include "tick_decode.h"
 
 // forward declaration; implemented in bypass_io.cpp
 void pin_thread_to_core(int core);
 
-/**
- * @brief Locate UDP payload of exactly 14 bytes in a raw Ethernet frame.
- *
- * Assumes Ethernet + IPv4 + UDP. Validates lengths and boundaries.
- *
- * @param p pointer to the start of the Ethernet frame
- * @param len length of p
- * @param out output pointer to the start of the UDP payload (if found)
- * @return true if found and out is set
- * @return false if not found or invalid
- */
-inline bool locate_udp_payload_14(const uint8_t* p, uint16_t len, const uint8_t*& out) {
-    // L2: Ethernet
-    if (!p || len < 14 + 20 + 8) return false;
-    const uint16_t etype = (uint16_t(p[12]) << 8) | uint16_t(p[13]);
-    if (etype != 0x0800) return false;
-
-    // L3: IPv4 + UDP
-    const uint8_t* ip = p + 14;
-    const uint8_t ihl = (ip[0] & 0x0F) * 4;
-    if (ihl < 20 || len < 14 + ihl + 8) return false;
-    if (ip[9] != 17) return false;
-
-    // L4: UDP + payload
-    const uint8_t* udp = ip + ihl;
-    const uint16_t ulen = (uint16_t(udp[4]) << 8) | uint16_t(udp[5]);
-    if (ulen < 8) return false;
-    const uint16_t paylen = ulen - 8;
-    if (paylen != 14) return false;
-    const uint8_t* payload = udp + 8;
-    if ((payload + 14) > (p + len)) return false;
-    out = payload;
-
-    return true;
-}
-
-/**
- * @brief Decode a Tick from a UDP payload of exactly 14 bytes.
- *
- * Expects the payload to be located and validated by locate_udp_payload_14().
- *
- * @param p pointer to the start of the Ethernet frame
- * @param len length of p
- * @param tsc timestamp to set in the Tick
- * @param out output Tick to populate
- * @return true if successful
- * @return false if not successful (e.g., payload not found)
- */
-inline bool decode_tick_from_packet(const uint8_t* p, uint16_t len, uint64_t tsc,
-    Tick& out) {
-    const uint8_t* payload = nullptr;
-
-    // If it's not a valid UDP payload of 14 bytes, return false
-    if (!locate_udp_payload_14(p, len, payload)) return false;
-
-    uint32_t instr_id = 0;
-    uint8_t instr_type = 0;
-    uint8_t side = 0;
-    float px = 0.f, qty = 0.f;
-
-    // We assume little-endian host; memcpy to avoid alignment issues
-    std::memcpy(&instr_id, payload + 0, 4);
-    std::memcpy(&instr_type, payload + 4, 1);
-    std::memcpy(&side, payload + 5, 1);
-    std::memcpy(&px, payload + 6, 4);
-    std::memcpy(&qty, payload + 10, 4);
-    out.ts_ns = tsc;
-    out.instr_id = instr_id;
-    out.instr_type = instr_type;
-    out.side = side;
-    out.px = px;
-    out.qty = qty;
-    return true;
-}
-
 // Local debug helpers (opt-in via USPF_DEBUG=1)
 static bool debug_enabled() {
     static bool enabled = std::getenv("USPF_DEBUG") != nullptr;
@@ -122,16 +49,69 @@ static void log_debug(const char* fmt, ...) {
  *
  * @param io_cfg config for BypassIO
  * @param f_cfg config for PacketFilter
+ * @param decoders port -> decoder routing, fully configured
  */
-PacketCapture::PacketCapture(const BypassConfig& io_cfg, const FilterConfig& f_cfg)
-    : io_(io_cfg), filter_(f_cfg) {
+PacketCapture::PacketCapture(const BypassConfig& io_cfg, const FilterConfig& f_cfg,
+    DecoderRegistry decoders)
+    : io_(io_cfg), filter_(f_cfg), decoders_(std::move(decoders)) {
     if (debug_enabled()) {
-        log_debug("ctor: ifname=%s burst=%d cpu_affinity=%d udp_port=%u",
-            io_cfg.ifname.c_str(), io_cfg.burst, io_cfg.cpu_affinity,
-            (unsigned)f_cfg.udp_port);
+        log_debug("ctor: ifname=%s backend=%s burst=%d cpu_affinity=%d udp_port=%u",
+            io_cfg.ifname.c_str(), backend_name(io_.backend()), io_cfg.burst,
+            io_cfg.cpu_affinity, (unsigned)f_cfg.udp_port);
     }
 }
 
+/**
+ * @brief Open the B line of an A/B pair and enable arbitration.
+ *
+ * @param cfg BypassConfig for the B line (typically A's with another ifname)
+ * @return true if the B line is ready
+ */
+bool PacketCapture::add_line_b(const BypassConfig& cfg) {
+    io_b_ = std::make_unique<BypassIO>(cfg);
+    if (!io_b_->ok()) {
+        io_b_.reset();
+        return false;
+    }
+    arbiter_ = std::make_unique<FeedArbiter>();
+    if (debug_enabled())
+        log_debug("add_line_b: ifname=%s backend=%s", cfg.ifname.c_str(),
+            backend_name(io_b_->backend()));
+    return true;
+}
+
+/**
+ * @brief Put ticks that do not fit in the ring into a conflation table instead
+ *        of dropping them.
+ *
+ * @param slots table size; at least the number of distinct (instrument, side)
+ *              keys expected while the consumer is behind
+ */
+void PacketCapture::enable_conflation(size_t slots) {
+    conflate_slots_ = slots;
+    if (debug_enabled())
+        log_debug("enable_conflation: slots=%zu", slots);
+}
+
+ConflationStats PacketCapture::conflation() const {
+    ConflationStats sum{};
+    for (const auto& c : conflators_) {
+        const ConflationStats& s = c->stats();
+        sum.episodes += s.episodes;
+        sum.absorbed += s.absorbed;
+        sum.overwritten += s.overwritten;
+        sum.flushed += s.flushed;
+        sum.dropped += s.dropped;
+    }
+    return sum;
+}
+
+size_t PacketCapture::conflation_pending() const {
+    size_t n = 0;
+    for (const auto& c : conflators_) n += c->pending();
+    return n;
+}
+
 /**
  * @brief Start background capture thread that pumps packets from NIC → filter → SPSC ring.
  *
@@ -139,12 +119,43 @@ PacketCapture::PacketCapture(const BypassConfig& io_cfg, const FilterConfig& f_c
  * @param running_flag External atomic<bool> flag to control lifetime (may be nullptr)
  * @param end Time point to stop capturing (pass max() if not timed)
  * @param cpu_affinity Core to pin the capture thread (-1 = no pin)
+ * @param rt_priority SCHED_FIFO priority for the capture thread (0 = SCHED_OTHER)
  */
 void PacketCapture::start(std::shared_ptr<Ring> ring, std::atomic<bool>* running_flag,
-    std::chrono::time_point<std::chrono::steady_clock> end, int cpu_affinity) {
+    std::chrono::time_point<std::chrono::steady_clock> end, int cpu_affinity,
+    int rt_priority) {
+    std::vector<std::shared_ptr<Ring>> rings;
+    rings.push_back(std::move(ring));
+    start(std::move(rings), running_flag, end, cpu_affinity, rt_priority);
+}
+
+/**
+ * @brief Start the capture thread with a dispatch stage to several rings.
+ *
+ * @param rings one SPSC ring per engine worker (1..ShardSplitter::kMaxShards)
+ * @param running_flag External atomic<bool> flag to control lifetime (may be nullptr)
+ * @param end Time point to stop capturing (pass max() if not timed)
+ * @param cpu_affinity Core to pin the capture thread (-1 = no pin)
+ * @param rt_priority SCHED_FIFO priority for the capture thread (0 = SCHED_OTHER)
+ */
+void PacketCapture::start(std::vector<std::shared_ptr<Ring>> rings,
+    std::atomic<bool>* running_flag,
+    std::chrono::time_point<std::chrono::steady_clock> end, int cpu_affinity,
+    int rt_priority) {
+    if (rings.empty() || rings.size() > ShardSplitter::kMaxShards) return;
     bool expected = false;
     if (!running_.compare_exchange_strong(expected, true)) return;
 
+    // Per-ring state is sized here, before the thread exists, so the reporter
+    // can read it without synchronization
+    rings_ = std::move(rings);
+    shard_stats_.assign(rings_.size(), ShardStats{});
+    wakeups_.resize(rings_.size(), nullptr);
+    conflators_.clear();
+    if (conflate_slots_)
+        for (size_t i = 0; i < rings_.size(); ++i)
+            conflators_.push_back(std::make_unique<TickConflator>(conflate_slots_));
+
     if (debug_enabled()) {
         log_debug(
             "start: launching producer thread (affinity=%d, until steady_clock=%lld)",
@@ -154,8 +165,8 @@ void PacketCapture::start(std::shared_ptr<Ring> ring, std::atomic<bool>* running
                 .count());
     }
 
-    worker_ = std::thread(&PacketCapture::thread_main, this, std::move(ring),
-        running_flag, end, cpu_affinity);
+    worker_ = std::thread(&PacketCapture::thread_main, this, running_flag, end,
+        cpu_affinity, rt_priority);
 }
 
 void PacketCapture::stop() {
@@ -175,14 +186,16 @@ void PacketCapture::stop() {
  * @brief Drain packets from the RX ring, apply filter rules, and invoke a callback
  *        for each accepted packet.
  *
- * This method pulls a batch of packets from the underlying I/O layer (netmap).
+ * This method pulls a batch of packets from the underlying I/O layer (netmap or
+ * the kernel socket backend).
  * Each packet is wrapped in a PacketView and passed through the configured
  * PacketFilter. If the filter accepts the packet, the user-supplied callback
  * (cb) is invoked. The callback pushes decoded packets into a downstream queue.
  *
  * Control flow:
- *  - If `filter_.accept()` returns false, the packet is counted as dropped
- *    (filtered) and not passed to the callback.
+ *  - If `filter_.classify()` is not Accept, the packet is counted as dropped
+ *    (filtered), under its verdict in filter_drops(), and not passed to the
+ *    callback.
  *  - If the callback `cb(v)` returns false, draining stops early and pump()
  *    returns immediately. This allows downstream components to signal backpressure
  *    or early termination.
@@ -201,40 +214,68 @@ void PacketCapture::stop() {
  *   - <0 : error occurred in the I/O layer
  */
 int PacketCapture::pump(const std::function<bool(const PacketView&)>& cb) {
-    if (!io_.ok()) {
-        if (debug_enabled()) log_debug("pump: io_.ok() == false (device not open/ready)");
+    return pump_io(io_, stats_, filter_drops_, cb);
+}
+
+// pump() body for either line; `st` and `fd` are that line's counters
+int PacketCapture::pump_io(BypassIO& io, Stats& st, FilterDrops& fd,
+    const std::function<bool(const PacketView&)>& cb) {
+    if (!io.ok()) {
+        if (debug_enabled()) log_debug("pump: io.ok() == false (device not open/ready)");
         return -1;
     }
 
-    // Per-pump local counters for visibility
-    uint64_t accepted = 0;
-    uint64_t filtered = 0;
+    // Pick up rules published since the last batch (live reconfiguration)
+    filter_.refresh();
+
+    // Per-pump state, including local counters for visibility. The callback
+    // captures only a reference to it, so converting it to the std::function
+    // rx_batch() takes fits the small-object buffer and never allocates.
+    struct PumpCtx {
+        PacketFilter& filter;
+        const std::function<bool(const PacketView&)>& cb;
+        Stats& st;
+        FilterDrops& drops;
+        FlightRecorder* fdr;  // null when off
+        const uint32_t& depth;
+        uint8_t line;
+        uint64_t accepted;
+        uint64_t filtered;
+    } c{filter_, cb, st, fd, fdr_.on() ? &fdr_ : nullptr, fdr_depth_,
+        (uint8_t)(&io == &io_ ? 0 : 1), 0, 0};
 
     // accepted_cb wraps filtering so that rejection does not stop draining.
     // Return value contract:
     //   - return true  => keep draining the ring
     //   - return false => request early stop (fatal/budget/shutdown)
-    auto accepted_cb = [&](const PacketView& v) -> bool {
-        if (filter_.accept(v.data, v.len)) {
-            ++accepted;
+    auto accepted_cb = [&c](const PacketView& v) -> bool {
+        const FilterVerdict verdict = c.filter.classify(v);
+        bool more = true;
+        if (verdict == FilterVerdict::Accept) {
+            ++c.accepted;
             // cb(v) may push to the downstream SPSC ring.
             // cb(v)==false means: "stop draining RX now because something went wrong"
-            if (!cb(v)) return false;
+            more = c.cb(v);
         } else {
-            ++filtered;
-            ++stats_.drops;
+            ++c.filtered;
+            ++c.st.drops;
+            c.drops.add(verdict);
         }
-        return true;
+        // Every packet, with its verdict and how long it took to get through
+        if (c.fdr) c.fdr->packet(v.data, v.len, v.tsc, (uint8_t)verdict, c.line, c.depth);
+        return more;
     };
 
     // Drain a batch of packets from the RX ring, applying filtering and
     // invoking accepted_cb for each accepted packet.
-    int got = io_.rx_batch(accepted_cb);
+    const uint64_t fdr_from = c.fdr ? c.fdr->position() : 0;
+    int got = io.rx_batch(accepted_cb);
+    if (c.fdr) c.fdr->end_batch(fdr_from);
 
     // Aggregate stats from IO
-    auto ios = io_.stats();
-    stats_.pkts = ios.pkts;
-    stats_.bytes = ios.bytes;
+    auto ios = io.stats();
+    st.pkts = ios.pkts;
+    st.bytes = ios.bytes;
 
     if (debug_enabled()) {
         if (got < 0) {
@@ -246,7 +287,7 @@ int PacketCapture::pump(const std::function<bool(const PacketView&)>& cb) {
                 log_debug("pump: rx_batch got=%d, accepted=%" PRIu64 ", filtered=%" PRIu64
                           ", io_drops=%" PRIu64 ", agg_pkts=%" PRIu64
                           ", agg_bytes=%" PRIu64,
-                    got, accepted, filtered, ios.drops, stats_.pkts, stats_.bytes);
+                    got, c.accepted, c.filtered, ios.drops, st.pkts, st.bytes);
             }
         }
     }
@@ -259,8 +300,9 @@ int PacketCapture::pump(const std::function<bool(const PacketView&)>& cb) {
  * Runs the high-frequency RX loop on a dedicated core. The thread
  *  1) Optionally pins itself to @p cpu_affinity
  *  2) Builds a fast-path lambda `to_tick_and_push` that decodes a Tick from
- *     each accepted packet and pushes it into the SPSC ring (records
- *     backpressure if the push fails).
+ *     each accepted packet and pushes it into the SPSC ring, or with several
+ *     rings into the one owning its instrument (records backpressure if the
+ *     push fails).
  *  3) Repeatedly calls pump(to_tick_and_push) until:
  *        - @p running_ becomes false (internal stop),
  *        - @p running_flag is unset by the owner (external stop), or
@@ -275,50 +317,124 @@ int PacketCapture::pump(const std::function<bool(const PacketView&)>& cb) {
  *  - Debug logging is rate-limited but still on this thread; avoid enabling it
  *    for peak-throughput measurements.
  *
- * @param ring          Shared pointer to the SPSC ring used to enqueue decoded ticks.
  * @param running_flag  Optional external stop flag (owned by caller). If non-null and becomes false, the loop terminates.
  * @param end           Absolute steady_clock deadline. When reached, the loop exits.
  * @param cpu_affinity  Core index to pin this thread to (>=0 pins, <0 leaves default).
+ * @param rt_priority   SCHED_FIFO priority (0 = SCHED_OTHER).
  */
-void PacketCapture::thread_main(std::shared_ptr<Ring> ring,
-    std::atomic<bool>* running_flag,
-    std::chrono::time_point<std::chrono::steady_clock> end, int cpu_affinity) {
-    // Pin thread to a core close to the NIC NUMA node
-    if (cpu_affinity >= 0) {
-        if (debug_enabled()) log_debug("thread_main: pinning to core %d", cpu_affinity);
-        pin_thread_to_core(cpu_affinity);
+void PacketCapture::thread_main(std::atomic<bool>* running_flag,
+    std::chrono::time_point<std::chrono::steady_clock> end, int cpu_affinity,
+    int rt_priority) {
+    // One lane per engine ring: the ring, its conflation table, its wakeup
+    // and its counters (which also explain *why* ticks might not get through)
+    struct Lane {
+        Ring* ring;
+        TickConflator* conf;
+        ConsumerWakeup* wakeup;
+        ShardStats* st;
+        uint64_t pushed_before;
+    };
+    std::vector<Lane> lanes;
+    for (size_t i = 0; i < rings_.size(); ++i) {
+        TickConflator* conf = conflators_.empty() ? nullptr : conflators_[i].get();
+        lanes.push_back({rings_[i].get(), conf, wakeups_[i], &shard_stats_[i], 0});
     }
+    const bool sharded = lanes.size() > 1;
+    auto lane_totals = [&lanes](uint64_t& pushed, uint64_t& dropped) {
+        pushed = dropped = 0;
+        for (const Lane& l : lanes) {
+            pushed += l.st->ticks;
+            dropped += l.st->drops;
+        }
+    };
+    ShardSplitter splitter((uint32_t)lanes.size());
 
-    // Counters to explain *why* we might not be passing ticks downstream
-    uint64_t ring_backpressure = 0;
-    uint64_t ticks_pushed = 0;
-
-    // Fast path callback: PacketView -> Tick -> push to SPSC
+    // Fast path callback: PacketView -> decoder -> a datagram's Ticks -> SPSC,
+    // published with one tail store per datagram (per ring, when sharded).
+    // With conflation, whatever does not fit goes to the table, and so does
+    // everything after it until the table drains, so the ring never gets
+    // ahead of a pending tick.
+    auto push_lane = [this](Lane& l, const Tick* t, size_t n) {
+        size_t pushed = 0;
+        if (!l.conf || !l.conf->active()) {
+            pushed = l.ring->push_bulk(t, n);
+            l.st->ticks += pushed;
+            fdr_depth_ = (uint32_t)l.ring->size();
+            if (pushed == n) return;
+        }
+        if (!l.conf) {
+            l.st->drops += n - pushed;
+            return;
+        }
+        for (size_t i = pushed; i < n; ++i) l.conf->put(t[i]);
+    };
+    auto push_ticks = [&](const Tick* t, size_t n) {
+        if (!sharded) {
+            push_lane(lanes[0], t, n);
+            return;
+        }
+        splitter.split(t, n,
+            [&](uint32_t s, const Tick* run, size_t k) { push_lane(lanes[s], run, k); });
+    };
     auto to_tick_and_push = [&](const PacketView& v) -> bool {
-        Tick t{};
-        if (!decode_tick_from_packet(v.data, v.len, v.tsc, t)) return true;
-        if (!ring->push(t))
-            ++ring_backpressure;
-        else
-            ++ticks_pushed;
+        decoders_.decode(v, push_ticks);
         return true;
     };
 
+    // With a B line, each datagram passes the arbiter first: only the first
+    // copy of a sequence number reaches the decoders
+    auto arbitrated_line = [&](FeedLine line) {
+        return [&, line](const PacketView& v) -> bool {
+            const uint8_t* payload = nullptr;
+            uint16_t len = 0, dport = 0;
+            if (!view_payload(v, payload, len, dport)) len = 0;
+            if (arbiter_->on_datagram(line, payload, len, v.tsc))
+                decoders_.decode_payload(dport, payload, len, v.tsc, push_ticks);
+            return true;
+        };
+    };
+    const std::function<bool(const PacketView&)> line_a = arbitrated_line(FeedLine::A);
+    const std::function<bool(const PacketView&)> line_b = arbitrated_line(FeedLine::B);
+
+    thread_begin(cpu_affinity, rt_priority);
+
     // Main capture loop
     auto last_report = std::chrono::steady_clock::now();
 
-    while (running_.load(std::memory_order_relaxed) && running_flag &&
-        running_flag->load(std::memory_order_relaxed) &&
-        std::chrono::steady_clock::now() < end) {
+    while (keep_running(running_flag, end)) {
+        jitter_.tick();
+        audit_.tick();
+        fdr_.tick();
+
+        // Conflated ticks go first, as the ring has room for them
+        for (Lane& l : lanes) {
+            l.pushed_before = l.st->ticks;
+            if (l.conf && l.conf->active()) l.st->ticks += l.conf->flush(*l.ring);
+        }
 
         // Pump packets from NIC → filter → SPSC ring
-        int got = pump(to_tick_and_push);
+        perf_.begin();
+        int got;
+        if (io_b_) {
+            got = pump_io(io_, stats_, filter_drops_, line_a);
+            const int got_b = pump_io(*io_b_, stats_b_, filter_drops_b_, line_b);
+            if (got_b > 0) got = (got > 0 ? got : 0) + got_b;
+        } else {
+            got = pump(to_tick_and_push);
+        }
+        perf_.end(got > 0 ? (uint64_t)got : 0);
+
+        // Wake a parked engine (WaitMode::Block)
+        for (Lane& l : lanes)
+            if (l.wakeup && l.st->ticks != l.pushed_before) l.wakeup->notify();
 
         // Periodic debug summary (once per ~500ms)
         if (debug_enabled()) {
             auto now = std::chrono::steady_clock::now();
             if (now - last_report >= std::chrono::milliseconds(2000)) {
                 auto ios = io_.stats();
+                uint64_t ticks_pushed, ring_backpressure;
+                lane_totals(ticks_pushed, ring_backpressure);
                 log_debug("loop: got=%d | pushed=%" PRIu64 " backpressure=%" PRIu64
                           " | io_pkts=%" PRIu64 " io_bytes=%" PRIu64 " io_drops=%" PRIu64,
                     got, ticks_pushed, ring_backpressure, ios.pkts, ios.bytes, ios.drops);
@@ -337,14 +453,50 @@ void PacketCapture::thread_main(std::shared_ptr<Ring> ring,
         }
     }
 
-    // Ensure final stats snapshot
-    auto ios = io_.stats();
-    stats_.pkts = ios.pkts;
-    stats_.bytes = ios.bytes;
+    thread_end();
 
     if (debug_enabled()) {
+        uint64_t ticks_pushed, ring_backpressure;
+        lane_totals(ticks_pushed, ring_backpressure);
         log_debug("thread_main: exit summary: pushed=%" PRIu64 ", backpressure=%" PRIu64
                   ", final_pkts=%" PRIu64 ", final_bytes=%" PRIu64,
             ticks_pushed, ring_backpressure, stats_.pkts, stats_.bytes);
     }
 }
+
+void PacketCapture::thread_begin(int cpu_affinity, int rt_priority) {
+    // Pin thread to a core close to the NIC NUMA node
+    if (cpu_affinity >= 0) {
+        if (debug_enabled()) log_debug("thread_begin: pinning to core %d", cpu_affinity);
+        pin_thread_to_core(cpu_affinity);
+    }
+    realtime_thread_init("capture", rt_priority);
+    perf_.open("cap");
+
+    // Stall context: tick ring occupancy (all rings, none when run to
+    // completion) and frames still in RX
+    jitter_.set_probes(
+        [this] {
+            int64_t n = 0;
+            for (const auto& r : rings_) n += (int64_t)r->size();
+            return n;
+        },
+        [this] { return (int64_t)io_.rx_backlog(); });
+    jitter_.begin_thread();
+    fdr_.begin_thread();
+    audit_.begin("cap");
+}
+
+void PacketCapture::thread_end() {
+    audit_.end();
+    perf_.close();
+
+    // Ensure final stats snapshot
+    auto ios = io_.stats();
+    stats_.pkts = ios.pkts;
+    stats_.bytes = ios.bytes;
+    if (io_b_) {
+        stats_b_.pkts = io_b_->stats().pkts;
+        stats_b_.bytes = io_b_->stats().bytes;
+    }
+}
@@ -1,9 +1,11 @@
 #include "packet_filter.h"
 #include <arpa/inet.h>
+#include <cstdio>
 #include <cstring>  // for std::memcpy
 #include <iostream>
 #include <thread>  // for std::this_thread::yield
 #include "common.h"
+#include "inet_checksum.h"
 #include "spsc_ring.h"
 
 #ifdef __unix__
@@ -24,80 +26,202 @@ static inline void cpu_relax() {
 #endif
 }
 
+PacketFilter::PacketFilter(const FilterConfig& cfg) {
+    publish(cfg);
+    refresh();
+}
+
+PacketFilter::~PacketFilter() {
+    delete live_.load();
+    for (const Snapshot* s : retired_) delete s;
+}
+
+// Copy the snapshot's rules, then acknowledge: after this store the writer may
+// free every snapshot older than `s`
+void PacketFilter::adopt(const Snapshot* s) {
+    cfg_ = s->cfg;
+    adopted_ = s;
+    seen_.store(s->version, std::memory_order_release);
+}
+
 /**
- * @brief Fast-path predicate to accept/drop a packet based on L2/L3/L4 rules
- *        and a fixed 14-byte UDP payload shape.
+ * @brief Publish a new rule set for the capture thread to pick up.
+ *
+ * Also frees retired snapshots the reader has moved past. The one it last
+ * adopted is kept until it adopts a later one: besides possibly being copied
+ * right now, its address is what refresh() compares against, and reusing it
+ * for a new snapshot would hide that update (ABA).
+ *
+ * @param cfg complete new rules
+ * @return the snapshot's version
+ */
+uint64_t PacketFilter::publish(const FilterConfig& cfg) {
+    std::lock_guard<std::mutex> lk(mu_);
+    const Snapshot* next = new Snapshot{cfg, next_version_++};
+    const Snapshot* prev = live_.exchange(next, std::memory_order_acq_rel);
+    if (prev) retired_.push_back(prev);
+
+    const uint64_t seen = seen_.load(std::memory_order_acquire);
+    size_t keep = 0;
+    for (const Snapshot* r : retired_) {
+        if (r->version < seen)
+            delete r;
+        else
+            retired_[keep++] = r;
+    }
+    retired_.resize(keep);
+    return next->version;
+}
+
+FilterConfig PacketFilter::published(uint64_t* version) const {
+    std::lock_guard<std::mutex> lk(mu_);
+    const Snapshot* s = live_.load(std::memory_order_acquire);
+    if (version) *version = s->version;
+    return s->cfg;
+}
+
+const char* verdict_name(FilterVerdict v) {
+    switch (v) {
+        case FilterVerdict::Accept:
+            return "accept";
+        case FilterVerdict::ShortFrame:
+            return "short";
+        case FilterVerdict::NotIpv4:
+            return "ethertype";
+        case FilterVerdict::BadIhl:
+            return "ihl";
+        case FilterVerdict::NotUdp:
+            return "proto";
+        case FilterVerdict::WrongPort:
+            return "port";
+        case FilterVerdict::BadUdpLen:
+            return "udp_len";
+        case FilterVerdict::PayloadLen:
+            return "payload_len";
+        case FilterVerdict::EmptyPayload:
+            return "empty";
+        case FilterVerdict::BadChecksum:
+            return "csum";
+        case FilterVerdict::kCount:
+            break;
+    }
+    return "?";
+}
+
+/**
+ * @brief Print the drop reasons seen in one interval.
+ *
+ * Prints nothing when there were none, or when the counters are compiled out.
+ *
+ * @param line  line label ("A", "B")
+ * @param now   current counters
+ * @param prev  counters at the previous report (ignored when final)
+ * @param final print whole-run figures
+ */
+void print_filter_drops(const char* line, const FilterDrops& now,
+    const FilterDrops& prev, bool final) {
+#ifndef USPF_NO_DROP_REASONS
+    static const FilterDrops kZero{};
+    const FilterDrops& p = final ? kZero : prev;
+    char buf[256];
+    int len = 0;
+    for (size_t r = 1; r < (size_t)FilterVerdict::kCount; ++r) {
+        const uint64_t d = now.n[r] - p.n[r];
+        if (!d) continue;
+        len += std::snprintf(buf + len, sizeof(buf) - (size_t)len, "  %s=%llu",
+            verdict_name((FilterVerdict)r), (unsigned long long)d);
+    }
+    if (len) std::printf("%sdrops[%s]:%s\n", final ? "[final] " : "", line, buf);
+#else
+    (void)line, (void)now, (void)prev, (void)final;
+#endif
+}
+
+/**
+ * @brief Fast-path verdict to accept/drop a packet based on L2/L3/L4 rules
+ *        and the configured UDP payload length.
  *
  *  - Validates Ethernet type (IPv4), IPv4 header length/bounds, and UDP protocol.
  *  - Checks destination UDP port if configured (cfg_.udp_port).
- *  - Verifies UDP length and frame bounds, requiring exactly 14 bytes of payload.
- *  - Performs a cheap shape check of the payload by memcpy’ing fields into
- *    temporaries (u32 instr_id, u8 instr_type, u8 side, f32 px, f32 qty)
- *    without mutating any external state.
+ *  - Verifies UDP length and frame bounds, and the payload length if
+ *    cfg_.payload_len is set (14 for the default feed; 0 leaves record-level
+ *    validation to the DecoderRegistry).
+ *  - With cfg_.verify_checksums, a frame that passed everything else must
+ *    also carry a valid IPv4 header checksum and, unless it is 0 (none), UDP
+ *    checksum; both are csum_partial() SIMD sums.
  *
  * Performance characteristics:
  *  - Branching is laid out to favor the likely fast path (IPv4/UDP).
  *  - Bounds checks ensure we never read beyond `p + len`.
- *  - The payload field memcpy here is intentionally minimal and does not
- *    allocate or write to external state.
- *
- * TODO: accept(), decode_tick_from_packet(), and locate_udp_payload_14()
- * duplicate parsing logic. Consider unifying validation+decode to avoid double
- * memcpy and bounds checks.
+ *  - The payload itself is not touched (decoding is the decoders' job) unless
+ *    the UDP checksum is verified. Checksums run last, so frames dropped for
+ *    other reasons never pay for them.
  *
  * @param p   Pointer to the start of the Ethernet frame.
  * @param len Total frame length in bytes.
- * @return true if the packet matches the configured filters and has a valid
- *               14-byte UDP payload.
- * @return false if the packet is non-IPv4/UDP, wrong port (if set), malformed,
- *               too short, or does not carry a 14-byte payload.
+ * @return FilterVerdict::Accept if the packet matches the configured filters
+ *         and its UDP payload lies within the frame, else the first check it
+ *         failed (non-IPv4/UDP, wrong port, malformed or truncated headers,
+ *         wrong payload length, bad checksum).
  */
-bool PacketFilter::accept(const uint8_t* p, uint16_t len) const {
-    if (unlikely(len < 14)) return false;
+FilterVerdict PacketFilter::classify(const uint8_t* p, uint16_t len) const {
+    if (unlikely(len < 14)) return FilterVerdict::ShortFrame;
 
     // L2: Ethernet
     const uint16_t etype = (uint16_t(p[12]) << 8) | uint16_t(p[13]);
     if (cfg_.require_ipv4) {
-        if (etype != 0x0800) return false;  // IPv4
-        if (unlikely(len < 14 + 20)) return false;
+        if (etype != 0x0800) return FilterVerdict::NotIpv4;
+        if (unlikely(len < 14 + 20)) return FilterVerdict::BadIhl;
 
         const uint8_t* ip = p + 14;
         const uint8_t ihl_bytes = (ip[0] & 0x0F) * 4;
-        if (unlikely(ihl_bytes < 20 || len < 14 + ihl_bytes)) return false;
+        if (unlikely(ihl_bytes < 20 || len < 14 + ihl_bytes))
+            return FilterVerdict::BadIhl;
 
         if (cfg_.require_udp) {
-            if (ip[9] != 17) return false;  // UDP
-            if (unlikely(len < 14 + ihl_bytes + 8)) return false;
+            if (ip[9] != 17) return FilterVerdict::NotUdp;
+            if (unlikely(len < 14 + ihl_bytes + 8)) return FilterVerdict::NotUdp;
 
             const uint8_t* udp = ip + ihl_bytes;
             const uint16_t dport = (uint16_t(udp[2]) << 8) | uint16_t(udp[3]);
-            if (cfg_.udp_port && dport != cfg_.udp_port) return false;
+            if (cfg_.udp_port && dport != cfg_.udp_port) return FilterVerdict::WrongPort;
 
             // UDP length and payload
             const uint16_t ulen = (uint16_t(udp[4]) << 8) | uint16_t(udp[5]);
-            if (ulen < 8) return false;
+            if (ulen < 8) return FilterVerdict::BadUdpLen;
             const uint16_t payload_len = ulen - 8;
 
-            // We expect exactly 14 bytes
-            if (payload_len != 14) return false;
+            if (cfg_.payload_len && payload_len != cfg_.payload_len)
+                return FilterVerdict::PayloadLen;
 
             // Bounds check against the whole frame length
             const size_t udp_off = 14 + ihl_bytes;
             const size_t payload_off = udp_off + 8;
-            if (payload_off + payload_len > len) return false;
-
-            const uint8_t* payload = p + payload_off;
-
-            // Cheap shape check without mutating user state
-            uint32_t instr_id = 0;
-            uint8_t instr_type = 0, side = 0;
-            float px = 0.f, qty = 0.f;
-            std::memcpy(&instr_id, payload + 0, 4);
-            std::memcpy(&instr_type, payload + 4, 1);
-            std::memcpy(&side, payload + 5, 1);
-            std::memcpy(&px, payload + 6, 4);
-            std::memcpy(&qty, payload + 10, 4);
+            if (payload_off + payload_len > len) return FilterVerdict::BadUdpLen;
+
+            // UDP checksum over pseudo-header, header and payload (0 = none)
+            if (cfg_.verify_checksums && (udp[6] | udp[7]) &&
+                csum_fold(csum_partial(udp, ulen, udp_pseudo_sum(ip, udp + 4))) != 0xFFFF)
+                return FilterVerdict::BadChecksum;
         }
+        if (cfg_.verify_checksums && csum_fold(csum_partial(ip, ihl_bytes, 0)) != 0xFFFF)
+            return FilterVerdict::BadChecksum;
     }
-    return true;
+    return FilterVerdict::Accept;
+}
+
+/**
+ * @brief Payload-only variant of classify() for views whose headers were
+ *        already consumed by the kernel (socket backends).
+ *
+ * @param payload Pointer to the UDP payload.
+ * @param len     Payload length in bytes.
+ * @return FilterVerdict::Accept if the payload has the configured length (any
+ *         if 0).
+ */
+FilterVerdict PacketFilter::classify_payload(const uint8_t* payload, uint16_t len) const {
+    if (unlikely(payload == nullptr || len == 0)) return FilterVerdict::EmptyPayload;
+    if (likely(cfg_.payload_len == 0 || len == cfg_.payload_len))
+        return FilterVerdict::Accept;
+    return FilterVerdict::PayloadLen;
 }
@@ -0,0 +1,214 @@
+#include "perf_counters.h"
+#include <cstdio>
+
+#ifdef USPF_PERF_COUNTERS
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#endif
+
+PerfTotals operator-(const PerfTotals& a, const PerfTotals& b) {
+    PerfTotals d;
+    d.cycles = a.cycles - b.cycles;
+    d.instructions = a.instructions - b.instructions;
+    d.l1d_misses = a.l1d_misses - b.l1d_misses;
+    d.llc_misses = a.llc_misses - b.llc_misses;
+    d.branches = a.branches - b.branches;
+    d.branch_misses = a.branch_misses - b.branch_misses;
+    d.units = a.units - b.units;
+    d.samples = a.samples - b.samples;
+    return d;
+}
+
+PerfTotals operator+(const PerfTotals& a, const PerfTotals& b) {
+    PerfTotals d;
+    d.cycles = a.cycles + b.cycles;
+    d.instructions = a.instructions + b.instructions;
+    d.l1d_misses = a.l1d_misses + b.l1d_misses;
+    d.llc_misses = a.llc_misses + b.llc_misses;
+    d.branches = a.branches + b.branches;
+    d.branch_misses = a.branch_misses + b.branch_misses;
+    d.units = a.units + b.units;
+    d.samples = a.samples + b.samples;
+    return d;
+}
+
+/**
+ * @brief Print derived metrics for one interval of counter deltas.
+ *
+ * @param tag  thread label ("cap", "eng")
+ * @param unit what a unit is ("pkt", "tick")
+ * @param d    deltas since the previous print
+ */
+void print_perf(const char* tag, const char* unit, const PerfTotals& d) {
+    if (d.units == 0) return;
+    const double u = (double)d.units;
+    std::printf(
+        "perf[%s]: IPC=%.2f  cyc/%s=%.1f  L1D-miss/%s=%.3f  LLC-miss/%s=%.4f  "
+        "br-miss=%.2f%%  (%llu batches)\n",
+        tag, d.cycles ? (double)d.instructions / (double)d.cycles : 0.0, unit,
+        (double)d.cycles / u, unit, (double)d.l1d_misses / u, unit,
+        (double)d.llc_misses / u,
+        d.branches ? 100.0 * (double)d.branch_misses / (double)d.branches : 0.0,
+        (unsigned long long)d.samples);
+}
+
+#ifdef USPF_PERF_COUNTERS
+
+namespace {
+
+// Event order matches the slots of PerfTotals / PerfCounters::read_all()
+struct EventSpec {
+    uint32_t type;
+    uint64_t config;
+};
+
+constexpr EventSpec kSpecs[] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+            (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+};
+
+int sys_perf_event_open(perf_event_attr* attr, int group_fd) {
+    // pid 0 / cpu -1: count the calling thread on whichever CPU it runs
+    return (int)syscall(__NR_perf_event_open, attr, 0, -1, group_fd, 0);
+}
+
+#if defined(__x86_64__)
+inline uint64_t rdpmc(uint32_t counter) {
+    uint32_t lo, hi;
+    __asm__ __volatile__("rdpmc" : "=a"(lo), "=d"(hi) : "c"(counter));
+    return (uint64_t)hi << 32 | lo;
+}
+#endif
+
+/**
+ * @brief Read one counter from its mmap'ed page without a syscall.
+ *
+ * Follows the seqlock protocol documented in linux/perf_event.h. Returns
+ * false if the event is not currently on a hardware counter (index 0), in
+ * which case the caller must fall back to read().
+ */
+inline bool read_rdpmc(const perf_event_mmap_page* pc, uint64_t& out) {
+#if defined(__x86_64__)
+    uint32_t seq;
+    uint64_t count;
+    do {
+        seq = pc->lock;
+        __atomic_signal_fence(__ATOMIC_SEQ_CST);
+        const uint32_t idx = pc->index;
+        if (!pc->cap_user_rdpmc || idx == 0) return false;
+        const uint16_t width = pc->pmc_width;
+        int64_t pmc = (int64_t)rdpmc(idx - 1);
+        pmc <<= 64 - width;
+        pmc >>= 64 - width;
+        count = (uint64_t)((int64_t)pc->offset + pmc);
+        __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    } while (pc->lock != seq);
+    out = count;
+    return true;
+#else
+    (void)pc;
+    (void)out;
+    return false;
+#endif
+}
+
+}  // namespace
+
+PerfCounters::~PerfCounters() {
+    close();
+}
+
+/**
+ * @brief Open the counter group for the calling thread.
+ *
+ * Only user-space events are counted (exclude_kernel), which works at the
+ * default perf_event_paranoid=2 and is also what rdpmc can see. Failure is
+ * not fatal: counters simply stay disabled and a one-line note is printed.
+ *
+ * @param tag thread label used in the startup/warning line
+ * @return true if counters are live
+ */
+bool PerfCounters::open(const char* tag) {
+    if (!std::getenv("USPF_PERF")) return false;
+    close();
+
+    for (int i = 0; i < kEvents; ++i) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = kSpecs[i].type;
+        attr.config = kSpecs[i].config;
+        attr.read_format = PERF_FORMAT_GROUP;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.disabled = i == 0;  // leader starts the whole group below
+
+        fds_[i] = sys_perf_event_open(&attr, i == 0 ? -1 : fds_[0]);
+        if (fds_[i] < 0) {
+            std::fprintf(stderr, "perf[%s]: perf_event_open(event %d) failed: %s\n", tag,
+                i, std::strerror(errno));
+            close();
+            return false;
+        }
+
+        const long pg = sysconf(_SC_PAGESIZE);
+        void* p = mmap(nullptr, (size_t)pg, PROT_READ, MAP_SHARED, fds_[i], 0);
+        pages_[i] = p == MAP_FAILED ? nullptr : p;
+    }
+
+    use_rdpmc_ = true;
+    for (int i = 0; i < kEvents; ++i) {
+        auto* pc = static_cast<const perf_event_mmap_page*>(pages_[i]);
+        if (!pc || !pc->cap_user_rdpmc) use_rdpmc_ = false;
+    }
+
+    ioctl(fds_[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    enabled_ = true;
+    std::fprintf(stderr, "perf[%s]: counters enabled (%s)\n", tag,
+        use_rdpmc_ ? "rdpmc" : "read()");
+    return true;
+}
+
+void PerfCounters::close() {
+    enabled_ = false;
+    const long pg = sysconf(_SC_PAGESIZE);
+    for (int i = kEvents - 1; i >= 0; --i) {
+        if (pages_[i]) munmap(pages_[i], (size_t)pg);
+        pages_[i] = nullptr;
+        if (fds_[i] >= 0) ::close(fds_[i]);
+        fds_[i] = -1;
+    }
+}
+
+// Fallback: one syscall returns { nr, value[nr] } for the whole group
+bool PerfCounters::read_group(uint64_t* out) {
+    uint64_t buf[1 + kEvents];
+    if (::read(fds_[0], buf, sizeof(buf)) != (ssize_t)sizeof(buf) || buf[0] != kEvents)
+        return false;
+    std::memcpy(out, buf + 1, sizeof(uint64_t) * kEvents);
+    return true;
+}
+
+bool PerfCounters::read_all(uint64_t* out) {
+    if (use_rdpmc_) {
+        bool ok = true;
+        for (int i = 0; i < kEvents && ok; ++i)
+            ok = read_rdpmc(static_cast<const perf_event_mmap_page*>(pages_[i]), out[i]);
+        if (ok) return true;
+    }
+    return read_group(out);
+}
+
+#endif
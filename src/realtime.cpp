@@ -0,0 +1,194 @@
+#include "realtime.h"
+#include <dirent.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <vector>
+#include "bypass_io.h"
+
+namespace {
+
+bool g_memory_locked = false;
+
+// Bytes of stack each hot thread touches up front (well under the 8 MB default)
+constexpr size_t kStackPrefault = 256 * 1024;
+
+std::string read_line(const std::string& path) {
+    std::ifstream f(path);
+    std::string s;
+    std::getline(f, s);
+    return s;
+}
+
+// Parse a kernel cpulist ("0-3,8,10-11") into a set
+std::set<int> parse_cpulist(const std::string& s) {
+    std::set<int> cpus;
+    std::stringstream ss(s);
+    std::string part;
+    while (std::getline(ss, part, ',')) {
+        if (part.empty()) continue;
+        int a = 0, b = 0;
+        if (std::sscanf(part.c_str(), "%d-%d", &a, &b) == 2) {
+            for (int c = a; c <= b; ++c) cpus.insert(c);
+        } else if (std::sscanf(part.c_str(), "%d", &a) == 1) {
+            cpus.insert(a);
+        }
+    }
+    return cpus;
+}
+
+// IRQ numbers of a NIC: MSI vectors from sysfs, else /proc/interrupts names
+std::vector<int> nic_irqs(const std::string& dev) {
+    std::vector<int> irqs;
+    const std::string dir = "/sys/class/net/" + dev + "/device/msi_irqs";
+    if (DIR* d = opendir(dir.c_str())) {
+        while (dirent* e = readdir(d)) {
+            if (e->d_name[0] >= '0' && e->d_name[0] <= '9')
+                irqs.push_back(std::atoi(e->d_name));
+        }
+        closedir(d);
+    }
+    if (!irqs.empty()) return irqs;
+
+    std::ifstream f("/proc/interrupts");
+    std::string line;
+    while (std::getline(f, line)) {
+        if (line.find(dev) == std::string::npos) continue;
+        int irq = 0;
+        if (std::sscanf(line.c_str(), " %d:", &irq) == 1) irqs.push_back(irq);
+    }
+    return irqs;
+}
+
+// Touch kStackPrefault bytes of this thread's stack so later calls never fault on it
+__attribute__((noinline)) void prefault_stack() {
+    volatile char buf[kStackPrefault];
+    for (size_t i = 0; i < sizeof(buf); i += 4096) buf[i] = 0;
+}
+
+}  // namespace
+
+bool realtime_lock_memory() {
+    // Keep freed heap memory mapped (it stays locked and faulted in)
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        std::fprintf(stderr,
+            "realtime: mlockall failed: %s (raise RLIMIT_MEMLOCK or run as root)\n",
+            std::strerror(errno));
+        return false;
+    }
+    g_memory_locked = true;
+    prefault_stack();
+    return true;
+}
+
+/**
+ * @brief Apply the realtime policy to the calling (already pinned) thread.
+ *
+ * @param name          thread label for error messages
+ * @param fifo_priority SCHED_FIFO priority (1-99), 0 = leave SCHED_OTHER
+ */
+void realtime_thread_init(const char* name, int fifo_priority) {
+    if (fifo_priority > 0) {
+        sched_param sp{};
+        sp.sched_priority = fifo_priority;
+        const int rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp);
+        if (rc != 0) {
+            std::fprintf(stderr, "realtime: SCHED_FIFO %d for %s failed: %s\n",
+                fifo_priority, name, std::strerror(rc));
+        }
+    }
+    if (g_memory_locked) prefault_stack();
+}
+
+/**
+ * @brief Report how well the host is set up for the configured core layout.
+ *
+ * Nothing here changes system settings; it only reads sysfs/procfs and
+ * prints "ok"/"warn" lines so a jittery run can be explained from its log.
+ *
+ * @param rt     core assignments and priority
+ * @param ifname -i spec; NIC IRQs are checked for netmap:/xdp: devices
+ */
+void realtime_report(const RealtimeConfig& rt, const std::string& ifname) {
+    auto line = [](bool ok, const char* fmt, auto... args) {
+        std::printf("realtime: %s ", ok ? "ok  " : "warn");
+        std::printf(fmt, args...);
+        std::printf("\n");
+    };
+
+    const std::set<int> isolated =
+        parse_cpulist(read_line("/sys/devices/system/cpu/isolated"));
+    const std::set<int> nohz =
+        parse_cpulist(read_line("/sys/devices/system/cpu/nohz_full"));
+
+    struct Hot {
+        const char* name;
+        int core;
+    };
+    const Hot hot[] = {{"capture", rt.capture_core}, {"engine", rt.engine_core}};
+
+    for (const auto& h : hot) {
+        if (h.core < 0) {
+            line(false, "%s thread is not pinned", h.name);
+            continue;
+        }
+        line(isolated.count(h.core), "%s core %d %s isolcpus", h.name, h.core,
+            isolated.count(h.core) ? "in" : "not in");
+        line(nohz.count(h.core), "%s core %d %s nohz_full", h.name, h.core,
+            nohz.count(h.core) ? "in" : "not in");
+
+        const std::string gov = read_line("/sys/devices/system/cpu/cpu" +
+            std::to_string(h.core) + "/cpufreq/scaling_governor");
+        if (!gov.empty())
+            line(gov == "performance", "%s core %d governor %s", h.name, h.core,
+                gov.c_str());
+        if (h.core == rt.housekeeping_core)
+            line(false, "%s core %d is also the housekeeping core", h.name, h.core);
+    }
+    if (rt.capture_core >= 0 && rt.capture_core == rt.engine_core)
+        line(false, "capture and engine share core %d", rt.capture_core);
+    if (rt.housekeeping_core < 0)
+        line(false, "no housekeeping core (-k); main and reporter threads float");
+
+    const std::string dev = device_of(ifname);
+    if (!dev.empty()) {
+        const std::vector<int> irqs = nic_irqs(dev);
+        int on_hot = 0;
+        for (int irq : irqs) {
+            const std::set<int> aff = parse_cpulist(
+                read_line("/proc/irq/" + std::to_string(irq) + "/smp_affinity_list"));
+            if (aff.count(rt.capture_core) || aff.count(rt.engine_core)) ++on_hot;
+        }
+        if (irqs.empty())
+            line(false, "no IRQs found for %s", dev.c_str());
+        else
+            line(on_hot == 0, "%d of %zu %s IRQs may fire on a hot core", on_hot,
+                irqs.size(), dev.c_str());
+    }
+
+    const std::string rt_runtime = read_line("/proc/sys/kernel/sched_rt_runtime_us");
+    if (rt.fifo_priority > 0 && rt_runtime != "-1") {
+        line(false, "SCHED_FIFO is throttled (sched_rt_runtime_us=%s); a spinning thread "
+                    "is descheduled every period", rt_runtime.c_str());
+    }
+
+    rlimit lim{};
+    getrlimit(RLIMIT_MEMLOCK, &lim);
+    const std::string limit =
+        lim.rlim_cur == RLIM_INFINITY ? "unlimited" : std::to_string(lim.rlim_cur);
+    line(g_memory_locked, "memory %s (RLIMIT_MEMLOCK %s)",
+        g_memory_locked ? "locked" : "not locked", limit.c_str());
+    std::fflush(stdout);
+}
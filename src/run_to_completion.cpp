@@ -0,0 +1,73 @@
+#include "run_to_completion.h"
+#include <cstdio>
+#include <cstring>
+#include "inet_checksum.h"
+#include "tick_decode.h"
+
+/**
+ * @brief Print one interval of the run-to-completion path.
+ *
+ * The decide percentiles read the same way as the wait line's in the
+ * two-thread pipeline, so one run of each compares the ring hop directly.
+ *
+ * @param now   current counters
+ * @param prev  counters at the previous report (ignored when final)
+ * @param final print whole-run figures
+ */
+void print_inline(const InlineStats& now, const InlineStats& prev, bool final) {
+    static const InlineStats kZero{};
+    const InlineStats& base = final ? kZero : prev;
+    const Log2Histogram h = now.decide_latency.since(base.decide_latency);
+
+    const double k = tsc_ns_per_tick();
+    std::printf("%sinline: datagrams=%llu ticks=%llu decide p50<=%.1fus p99<=%.1fus "
+                "max=%.1fus tx=%llu tx_fail=%llu\n",
+        final ? "[final] " : "", (unsigned long long)(now.datagrams - base.datagrams),
+        (unsigned long long)(now.ticks - base.ticks), (double)h.percentile(50) * k / 1e3,
+        (double)h.percentile(99) * k / 1e3, (double)h.max * k / 1e3,
+        (unsigned long long)(now.tx - base.tx),
+        (unsigned long long)(now.tx_failed - base.tx_failed));
+}
+
+uint16_t build_order_frame(const PacketView& v, const Tick& t, uint8_t* out) {
+    const uint8_t* payload = nullptr;
+    uint16_t paylen = 0, dport = 0;
+    if (v.payload_only || !locate_udp_payload(v.data, v.len, payload, paylen, dport))
+        return 0;
+
+    // Headers as received, then swap each pair of endpoints
+    const size_t ihl = (size_t)(v.data[14] & 0x0F) * 4;
+    const size_t hdr = 14 + ihl + 8;
+    std::memcpy(out, v.data, hdr);
+    std::memcpy(out, v.data + 6, 6);
+    std::memcpy(out + 6, v.data, 6);
+    uint8_t* ip = out + 14;
+    std::memcpy(ip + 12, v.data + 14 + 16, 4);
+    std::memcpy(ip + 16, v.data + 14 + 12, 4);
+    uint8_t* udp = ip + ihl;
+    std::memcpy(udp, v.data + 14 + ihl + 2, 2);
+    std::memcpy(udp + 2, v.data + 14 + ihl, 2);
+
+    // md14 record, little-endian like the feed
+    uint8_t* rec = udp + 8;
+    std::memcpy(rec, &t.instr_id, 4);
+    rec[4] = t.instr_type;
+    rec[5] = t.side ^ 1;
+    std::memcpy(rec + 6, &t.px, 4);
+    std::memcpy(rec + 10, &t.qty, 4);
+
+    const uint16_t ulen = 8 + 14;
+    const uint16_t tot = (uint16_t)(ihl + ulen);
+    ip[2] = (uint8_t)(tot >> 8);
+    ip[3] = (uint8_t)tot;
+    ip[10] = ip[11] = 0;
+    const uint16_t ip_csum = csum_finish(csum_partial(ip, ihl, 0));
+    std::memcpy(ip + 10, &ip_csum, 2);
+    udp[4] = (uint8_t)(ulen >> 8);
+    udp[5] = (uint8_t)ulen;
+    udp[6] = udp[7] = 0;
+    const uint16_t udp_csum =
+        udp_csum_finish(csum_partial(udp, ulen, udp_pseudo_sum(ip, udp + 4)));
+    std::memcpy(udp + 6, &udp_csum, 2);
+    return (uint16_t)(14 + tot);
+}
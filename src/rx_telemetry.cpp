@@ -0,0 +1,66 @@
+#include "rx_telemetry.h"
+#include <cstdio>
+
+/**
+ * @brief Print RX ring telemetry for one reporting interval.
+ *
+ * The hint is a rule of thumb over the interval: p99 occupancy above 3/4 of
+ * the ring means the receiver is close to overflowing (drops at the NIC),
+ * take pinned at the burst cap means receiver-bound, and mostly empty polls
+ * mean the generator is the bottleneck.
+ *
+ * @param now   current counters
+ * @param prev  counters at the previous report (ignored when final)
+ * @param final print whole-run figures
+ */
+void print_rx_telemetry(const RxTelemetry& now, const RxTelemetry& prev, bool final) {
+    static const RxTelemetry kZero{};
+    const RxTelemetry& base = final ? kZero : prev;
+
+    const uint64_t polls = now.polls - base.polls;
+    if (polls == 0) return;
+    const uint64_t empty = now.empty_polls - base.empty_polls;
+    const double empty_pct = 100.0 * (double)empty / (double)polls;
+
+    bool near_full = false;
+    uint64_t calls = 0, capped = 0;
+    for (int r = 0; r < now.nrings; ++r) {
+        const RxRingTelemetry& a = now.ring[r];
+        const RxRingTelemetry& b = base.ring[r];
+        const Log2Histogram occ = a.occupancy.since(b.occupancy);
+        calls += a.take.total - b.take.total;
+        capped += a.burst_capped - b.burst_capped;
+        if (a.ring_size && occ.total &&
+            occ.percentile(99) * 4 >= (uint64_t)a.ring_size * 3)
+            near_full = true;
+    }
+    const double cap_pct = calls ? 100.0 * (double)capped / (double)calls : 0.0;
+
+    const char* hint = near_full        ? "near RX overflow, NIC drops likely"
+                       : cap_pct > 50.0  ? "receiver-bound"
+                       : empty_pct > 90.0 ? "generator-bound"
+                                          : "keeping up";
+    std::printf("%srxq: polls=%llu empty=%.1f%% burst-capped=%.1f%% -> %s\n",
+        final ? "[final] " : "", (unsigned long long)polls, empty_pct, cap_pct, hint);
+
+    for (int r = 0; r < now.nrings; ++r) {
+        const RxRingTelemetry& a = now.ring[r];
+        const RxRingTelemetry& b = base.ring[r];
+        const Log2Histogram take = a.take.since(b.take);
+        if (take.total == 0) continue;
+        const Log2Histogram occ = a.occupancy.since(b.occupancy);
+
+        // recvmmsg cannot see the socket queue, so occupancy may be absent
+        char occ_str[96] = "occ n/a";
+        if (occ.total) {
+            std::snprintf(occ_str, sizeof(occ_str), "occ p50<=%llu p99<=%llu max=%llu/%u",
+                (unsigned long long)occ.percentile(50),
+                (unsigned long long)occ.percentile(99), (unsigned long long)occ.max,
+                a.ring_size);
+        }
+        std::printf("  rxq[%d]: %s  take avg=%.1f p99<=%llu  capped=%llu empty=%llu\n", r,
+            occ_str, take.mean(), (unsigned long long)take.percentile(99),
+            (unsigned long long)(a.burst_capped - b.burst_capped),
+            (unsigned long long)(a.empty - b.empty));
+    }
+}
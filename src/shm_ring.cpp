@@ -0,0 +1,232 @@
+#include "shm_ring.h"
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/statfs.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <new>
+
+#ifndef HUGETLBFS_MAGIC
+#define HUGETLBFS_MAGIC 0x958458f6
+#endif
+
+static_assert(std::atomic<int32_t>::is_always_lock_free &&
+                  std::atomic<uint64_t>::is_always_lock_free &&
+                  std::atomic<size_t>::is_always_lock_free,
+    "shared-memory ring needs address-free (lock-free) atomics");
+
+// The ring starts on the second 4 KB page of the file
+static constexpr size_t kRingOffset = 4096;
+static_assert(sizeof(ShmRingHeader) <= kRingOffset, "header must fit its page");
+
+static constexpr int kMpolPreferred = 1;
+
+static size_t round_up(size_t v, size_t a) {
+    return (v + a - 1) / a * a;
+}
+
+static std::string sys_error(const std::string& what) {
+    return what + ": " + std::strerror(errno);
+}
+
+// kill(pid, 0) succeeds, or fails only for lack of permission
+static bool pid_alive(pid_t pid) {
+    return pid > 0 && (::kill(pid, 0) == 0 || errno == EPERM);
+}
+
+ShmRing::ShmRing(std::string path, bool producer, void* base, size_t bytes, size_t page)
+    : path_(std::move(path)),
+      producer_(producer),
+      base_(base),
+      bytes_(bytes),
+      page_(page),
+      hdr_(static_cast<ShmRingHeader*>(base)),
+      ring_(reinterpret_cast<Ring*>(static_cast<char*>(base) + kRingOffset)) {}
+
+/**
+ * @brief Create and publish a shared tick ring.
+ *
+ * The file is sized to the page size of the filesystem it lands on (2 MB or
+ * 1 GB on hugetlbfs), placed on `node`, pre-faulted and fully initialized
+ * before rename() makes it visible at `path`.
+ *
+ * @param path file to create, e.g. /dev/shm/uspf.ring (replaced if present)
+ * @param node preferred NUMA node (-1 = leave the default policy)
+ * @param err  out: reason on failure
+ * @return the producer's handle, or nullptr
+ */
+std::shared_ptr<ShmRing> ShmRing::create(const std::string& path, int node,
+    std::string& err) {
+    const std::string tmp = path + ".tmp." + std::to_string(::getpid());
+    const int fd = ::open(tmp.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0660);
+    if (fd < 0) {
+        err = sys_error(tmp);
+        return nullptr;
+    }
+
+    size_t page = (size_t)::sysconf(_SC_PAGESIZE);
+    struct statfs fs;
+    if (::fstatfs(fd, &fs) == 0 && (uint32_t)fs.f_type == HUGETLBFS_MAGIC)
+        page = (size_t)fs.f_bsize;
+    const size_t bytes = round_up(kRingOffset + sizeof(Ring), page);
+
+    struct stat st;
+    void* base = MAP_FAILED;
+    if (::ftruncate(fd, (off_t)bytes) == 0 && ::fstat(fd, &st) == 0)
+        base = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        err = sys_error(tmp);
+        ::close(fd);
+        ::unlink(tmp.c_str());
+        return nullptr;
+    }
+    ::close(fd);
+
+    // Same placement as huge_alloc(): preferred, so a full node degrades
+    // to remote memory instead of SIGBUS. tmpfs honours it per shared page.
+    if (node >= 0 && node < 64) {
+        unsigned long mask = 1UL << node;
+        syscall(__NR_mbind, base, bytes, kMpolPreferred, &mask, 64, 0);
+    }
+    if (page == (size_t)::sysconf(_SC_PAGESIZE)) ::madvise(base, bytes, MADV_HUGEPAGE);
+    auto* c = static_cast<volatile char*>(base);
+    for (size_t off = 0; off < bytes; off += page) c[off] = 0;
+
+    std::shared_ptr<ShmRing> r(new ShmRing(path, true, base, bytes, page));
+    ShmRingHeader* h = new (base) ShmRingHeader{};
+    new (r->ring_) Ring();
+    h->version = ShmRingHeader::kVersion;
+    h->header_bytes = (uint32_t)kRingOffset;
+    h->slot_bytes = (uint32_t)sizeof(Tick);
+    h->slots = (uint32_t)(r->ring_->capacity() + 1);
+    h->ring_bytes = sizeof(Ring);
+    h->file_bytes = bytes;
+    h->producer_pid.store(::getpid(), std::memory_order_relaxed);
+    h->consumer_pid.store(0, std::memory_order_relaxed);
+    h->attaches.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    h->magic = ShmRingHeader::kMagic;
+
+    if (::rename(tmp.c_str(), path.c_str()) != 0) {
+        err = sys_error(path);
+        ::unlink(tmp.c_str());
+        return nullptr;
+    }
+    r->ino_ = st.st_ino;
+    r->owned_ = true;
+    return r;
+}
+
+/**
+ * @brief Map an existing shared tick ring and become its consumer.
+ *
+ * Fails if the file is not a ring of this build's layout, if its producer has
+ * gone, or if a live process already holds the consumer side.
+ *
+ * @param path ring file created by ShmRing::create()
+ * @param err  out: reason on failure
+ * @return the consumer's handle, or nullptr
+ */
+std::shared_ptr<ShmRing> ShmRing::attach(const std::string& path, std::string& err) {
+    const int fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0) {
+        err = sys_error(path);
+        return nullptr;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || (size_t)st.st_size < kRingOffset + sizeof(Ring)) {
+        err = path + ": not a tick ring (too small)";
+        ::close(fd);
+        return nullptr;
+    }
+    const size_t bytes = (size_t)st.st_size;
+    void* base = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        err = sys_error(path);
+        return nullptr;
+    }
+
+    struct statfs fs;
+    size_t page = (size_t)::sysconf(_SC_PAGESIZE);
+    if (::statfs(path.c_str(), &fs) == 0 && (uint32_t)fs.f_type == HUGETLBFS_MAGIC)
+        page = (size_t)fs.f_bsize;
+    // From here the destructor unmaps (and releases the claim once owned_)
+    std::shared_ptr<ShmRing> r(new ShmRing(path, false, base, bytes, page));
+    ShmRingHeader* h = r->hdr_;
+
+    char why[128] = "";
+    if (h->magic != ShmRingHeader::kMagic)
+        std::snprintf(why, sizeof(why), "bad magic");
+    else if (h->version != ShmRingHeader::kVersion)
+        std::snprintf(why, sizeof(why), "layout version %u, expected %u", h->version,
+            ShmRingHeader::kVersion);
+    else if (h->header_bytes != kRingOffset || h->slot_bytes != sizeof(Tick) ||
+             h->slots != r->ring_->capacity() + 1 || h->ring_bytes != sizeof(Ring) ||
+             h->file_bytes != bytes)
+        std::snprintf(why, sizeof(why), "geometry %u+%ux%u, expected %zu+%zux%zu",
+            h->header_bytes, h->slots, h->slot_bytes, kRingOffset,
+            r->ring_->capacity() + 1, sizeof(Tick));
+    else if (!r->producer_alive())
+        std::snprintf(why, sizeof(why), "producer is gone");
+    if (why[0]) {
+        err = path + ": " + why;
+        return nullptr;
+    }
+
+    // Claim the consumer side, taking it over from a consumer that died
+    const pid_t me = ::getpid();
+    int32_t cur = 0;
+    while (!h->consumer_pid.compare_exchange_strong(cur, me, std::memory_order_acq_rel)) {
+        if (pid_alive(cur)) {
+            err = path + ": consumer side held by pid " + std::to_string(cur);
+            return nullptr;
+        }
+    }
+    h->attaches.fetch_add(1, std::memory_order_relaxed);
+    r->owned_ = true;
+    return r;
+}
+
+ShmRing::~ShmRing() {
+    if (owned_ && producer_) {
+        hdr_->producer_pid.store(0, std::memory_order_release);
+        // Leave a newer producer's file alone
+        struct stat st;
+        if (::stat(path_.c_str(), &st) == 0 && st.st_ino == ino_) ::unlink(path_.c_str());
+    } else if (owned_) {
+        int32_t me = ::getpid();
+        hdr_->wakeup.cancel();
+        hdr_->consumer_pid.compare_exchange_strong(me, 0, std::memory_order_acq_rel);
+    }
+    ::munmap(base_, bytes_);
+}
+
+bool ShmRing::producer_alive() const {
+    return pid_alive(hdr_->producer_pid.load(std::memory_order_acquire));
+}
+
+pid_t ShmRing::consumer() const {
+    const pid_t pid = hdr_->consumer_pid.load(std::memory_order_acquire);
+    return pid_alive(pid) ? pid : 0;
+}
+
+void print_shm_ring(const ShmRing& r, bool final) {
+    const ShmRingHeader& h = r.header();
+    const pid_t pid = r.consumer();
+    char who[32];
+    if (pid)
+        std::snprintf(who, sizeof(who), "pid %d", (int)pid);
+    else
+        std::snprintf(who, sizeof(who), "none");
+    std::printf("%sshm[%s]: consumer=%s  attaches=%llu  depth=%llu  page=%zuK\n",
+        final ? "[final] " : "", r.path().c_str(), who,
+        (unsigned long long)h.attaches.load(std::memory_order_relaxed),
+        (unsigned long long)r.depth(), r.page_size() >> 10);
+}
@@ -0,0 +1,220 @@
+#include "socket_rx.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <ctime>
+
+#ifndef SO_BUSY_POLL
+#define SO_BUSY_POLL 46
+#endif
+#ifndef SO_PREFER_BUSY_POLL
+#define SO_PREFER_BUSY_POLL 69
+#endif
+
+/**
+ * @brief Parse "<prefix>:[addr:]port" (udp:, uring:) into a sockaddr_in.
+ *
+ * @param ifname interface string as given to -i
+ * @param out bind address (INADDR_ANY when addr is omitted)
+ * @return true if the string is well-formed
+ */
+static bool parse_udp_ifname(const std::string& ifname, sockaddr_in& out) {
+    const std::string spec = ifname.substr(ifname.find(':') + 1);
+    std::string addr = "0.0.0.0";
+    std::string port = spec;
+    const auto colon = spec.rfind(':');
+    if (colon != std::string::npos) {
+        addr = spec.substr(0, colon);
+        port = spec.substr(colon + 1);
+    }
+
+    char* end = nullptr;
+    const long p = std::strtol(port.c_str(), &end, 10);
+    if (port.empty() || *end != '\0' || p < 0 || p > 65535) return false;
+
+    std::memset(&out, 0, sizeof(out));
+    out.sin_family = AF_INET;
+    out.sin_port = htons((uint16_t)p);
+    return inet_pton(AF_INET, addr.c_str(), &out.sin_addr) == 1;
+}
+
+/**
+ * @brief Open, tune and bind the UDP socket shared by the kernel-socket backends.
+ *
+ * Socket options are best-effort: SO_BUSY_POLL / SO_PREFER_BUSY_POLL need
+ * CAP_NET_ADMIN to raise above net.core.busy_read, and SO_RCVBUF is capped by
+ * net.core.rmem_max. Failures are reported but do not fail the open, so the
+ * backend still runs (just slower) on an untuned host.
+ *
+ * @param cfg BypassConfig with ifname "<prefix>:[addr:]port"
+ * @param timestamps in: request SO_TIMESTAMPNS; out: whether it is enabled
+ * @return bound non-blocking fd, or -1 on failure
+ */
+int open_udp_socket(const BypassConfig& cfg, bool& timestamps) {
+    sockaddr_in sa{};
+    if (!parse_udp_ifname(cfg.ifname, sa)) {
+        std::fprintf(stderr, "socket_rx: bad ifname '%s' (want udp:[addr:]port)\n",
+            cfg.ifname.c_str());
+        return -1;
+    }
+
+    int fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+    if (fd < 0) {
+        std::perror("socket_rx: socket");
+        return -1;
+    }
+
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    if (cfg.sock_rcvbuf > 0 &&
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &cfg.sock_rcvbuf, sizeof(int)) < 0) {
+        std::perror("socket_rx: SO_RCVBUF");
+    }
+    if (cfg.sock_busy_poll_us > 0) {
+        if (setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &cfg.sock_busy_poll_us,
+                sizeof(int)) < 0) {
+            std::perror("socket_rx: SO_BUSY_POLL");
+        }
+        if (cfg.sock_prefer_busy_poll &&
+            setsockopt(fd, SOL_SOCKET, SO_PREFER_BUSY_POLL, &one, sizeof(one)) < 0) {
+            std::perror("socket_rx: SO_PREFER_BUSY_POLL");
+        }
+    }
+    if (timestamps &&
+        setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPNS, &one, sizeof(one)) < 0) {
+        std::perror("socket_rx: SO_TIMESTAMPNS");
+        timestamps = false;
+    }
+
+    if (::bind(fd, (const sockaddr*)&sa, sizeof(sa)) < 0) {
+        std::perror("socket_rx: bind");
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+uint16_t udp_socket_port(int fd) {
+    sockaddr_in sa{};
+    socklen_t len = sizeof(sa);
+    if (getsockname(fd, (sockaddr*)&sa, &len) < 0) return 0;
+    return ntohs(sa.sin_port);
+}
+
+uint64_t cmsg_rx_timestamp(const msghdr& msg) {
+    for (cmsghdr* c = CMSG_FIRSTHDR(&msg); c;
+        c = CMSG_NXTHDR(const_cast<msghdr*>(&msg), c)) {
+        if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_TIMESTAMPNS) {
+            timespec ts;
+            std::memcpy(&ts, CMSG_DATA(c), sizeof(ts));
+            return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Open the UDP socket and preallocate the recvmmsg vectors.
+ *
+ * @param cfg BypassConfig with ifname "udp:[addr:]port"
+ */
+SocketRx::SocketRx(const BypassConfig& cfg)
+    : busy_poll_(cfg.busy_poll),
+      timestamps_(cfg.sock_timestamps),
+      vlen_(cfg.burst > 0 ? (unsigned)cfg.burst : 1) {
+    int fd = open_udp_socket(cfg, timestamps_);
+    if (fd < 0) return;
+
+    // One buffer + control area + iovec + mmsghdr per vector slot, allocated once
+    bufs_.resize(vlen_ * kBufSize);
+    ctrl_.resize(vlen_ * kCtrlSize);
+    iov_.resize(vlen_);
+    msgs_.resize(vlen_);
+    for (unsigned i = 0; i < vlen_; ++i) {
+        iov_[i].iov_base = bufs_.data() + i * kBufSize;
+        iov_[i].iov_len = kBufSize;
+        std::memset(&msgs_[i], 0, sizeof(mmsghdr));
+        msgs_[i].msg_hdr.msg_iov = &iov_[i];
+        msgs_[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    fd_ = fd;
+    port_ = udp_socket_port(fd);
+}
+
+SocketRx::~SocketRx() {
+    if (fd_ >= 0) ::close(fd_);
+}
+
+/**
+ * @brief Drain up to `vlen` datagrams with one recvmmsg() and invoke cb on each.
+ *
+ * Mirrors the netmap path: in busy-poll mode we never block (MSG_DONTWAIT, with
+ * SO_BUSY_POLL letting the kernel spin on the NIC queue); otherwise we wait on
+ * poll() with the same 1s timeout so the caller can check its running flag.
+ *
+ * Datagrams dequeued but not consumed because cb returned false are kept and
+ * handed out first on the next call, matching netmap's "save position" behavior.
+ *
+ * @param cb Callback applied to each datagram (payload-only PacketView)
+ * @param stats Counters to update (pkts, bytes, batches)
+ * @return Number of datagrams handed to cb, 0 if none, -1 on socket error.
+ */
+int SocketRx::rx_batch(const std::function<bool(const PacketView&)>& cb, Stats& stats,
+    RxTelemetry& tel) {
+    if (fd_ < 0) return -1;
+
+    if (next_ == count_) {
+        if (!busy_poll_) {
+            pollfd pfd{fd_, POLLIN, 0};
+            if (poll(&pfd, 1, 1000) <= 0) return 0;
+        }
+
+        // The kernel overwrites msg_controllen, so it must be reset every call
+        if (timestamps_) {
+            for (unsigned i = 0; i < vlen_; ++i) {
+                msgs_[i].msg_hdr.msg_control = ctrl_.data() + i * kCtrlSize;
+                msgs_[i].msg_hdr.msg_controllen = kCtrlSize;
+            }
+        }
+
+        const int n = recvmmsg(fd_, msgs_.data(), vlen_, MSG_DONTWAIT, nullptr);
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) return -1;
+            tel.record_take(0, 0, vlen_);
+            return 0;
+        }
+        next_ = 0;
+        count_ = (unsigned)n;
+        if (n > 0) ++stats.batches;
+
+        // The socket queue depth is not visible; record the vector fill only
+        tel.record_take(0, (uint32_t)n, vlen_);
+    }
+
+    int processed = 0;
+    while (next_ < count_) {
+        const mmsghdr& m = msgs_[next_];
+        const uint32_t len = m.msg_len < kBufSize ? m.msg_len : kBufSize;
+
+        PacketView v{bufs_.data() + next_ * kBufSize, (uint16_t)len, rdtsc()};
+        v.payload_only = true;
+        v.dport = port_;
+        if (timestamps_) v.rx_ns = cmsg_rx_timestamp(m.msg_hdr);
+
+        ++next_;
+        ++processed;
+        ++stats.pkts;
+        stats.bytes += len;
+
+        if (!cb(v)) break;
+    }
+    return processed;
+}
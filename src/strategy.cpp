@@ -0,0 +1,64 @@
+#include "strategy.h"
+#include <cstdio>
+
+/**
+ * @brief Update statistics for and evaluate one columnar batch.
+ *
+ * The state update walks the batch in order, since a later tick for the same
+ * instrument must see the earlier one, and leaves each tick's band in two
+ * column buffers. The rule itself is then two passes over px[], side[] and
+ * the bands with 32-bit lane counters and no branches, which at -O3
+ * -march=native is a handful of vector compares per 8 or 16 ticks.
+ *
+ * @param b batch filled by TickBatch::fill()
+ */
+void MeanReversion::on_batch(const TickBatch& b) {
+    alignas(64) float lo[TickBatch::kMax];
+    alignas(64) float hi[TickBatch::kMax];
+    const size_t n = b.n;
+    for (size_t i = 0; i < n; ++i) {
+        Tick t;
+        t.instr_id = b.instr_id[i];
+        t.side = b.side[i];
+        t.px = b.px[i];
+        t.qty = b.qty[i];
+        bounds(t, lo[i], hi[i]);
+    }
+
+    const float* __restrict px = b.px;
+    const uint8_t* __restrict side = b.side;
+    uint32_t buys = 0, sells = 0;
+    for (size_t i = 0; i < n; ++i) {
+        buys += (uint32_t)((side[i] == 1) & (px[i] < lo[i]));
+        sells += (uint32_t)((side[i] == 0) & (px[i] > hi[i]));
+    }
+    stats_.buys += buys;
+    stats_.sells += sells;
+    stats_.ticks += n;
+    ++stats_.batches;
+    publish();
+}
+
+/**
+ * @brief Print mean reversion signal counts for one reporting interval.
+ *
+ * @param now   current counters
+ * @param prev  counters at the previous report (ignored when final)
+ * @param final print whole-run figures
+ */
+void print_strategy(const StrategyStats& now, const StrategyStats& prev, bool final) {
+    static const StrategyStats kZero{};
+    const StrategyStats& base = final ? kZero : prev;
+
+    const uint64_t ticks = now.ticks - base.ticks;
+    const uint64_t batches = now.batches - base.batches;
+    if (ticks == 0) return;
+    std::printf("%sstrategy: ticks=%llu ticks/batch=%.1f buys=%llu sells=%llu "
+                "instruments=%llu untracked=%llu\n",
+        final ? "[final] " : "", (unsigned long long)ticks,
+        batches ? (double)ticks / (double)batches : 0.0,
+        (unsigned long long)(now.buys - base.buys),
+        (unsigned long long)(now.sells - base.sells),
+        (unsigned long long)now.instruments,
+        (unsigned long long)(now.untracked - base.untracked));
+}
@@ -0,0 +1,43 @@
+#include "tick_shard.h"
+#include <cstdio>
+
+/**
+ * @brief Print one interval of the capture thread's per-worker dispatch.
+ *
+ * Ticks and drops are per interval (whole run when final); depth is each
+ * ring's occupancy right now, so a worker that is falling behind shows up as
+ * a growing depth long before it drops.
+ *
+ * @param now    current per-shard counters
+ * @param prev   counters at the previous report (ignored when final)
+ * @param depth  current ring depth per shard
+ * @param shards number of shards
+ * @param final  print whole-run figures
+ */
+void print_shards(const ShardStats* now, const ShardStats* prev, const size_t* depth,
+    size_t shards, bool final) {
+    static const ShardStats kZero{};
+    uint64_t total = 0, busiest = 0, drops = 0;
+    size_t deepest = 0;
+    char ticks[512], depths[512];
+    int tl = 0, dl = 0;
+    for (size_t s = 0; s < shards; ++s) {
+        const ShardStats& p = final ? kZero : prev[s];
+        const uint64_t d = now[s].ticks - p.ticks;
+        total += d;
+        if (d > busiest) busiest = d;
+        drops += now[s].drops - p.drops;
+        if (depth[s] > deepest) deepest = depth[s];
+        if (tl < (int)sizeof(ticks) - 24)
+            tl += std::snprintf(ticks + tl, sizeof(ticks) - tl, "%s%llu", s ? "/" : "",
+                (unsigned long long)d);
+        if (dl < (int)sizeof(depths) - 24)
+            dl += std::snprintf(depths + dl, sizeof(depths) - dl, "%s%zu", s ? "/" : "",
+                depth[s]);
+    }
+    const double mean = (double)total / (double)shards;
+    std::printf(
+        "%sshards[%zu]: ticks=%s  imbalance=%.2f  depth=%s (max %zu)  drops=%llu\n",
+        final ? "[final] " : "", shards, ticks, mean > 0 ? (double)busiest / mean : 0.0,
+        depths, deepest, (unsigned long long)drops);
+}
@@ -1,4 +1,5 @@
 #include "trading_engine.h"
+#include "realtime.h"
 
 #include <chrono>
 #include <iostream>
@@ -7,18 +8,16 @@
 #include <sched.h>
 #endif
 #include <cstring>
+#include <pthread.h>
+#include <time.h>
 
 namespace {
-// TODO: Replace this constant price mean reversion logic to something more
-// dynamic, like inventory driven fitting + vol fitting, etc.
-constexpr double PRICE_MEAN = 100.0;
-
 const char* side_label(uint8_t s) {
     return s == 0 ? "BID" : "ASK";
 }
 }
 
-std::string instr_name(int instr_id) {
+const char* instr_name(int instr_id) {
     switch (instr_id) {
         case 0:
             return "UNDERLYING";
@@ -31,17 +30,20 @@ std::string instr_name(int instr_id) {
     }
 }
 
-TradingEngine::TradingEngine(std::shared_ptr<Ring> ring) : ring_(std::move(ring)) {
-}
+TradingEngine::TradingEngine(std::shared_ptr<Ring> ring, const char* name)
+    : ring_(std::move(ring)),
+      name_(name),
+      jitter_(name),
+      fdr_(name, FlightRecorder::Kind::Drains) {}
 
 TradingEngine::~TradingEngine() {
     stop();
 }
 
-void TradingEngine::start() {
+void TradingEngine::start(int cpu_affinity, int rt_priority) {
     bool expected = false;
     if (!running_.compare_exchange_strong(expected, true)) return;
-    worker_ = std::thread(&TradingEngine::thread_main, this);
+    worker_ = std::thread(&TradingEngine::thread_main, this, cpu_affinity, rt_priority);
 }
 
 void TradingEngine::stop() {
@@ -50,24 +52,116 @@ void TradingEngine::stop() {
     if (worker_.joinable()) worker_.join();
 }
 
-void TradingEngine::run_once() {
-    Tick t;
+size_t TradingEngine::run_once() {
+    Tick t, first;
+    size_t n = 0;
+    uint64_t pop_tsc = 0;
     while (ring_->pop(t)) {
-        std::string name = instr_name(t.instr_type);  // <-- use type
+        if (++n == 1) {
+            first = t;
+            pop_tsc = note_pop(t.ts_ns);
+        }
+        const char* name = instr_name(t.instr_type);  // <-- use type
         std::cout << "Received tick with name: " << name << " [" << side_label(t.side)
                   << "] "  // <-- use packet side
                   << name << " qty=" << t.qty << " @ " << t.px << "\n";
     }
+    if (n) note_done(first, pop_tsc, n);
+    return n;
+}
+
+size_t TradingEngine::run_batch() {
+    size_t n = 0;
+    Tick first;
+    uint64_t pop_tsc = 0;
+    while (batch_.fill(*ring_)) {
+        if (n == 0) {
+            first = {batch_.ts[0], batch_.instr_id[0], batch_.instr_type[0],
+                batch_.side[0], batch_.px[0], batch_.qty[0]};
+            pop_tsc = note_pop(first.ts_ns);
+        }
+        n += batch_.n;
+        batch_handler_(batch_);
+    }
+    if (n) note_done(first, pop_tsc, n);
+    return n;
 }
 
 void TradingEngine::run_loop() {
     running_.store(true, std::memory_order_relaxed);
-    thread_main();
+    thread_main(-1, 0);
 }
 
-void TradingEngine::thread_main() {
+void TradingEngine::thread_main(int cpu_affinity, int rt_priority) {
+    pin_thread_to_core(cpu_affinity);
+    realtime_thread_init("engine", rt_priority);
+    perf_.open(name_);
+    Ring* rp = ring_.get();
+    jitter_.set_probes([rp] { return (int64_t)rp->size(); }, nullptr);
+    jitter_.begin_thread();
+    fdr_.begin_thread();
+    audit_.begin(name_);
+    uint32_t empty_polls = 0;
     while (running_.load(std::memory_order_relaxed)) {
-        run_once();
+        jitter_.tick();
+        audit_.tick();
+        fdr_.tick();
+        perf_.begin();
+        const size_t n = batch_handler_ ? run_batch() : run_once();
+        perf_.end(n);
+        if (wait_mode_ == WaitMode::Yield) {
+            engine_yield();
+        } else if (n) {
+            empty_polls = 0;
+        } else {
+            idle(empty_polls);
+        }
+    }
+    audit_.end();
+    perf_.close();
+
+    struct timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+        exit_cpu_ns_ = (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// One empty poll under the configured wait mode
+void TradingEngine::idle(uint32_t& empty_polls) {
+    if (++empty_polls < wait_budget_ || wait_mode_ == WaitMode::Spin) {
+        cpu_pause();
+        return;
+    }
+    if (wait_mode_ == WaitMode::SpinYield) {
         engine_yield();
+        return;
+    }
+
+    // Block: announce, re-check so a push racing with the announcement is not
+    // missed, then sleep. The timeout only bounds how long stop() can take.
+    const uint32_t key = wakeup_->prepare();
+    if (!ring_->empty()) {
+        wakeup_->cancel();
+        return;
     }
+    ++wait_stats_.parks;
+    wakeup_->wait(key, 10 * 1000 * 1000);
+    jitter_.resume();
+    empty_polls = 0;
+}
+
+WaitStats TradingEngine::wait_stats() const {
+    WaitStats s = wait_stats_;
+    s.wakeups = wakeup_->wakeups();
+    return s;
+}
+
+uint64_t TradingEngine::cpu_ns() const {
+    if (!running_.load(std::memory_order_relaxed) || !worker_.joinable())
+        return exit_cpu_ns_;
+    clockid_t cid;
+    if (pthread_getcpuclockid(const_cast<std::thread&>(worker_).native_handle(), &cid))
+        return 0;
+    struct timespec ts;
+    if (clock_gettime(cid, &ts)) return 0;
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
 }
@@ -0,0 +1,344 @@
+#include "uring_rx.h"
+#include <linux/io_uring.h>
+#include <linux/time_types.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include "socket_rx.h"
+
+// Thin wrappers; we talk to io_uring directly rather than pulling in liburing
+static int sys_io_uring_setup(unsigned entries, io_uring_params* p) {
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete,
+    unsigned flags, const void* arg, size_t argsz) {
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg,
+        argsz);
+}
+
+static int sys_io_uring_register(int fd, unsigned op, const void* arg, unsigned nr) {
+    return (int)syscall(__NR_io_uring_register, fd, op, arg, nr);
+}
+
+template <typename T>
+static inline T load_acquire(const T* p) {
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+template <typename T>
+static inline void store_release(T* p, T v) {
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+static unsigned round_pow2(unsigned v) {
+    unsigned p = 1;
+    while (p < v && p < 32768) p <<= 1;
+    return p;
+}
+
+/**
+ * @brief Open the UDP socket, create the ring and register the buffer ring.
+ *
+ * The multishot request itself is armed lazily on the first rx_batch() so the
+ * constructor has no side effects on the socket beyond binding it.
+ *
+ * @param cfg BypassConfig with ifname "uring:[addr:]port"
+ */
+UringRx::UringRx(const BypassConfig& cfg)
+    : busy_poll_(cfg.busy_poll),
+      sqpoll_(cfg.uring_sqpoll),
+      timestamps_(cfg.sock_timestamps),
+      burst_(cfg.burst > 0 ? (unsigned)cfg.burst : 1),
+      nbufs_(round_pow2(cfg.uring_buffers > 0 ? (unsigned)cfg.uring_buffers : 1)) {
+    sock_ = open_udp_socket(cfg, timestamps_);
+    if (sock_ < 0) return;
+    port_ = udp_socket_port(sock_);
+
+    // The kernel lays each datagram out as recvmsg_out | name | control | payload;
+    // only the lengths of this template are used.
+    msg_.msg_namelen = 0;
+    msg_.msg_controllen = timestamps_ ? CMSG_SPACE(sizeof(timespec)) : 0;
+
+    if (!setup_ring(cfg) || !setup_buffers()) return;
+    ok_ = true;
+}
+
+UringRx::~UringRx() {
+    if (ring_fd_ >= 0) ::close(ring_fd_);
+    if (sock_ >= 0) ::close(sock_);
+    if (sqes_) munmap(sqes_, sqes_len_);
+    if (cq_map_ && cq_map_ != sq_map_) munmap(cq_map_, cq_map_len_);
+    if (sq_map_) munmap(sq_map_, sq_map_len_);
+    if (br_) munmap(br_, br_len_);
+    if (bufs_) munmap(bufs_, bufs_len_);
+}
+
+/**
+ * @brief io_uring_setup() + mmap of the SQ/CQ rings and the SQE array.
+ *
+ * The CQ is sized to the number of provided buffers: every data completion
+ * consumes one buffer, so the CQ cannot overflow while buffers are outstanding.
+ */
+bool UringRx::setup_ring(const BypassConfig& cfg) {
+    io_uring_params p{};
+    p.flags = IORING_SETUP_CQSIZE;
+    p.cq_entries = nbufs_;
+    if (sqpoll_) {
+        p.flags |= IORING_SETUP_SQPOLL;
+        p.sq_thread_idle = 2000;  // ms before the kernel thread sleeps
+        if (cfg.uring_sq_cpu >= 0) {
+            p.flags |= IORING_SETUP_SQ_AFF;
+            p.sq_thread_cpu = (unsigned)cfg.uring_sq_cpu;
+        }
+    }
+
+    // Only the multishot recv is ever submitted, so a tiny SQ is enough
+    ring_fd_ = sys_io_uring_setup(8, &p);
+    if (ring_fd_ < 0) {
+        std::perror("uring_rx: io_uring_setup");
+        return false;
+    }
+
+    sq_map_len_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cq_map_len_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    const bool single = p.features & IORING_FEAT_SINGLE_MMAP;
+    if (single) sq_map_len_ = cq_map_len_ = std::max(sq_map_len_, cq_map_len_);
+
+    sq_map_ = mmap(nullptr, sq_map_len_, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+    if (sq_map_ == MAP_FAILED) {
+        sq_map_ = nullptr;
+        std::perror("uring_rx: mmap sq");
+        return false;
+    }
+    if (single) {
+        cq_map_ = sq_map_;
+    } else {
+        cq_map_ = mmap(nullptr, cq_map_len_, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+        if (cq_map_ == MAP_FAILED) {
+            cq_map_ = nullptr;
+            std::perror("uring_rx: mmap cq");
+            return false;
+        }
+    }
+
+    sqes_len_ = p.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, sqes_len_, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        std::perror("uring_rx: mmap sqes");
+        return false;
+    }
+    sqes_ = (io_uring_sqe*)sqes;
+
+    auto* sq = (uint8_t*)sq_map_;
+    sq_head_ = (unsigned*)(sq + p.sq_off.head);
+    sq_tail_ = (unsigned*)(sq + p.sq_off.tail);
+    sq_mask_ = (unsigned*)(sq + p.sq_off.ring_mask);
+    sq_flags_ = (unsigned*)(sq + p.sq_off.flags);
+    sq_array_ = (unsigned*)(sq + p.sq_off.array);
+
+    auto* cq = (uint8_t*)cq_map_;
+    cq_head_ = (unsigned*)(cq + p.cq_off.head);
+    cq_tail_ = (unsigned*)(cq + p.cq_off.tail);
+    cq_mask_ = (unsigned*)(cq + p.cq_off.ring_mask);
+    cqes_ = (io_uring_cqe*)(cq + p.cq_off.cqes);
+    return true;
+}
+
+/**
+ * @brief Allocate the packet buffers and register them as a provided-buffer ring.
+ */
+bool UringRx::setup_buffers() {
+    br_len_ = nbufs_ * sizeof(io_uring_buf);
+    void* br = mmap(nullptr, br_len_, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (br == MAP_FAILED) {
+        std::perror("uring_rx: mmap buf ring");
+        return false;
+    }
+    br_ = (io_uring_buf_ring*)br;
+
+    bufs_len_ = nbufs_ * kBufSize;
+    void* bufs = mmap(nullptr, bufs_len_, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (bufs == MAP_FAILED) {
+        std::perror("uring_rx: mmap buffers");
+        return false;
+    }
+    bufs_ = (uint8_t*)bufs;
+
+    io_uring_buf_reg reg{};
+    reg.ring_addr = (uint64_t)(uintptr_t)br_;
+    reg.ring_entries = nbufs_;
+    reg.bgid = kBufGroup;
+    if (sys_io_uring_register(ring_fd_, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        std::perror("uring_rx: IORING_REGISTER_PBUF_RING (kernel >= 5.19)");
+        return false;
+    }
+
+    for (unsigned i = 0; i < nbufs_; ++i) recycle((uint16_t)i);
+    publish_recycled();
+    return true;
+}
+
+int UringRx::enter(unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return sys_io_uring_enter(ring_fd_, to_submit, min_complete, flags, nullptr, 0);
+}
+
+/**
+ * @brief Queue (not yet publish) a buffer for the kernel to reuse.
+ */
+void UringRx::recycle(uint16_t bid) {
+    // Index the ring as a plain array: the uapi flex-array member is offset by
+    // an empty struct when compiled as C++, so br_->bufs is not usable here.
+    io_uring_buf* b = reinterpret_cast<io_uring_buf*>(br_) + (br_tail_ & (nbufs_ - 1));
+    b->addr = (uint64_t)(uintptr_t)(bufs_ + (size_t)bid * kBufSize);
+    b->len = (uint32_t)kBufSize;
+    b->bid = bid;
+    ++br_tail_;
+}
+
+// One release store hands every buffer recycled since the last call back
+void UringRx::publish_recycled() {
+    store_release(&br_->tail, br_tail_);
+}
+
+/**
+ * @brief Submit the multishot RECVMSG. It stays armed until the kernel posts a
+ * CQE without IORING_CQE_F_MORE (e.g. -ENOBUFS when we fall behind).
+ */
+bool UringRx::arm() {
+    const unsigned tail = *sq_tail_;
+    const unsigned idx = tail & *sq_mask_;
+    io_uring_sqe* sqe = &sqes_[idx];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_RECVMSG;
+    sqe->fd = sock_;
+    sqe->addr = (uint64_t)(uintptr_t)&msg_;
+    sqe->len = 1;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = kBufGroup;
+    sq_array_[idx] = idx;
+    store_release(sq_tail_, tail + 1);
+
+    if (sqpoll_) {
+        // Full barrier between publishing the tail and reading NEED_WAKEUP
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (load_acquire(sq_flags_) & IORING_SQ_NEED_WAKEUP) {
+            enter(0, 0, IORING_ENTER_SQ_WAKEUP);
+        }
+    } else if (enter(1, 0, 0) < 0) {
+        std::perror("uring_rx: io_uring_enter");
+        return false;
+    }
+    armed_ = true;
+    return true;
+}
+
+unsigned UringRx::backlog() const {
+    if (!ok_) return 0;
+    return load_acquire(cq_tail_) - *cq_head_;
+}
+
+/**
+ * @brief Drain up to `burst` completions and invoke cb on each datagram.
+ *
+ * In busy-poll mode we only peek at the CQ (no syscall when it is empty); in
+ * blocking mode we wait in io_uring_enter() with the same 1s timeout as the
+ * other backends. Buffers are returned to the kernel after cb has run, in one
+ * publish per batch, and the multishot request is re-armed if it terminated.
+ *
+ * @param cb Callback applied to each datagram (payload-only PacketView)
+ * @param stats Counters to update (pkts, bytes, batches)
+ * @return Number of datagrams handed to cb, 0 if none, -1 on error.
+ */
+int UringRx::rx_batch(const std::function<bool(const PacketView&)>& cb, Stats& stats,
+    RxTelemetry& tel) {
+    if (!ok_) return -1;
+    if (!armed_ && !arm()) return -1;
+
+    unsigned head = *cq_head_;
+    unsigned tail = load_acquire(cq_tail_);
+    if (head == tail) {
+        if (busy_poll_) {
+            tel.record(0, 0, 0, burst_);
+            return 0;
+        }
+
+        __kernel_timespec ts{1, 0};
+        io_uring_getevents_arg arg{};
+        arg.ts = (uint64_t)(uintptr_t)&ts;
+        sys_io_uring_enter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+            &arg, sizeof(arg));
+        tail = load_acquire(cq_tail_);
+        if (head == tail) {
+            tel.record(0, 0, 0, burst_);
+            return 0;
+        }
+    }
+    const unsigned avail = tail - head;
+
+    int processed = 0;
+    int err = 0;
+    while (head != tail && processed < (int)burst_) {
+        const io_uring_cqe& cqe = cqes_[head & *cq_mask_];
+        ++head;
+        if (!(cqe.flags & IORING_CQE_F_MORE)) armed_ = false;
+
+        // -ENOBUFS just means the kernel ran out of buffers; data stays queued
+        // on the socket until we re-arm below.
+        if (cqe.res < 0) {
+            if (cqe.res != -ENOBUFS) err = cqe.res;
+            continue;
+        }
+        if (!(cqe.flags & IORING_CQE_F_BUFFER)) continue;
+
+        const uint16_t bid = (uint16_t)(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+        uint8_t* buf = bufs_ + (size_t)bid * kBufSize;
+        const auto* out = (const io_uring_recvmsg_out*)buf;
+        uint8_t* ctrl = buf + sizeof(*out) + msg_.msg_namelen;
+        const uint8_t* payload = ctrl + msg_.msg_controllen;
+        const uint32_t room = (uint32_t)cqe.res - (uint32_t)(payload - buf);
+        const uint32_t len = out->payloadlen < room ? out->payloadlen : room;
+
+        PacketView v{payload, (uint16_t)len, rdtsc()};
+        v.payload_only = true;
+        v.dport = port_;
+        if (timestamps_ && out->controllen) {
+            msghdr mh{};
+            mh.msg_control = ctrl;
+            mh.msg_controllen = out->controllen;
+            v.rx_ns = cmsg_rx_timestamp(mh);
+        }
+
+        ++processed;
+        ++stats.pkts;
+        stats.bytes += len;
+
+        const bool more = cb(v);
+        recycle(bid);
+        if (!more) break;
+    }
+
+    store_release(cq_head_, head);
+    if (processed) ++stats.batches;
+    tel.record(0, avail, avail - (tail - head), burst_);
+    publish_recycled();
+
+    if (err) {
+        std::fprintf(stderr, "uring_rx: recvmsg completion error: %s\n",
+            std::strerror(-err));
+        return -1;
+    }
+    if (!armed_ && !arm()) return -1;
+    return processed;
+}
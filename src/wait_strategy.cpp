@@ -0,0 +1,96 @@
+#include "wait_strategy.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "common.h"
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+const char* wait_mode_name(WaitMode m) {
+    switch (m) {
+        case WaitMode::Yield:
+            return "yield";
+        case WaitMode::Spin:
+            return "spin";
+        case WaitMode::SpinYield:
+            return "spinyield";
+        case WaitMode::Block:
+            return "block";
+    }
+    return "?";
+}
+
+bool parse_wait_mode(const char* s, WaitMode& mode, uint32_t& budget) {
+    const char* colon = std::strchr(s, ':');
+    const size_t len = colon ? (size_t)(colon - s) : std::strlen(s);
+    static const WaitMode kModes[] = {
+        WaitMode::Yield, WaitMode::Spin, WaitMode::SpinYield, WaitMode::Block};
+    for (WaitMode m : kModes) {
+        const char* name = wait_mode_name(m);
+        if (std::strlen(name) != len || std::strncmp(s, name, len) != 0) continue;
+        mode = m;
+        if (colon) budget = (uint32_t)std::strtoul(colon + 1, nullptr, 10);
+        return true;
+    }
+    return false;
+}
+
+bool ConsumerWakeup::wait(uint32_t key, uint64_t timeout_ns) {
+#ifdef __linux__
+    struct timespec ts;
+    ts.tv_sec = (time_t)(timeout_ns / 1000000000ull);
+    ts.tv_nsec = (long)(timeout_ns % 1000000000ull);
+    const int op = shared_ ? FUTEX_WAIT : FUTEX_WAIT_PRIVATE;
+    syscall(SYS_futex, &seq_, op, key, &ts, nullptr, 0);
+#else
+    (void)timeout_ns;
+#endif
+    // Timed out or spurious: withdraw so the producer stops signalling
+    parked_.store(0, std::memory_order_relaxed);
+    return seq_.load(std::memory_order_acquire) != key;
+}
+
+void ConsumerWakeup::wake() {
+    wakeups_.fetch_add(1, std::memory_order_relaxed);
+#ifdef __linux__
+    const int op = shared_ ? FUTEX_WAKE : FUTEX_WAKE_PRIVATE;
+    syscall(SYS_futex, &seq_, op, 1, nullptr, nullptr, 0);
+#endif
+}
+
+/**
+ * @brief Print one interval of engine wait behaviour.
+ *
+ * Pop latency is taken from the first tick of each non-empty drain: its RX
+ * TSC to the moment the engine popped it, so it includes decode and queueing
+ * as well as how long the engine took to notice. CPU is the engine thread's
+ * CPU time over wall time; 100% means it never gave its core away.
+ *
+ * @param mode    wait mode in use
+ * @param now     current counters
+ * @param prev    counters at the previous report (ignored when final)
+ * @param cpu_ns  engine thread CPU time in the interval
+ * @param wall_ns wall time of the interval
+ * @param final   print whole-run figures
+ */
+void print_wait(WaitMode mode, const WaitStats& now, const WaitStats& prev,
+    uint64_t cpu_ns, uint64_t wall_ns, bool final) {
+    static const WaitStats kZero{};
+    const WaitStats& base = final ? kZero : prev;
+    const Log2Histogram h = now.pop_latency.since(base.pop_latency);
+    const Log2Histogram d = now.decide_latency.since(base.decide_latency);
+
+    const double k = tsc_ns_per_tick();
+    std::printf("%swait[%s]: drains=%llu pop p50<=%.1fus p99<=%.1fus max=%.1fus "
+                "decide p50<=%.1fus p99<=%.1fus parks=%llu wakeups=%llu cpu=%.1f%%\n",
+        final ? "[final] " : "", wait_mode_name(mode), (unsigned long long)h.total,
+        (double)h.percentile(50) * k / 1e3, (double)h.percentile(99) * k / 1e3,
+        (double)h.max * k / 1e3, (double)d.percentile(50) * k / 1e3,
+        (double)d.percentile(99) * k / 1e3, (unsigned long long)(now.parks - base.parks),
+        (unsigned long long)(now.wakeups - base.wakeups),
+        wall_ns ? 100.0 * (double)cpu_ns / (double)wall_ns : 0.0);
+}
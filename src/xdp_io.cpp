@@ -0,0 +1,403 @@
+#include "xdp_io.h"
+#include <linux/bpf.h>
+#include <linux/if_link.h>
+#include <linux/if_xdp.h>
+#include <net/if.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#ifndef AF_XDP
+#define AF_XDP 44
+#endif
+#ifndef SOL_XDP
+#define SOL_XDP 283
+#endif
+
+template <typename T>
+static inline T load_acquire(const T* p) {
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+template <typename T>
+static inline void store_release(T* p, T v) {
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+static int sys_bpf(int cmd, bpf_attr* attr) {
+    return (int)syscall(__NR_bpf, cmd, attr, sizeof(*attr));
+}
+
+static uint32_t round_pow2(uint32_t v) {
+    uint32_t p = 64;
+    while (p < v && p < (1u << 16)) p <<= 1;
+    return p;
+}
+
+/**
+ * @brief Parse "xdp:<ifname>[@queue]".
+ *
+ * @param spec interface string as given to -i
+ * @param dev output device name
+ * @param queue output queue id (defaults to rx_ring_first, else 0)
+ */
+static void parse_xdp_ifname(const std::string& spec, int rx_ring_first,
+    std::string& dev, uint32_t& queue) {
+    dev = spec.substr(spec.find(':') + 1);
+    queue = rx_ring_first >= 0 ? (uint32_t)rx_ring_first : 0;
+    const auto at = dev.find('@');
+    if (at != std::string::npos) {
+        queue = (uint32_t)std::strtoul(dev.c_str() + at + 1, nullptr, 10);
+        dev.resize(at);
+    }
+}
+
+/**
+ * @brief Create the UMEM, rings and XDP program and bind to ifname@queue.
+ *
+ * Mode selection: unless xdp_generic is set we first try to attach the program
+ * in native (driver) mode and bind with XDP_ZEROCOPY; each step falls back
+ * (generic SKB mode, copy mode) if the driver does not support it. A veth pair
+ * therefore works out of the box in generic/copy mode.
+ *
+ * @param cfg BypassConfig with ifname "xdp:<dev>[@queue]"
+ */
+XdpIo::XdpIo(const BypassConfig& cfg)
+    : busy_poll_(cfg.busy_poll),
+      burst_(cfg.burst > 0 ? (unsigned)cfg.burst : 1),
+      prefetch_(cfg.prefetch > 0 ? (uint32_t)cfg.prefetch : 0),
+      nframes_(round_pow2(cfg.xdp_frames > 0 ? (uint32_t)cfg.xdp_frames : 1)),
+      ring_size_(nframes_ / 2) {
+    std::string dev;
+    parse_xdp_ifname(cfg.ifname, cfg.rx_ring_first, dev, queue_);
+    ifindex_ = (int)if_nametoindex(dev.c_str());
+    if (ifindex_ == 0) {
+        std::fprintf(stderr, "xdp_io: unknown interface '%s'\n", dev.c_str());
+        return;
+    }
+
+    xsk_ = ::socket(AF_XDP, SOCK_RAW, 0);
+    if (xsk_ < 0) {
+        std::perror("xdp_io: socket(AF_XDP)");
+        return;
+    }
+
+    if (!setup_umem() || !setup_rings() || !load_program(cfg) || !bind_socket(cfg))
+        return;
+
+    // Register our socket for this queue in the XSKMAP the program redirects to
+    bpf_attr attr{};
+    int key = (int)queue_;
+    attr.map_fd = (uint32_t)map_fd_;
+    attr.key = (uint64_t)(uintptr_t)&key;
+    attr.value = (uint64_t)(uintptr_t)&xsk_;
+    if (sys_bpf(BPF_MAP_UPDATE_ELEM, &attr) < 0) {
+        std::perror("xdp_io: BPF_MAP_UPDATE_ELEM");
+        return;
+    }
+
+    // First half of the UMEM feeds RX, second half is the TX free list
+    std::vector<uint64_t> fill(ring_size_);
+    for (uint32_t i = 0; i < ring_size_; ++i) fill[i] = (uint64_t)i * kFrameSize;
+    refill(fill.data(), ring_size_);
+    tx_free_.reserve(ring_size_);
+    for (uint32_t i = ring_size_; i < nframes_; ++i)
+        tx_free_.push_back((uint64_t)i * kFrameSize);
+    recycled_.reserve(burst_);
+
+    std::fprintf(stderr, "xdp_io: %s queue %u, %s XDP, %s\n", dev.c_str(), queue_,
+        native_ ? "native" : "generic", zerocopy_ ? "zero-copy" : "copy mode");
+    ok_ = true;
+}
+
+XdpIo::~XdpIo() {
+    // Closing the link detaches the program from the interface
+    if (link_fd_ >= 0) ::close(link_fd_);
+    if (xsk_ >= 0) ::close(xsk_);
+    if (prog_fd_ >= 0) ::close(prog_fd_);
+    if (map_fd_ >= 0) ::close(map_fd_);
+    for (Ring* r : {&rx_, &tx_, &fill_, &comp_}) {
+        if (r->map) munmap(r->map, r->map_len);
+    }
+    if (umem_) munmap(umem_, umem_len_);
+}
+
+bool XdpIo::setup_umem() {
+    umem_len_ = (size_t)nframes_ * kFrameSize;
+    void* mem = mmap(nullptr, umem_len_, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (mem == MAP_FAILED) {
+        std::perror("xdp_io: mmap umem");
+        return false;
+    }
+    umem_ = (uint8_t*)mem;
+
+    xdp_umem_reg reg{};
+    reg.addr = (uint64_t)(uintptr_t)umem_;
+    reg.len = umem_len_;
+    reg.chunk_size = kFrameSize;
+    reg.headroom = 0;
+    if (setsockopt(xsk_, SOL_XDP, XDP_UMEM_REG, &reg, sizeof(reg)) < 0) {
+        std::perror("xdp_io: XDP_UMEM_REG");
+        return false;
+    }
+    return true;
+}
+
+bool XdpIo::map_ring(Ring& r, uint64_t pgoff, size_t desc_size, uint32_t entries,
+    const void* off_ptr) {
+    const auto& off = *(const xdp_ring_offset*)off_ptr;
+    r.map_len = off.desc + entries * desc_size;
+    r.map = mmap(nullptr, r.map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+        xsk_, (off_t)pgoff);
+    if (r.map == MAP_FAILED) {
+        r.map = nullptr;
+        return false;
+    }
+    auto* base = (uint8_t*)r.map;
+    r.producer = (uint32_t*)(base + off.producer);
+    r.consumer = (uint32_t*)(base + off.consumer);
+    r.flags = (uint32_t*)(base + off.flags);
+    r.desc = base + off.desc;
+    r.mask = entries - 1;
+    return true;
+}
+
+bool XdpIo::setup_rings() {
+    const int n = (int)ring_size_;
+    if (setsockopt(xsk_, SOL_XDP, XDP_UMEM_FILL_RING, &n, sizeof(n)) < 0 ||
+        setsockopt(xsk_, SOL_XDP, XDP_UMEM_COMPLETION_RING, &n, sizeof(n)) < 0 ||
+        setsockopt(xsk_, SOL_XDP, XDP_RX_RING, &n, sizeof(n)) < 0 ||
+        setsockopt(xsk_, SOL_XDP, XDP_TX_RING, &n, sizeof(n)) < 0) {
+        std::perror("xdp_io: ring setsockopt");
+        return false;
+    }
+
+    xdp_mmap_offsets off{};
+    socklen_t optlen = sizeof(off);
+    if (getsockopt(xsk_, SOL_XDP, XDP_MMAP_OFFSETS, &off, &optlen) < 0) {
+        std::perror("xdp_io: XDP_MMAP_OFFSETS");
+        return false;
+    }
+
+    if (!map_ring(rx_, XDP_PGOFF_RX_RING, sizeof(xdp_desc), ring_size_, &off.rx) ||
+        !map_ring(tx_, XDP_PGOFF_TX_RING, sizeof(xdp_desc), ring_size_, &off.tx) ||
+        !map_ring(fill_, XDP_UMEM_PGOFF_FILL_RING, sizeof(uint64_t), ring_size_,
+            &off.fr) ||
+        !map_ring(comp_, XDP_UMEM_PGOFF_COMPLETION_RING, sizeof(uint64_t), ring_size_,
+            &off.cr)) {
+        std::perror("xdp_io: mmap ring");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Load the redirect program and attach it with a BPF link.
+ *
+ * The program is the minimal XSK redirect, hand-assembled so we need neither
+ * clang nor libbpf at build time:
+ *
+ *     return bpf_redirect_map(&xsks, ctx->rx_queue_index, XDP_PASS);
+ *
+ * Queues without a socket in the map fall back to XDP_PASS, so the rest of the
+ * interface's traffic still reaches the kernel stack.
+ */
+bool XdpIo::load_program(const BypassConfig& cfg) {
+    bpf_attr attr{};
+    attr.map_type = BPF_MAP_TYPE_XSKMAP;
+    attr.key_size = sizeof(int);
+    attr.value_size = sizeof(int);
+    attr.max_entries = 64;
+    map_fd_ = sys_bpf(BPF_MAP_CREATE, &attr);
+    if (map_fd_ < 0) {
+        std::perror("xdp_io: BPF_MAP_CREATE(XSKMAP)");
+        return false;
+    }
+
+    const bpf_insn insns[] = {
+        // r2 = ctx->rx_queue_index
+        {BPF_LDX | BPF_MEM | BPF_W, BPF_REG_2, BPF_REG_1,
+            (int16_t)offsetof(xdp_md, rx_queue_index), 0},
+        // r1 = &xsks (64-bit immediate, two slots)
+        {BPF_LD | BPF_IMM | BPF_DW, BPF_REG_1, BPF_PSEUDO_MAP_FD, 0, map_fd_},
+        {0, 0, 0, 0, 0},
+        // r3 = XDP_PASS (action when the queue has no socket)
+        {BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_3, 0, 0, XDP_PASS},
+        {BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_redirect_map},
+        {BPF_JMP | BPF_EXIT, 0, 0, 0, 0},
+    };
+    static const char license[] = "GPL";
+
+    std::memset(&attr, 0, sizeof(attr));
+    attr.prog_type = BPF_PROG_TYPE_XDP;
+    attr.insns = (uint64_t)(uintptr_t)insns;
+    attr.insn_cnt = sizeof(insns) / sizeof(insns[0]);
+    attr.license = (uint64_t)(uintptr_t)license;
+    attr.expected_attach_type = BPF_XDP;
+    prog_fd_ = sys_bpf(BPF_PROG_LOAD, &attr);
+    if (prog_fd_ < 0) {
+        std::perror("xdp_io: BPF_PROG_LOAD");
+        return false;
+    }
+
+    auto attach = [&](uint32_t flags) {
+        bpf_attr la{};
+        la.link_create.prog_fd = (uint32_t)prog_fd_;
+        la.link_create.target_ifindex = (uint32_t)ifindex_;
+        la.link_create.attach_type = BPF_XDP;
+        la.link_create.flags = flags;
+        return sys_bpf(BPF_LINK_CREATE, &la);
+    };
+
+    if (!cfg.xdp_generic) link_fd_ = attach(XDP_FLAGS_DRV_MODE);
+    if (link_fd_ < 0) {
+        native_ = false;
+        link_fd_ = attach(XDP_FLAGS_SKB_MODE);
+    } else {
+        native_ = true;
+    }
+    if (link_fd_ < 0) {
+        std::perror("xdp_io: BPF_LINK_CREATE(XDP)");
+        return false;
+    }
+    return true;
+}
+
+bool XdpIo::bind_socket(const BypassConfig& cfg) {
+    sockaddr_xdp sxdp{};
+    sxdp.sxdp_family = AF_XDP;
+    sxdp.sxdp_ifindex = (uint32_t)ifindex_;
+    sxdp.sxdp_queue_id = queue_;
+
+    // Zero-copy needs native mode and driver support; otherwise use copy mode
+    if (native_ && cfg.xdp_zerocopy) {
+        sxdp.sxdp_flags = XDP_ZEROCOPY | XDP_USE_NEED_WAKEUP;
+        if (::bind(xsk_, (const sockaddr*)&sxdp, sizeof(sxdp)) == 0) {
+            zerocopy_ = true;
+            return true;
+        }
+    }
+    sxdp.sxdp_flags = XDP_COPY | XDP_USE_NEED_WAKEUP;
+    if (::bind(xsk_, (const sockaddr*)&sxdp, sizeof(sxdp)) < 0) {
+        std::perror("xdp_io: bind");
+        return false;
+    }
+    return true;
+}
+
+// Hand frames back to the kernel via the fill ring (always has room: it holds
+// at most the RX half of the UMEM)
+void XdpIo::refill(const uint64_t* addrs, uint32_t n) {
+    if (n == 0) return;
+    const uint32_t prod = *fill_.producer;
+    auto* ring = (uint64_t*)fill_.desc;
+    for (uint32_t i = 0; i < n; ++i) ring[(prod + i) & fill_.mask] = addrs[i];
+    store_release(fill_.producer, prod + n);
+}
+
+// Move frames the kernel finished transmitting back to the TX free list
+void XdpIo::reclaim_tx() {
+    const uint32_t cons = *comp_.consumer;
+    const uint32_t prod = load_acquire(comp_.producer);
+    if (cons == prod) return;
+    const auto* ring = (const uint64_t*)comp_.desc;
+    for (uint32_t i = cons; i != prod; ++i) tx_free_.push_back(ring[i & comp_.mask]);
+    store_release(comp_.consumer, prod);
+}
+
+uint32_t XdpIo::backlog() const {
+    if (!ok_) return 0;
+    return load_acquire(rx_.producer) - *rx_.consumer;
+}
+
+/**
+ * @brief Drain up to `burst` RX descriptors and invoke cb on each frame.
+ *
+ * Busy-poll mode only peeks the RX ring; if the kernel asked for a wakeup on
+ * the fill ring (XDP_USE_NEED_WAKEUP) we kick it with a non-blocking recvfrom().
+ * Blocking mode waits on poll() with the same 1s timeout as the other backends.
+ * Frames go back to the fill ring after cb has run, in one publish per batch.
+ *
+ * @param cb Callback applied to each frame (full Ethernet frame, like netmap)
+ * @param stats Counters to update (pkts, bytes, batches)
+ * @return Number of frames handed to cb, 0 if none, -1 on error.
+ */
+int XdpIo::rx_batch(const std::function<bool(const PacketView&)>& cb, Stats& stats,
+    RxTelemetry& tel) {
+    if (!ok_) return -1;
+
+    if (busy_poll_) {
+        if (load_acquire(fill_.flags) & XDP_RING_NEED_WAKEUP)
+            recvfrom(xsk_, nullptr, 0, MSG_DONTWAIT, nullptr, nullptr);
+    } else {
+        pollfd pfd{xsk_, POLLIN, 0};
+        if (poll(&pfd, 1, 1000) <= 0) return 0;
+    }
+
+    const uint32_t cons = *rx_.consumer;
+    const uint32_t avail = load_acquire(rx_.producer) - cons;
+    const uint32_t take = avail < burst_ ? avail : burst_;
+    tel.record(0, avail, take, burst_);
+    if (avail == 0) return 0;
+
+    // Descriptors and UMEM frames prefetch_ packets ahead (see rx_pipeline())
+    const auto* ring = (const xdp_desc*)rx_.desc;
+    const uint32_t i = rx_pipeline(
+        take, prefetch_,
+        [&](uint32_t k) { prefetch_line(&ring[(cons + k) & rx_.mask]); },
+        [&](uint32_t k) {
+            const xdp_desc& d = ring[(cons + k) & rx_.mask];
+            prefetch_frame(umem_ + d.addr, d.len);
+        },
+        [&](uint32_t k) {
+            const xdp_desc& d = ring[(cons + k) & rx_.mask];
+            PacketView v{umem_ + d.addr, (uint16_t)d.len, rdtsc()};
+            ++stats.pkts;
+            stats.bytes += d.len;
+
+            const bool more = cb(v);
+            recycled_.push_back(d.addr & ~(uint64_t)(kFrameSize - 1));
+            return more;
+        });
+
+    store_release(rx_.consumer, cons + i);
+    refill(recycled_.data(), (uint32_t)recycled_.size());
+    recycled_.clear();
+    ++stats.batches;
+    return (int)i;
+}
+
+/**
+ * @brief Queue one frame on the TX ring and kick the kernel if it needs it.
+ *
+ * @return len on success, -1 if no TX frame/ring slot is free or len too large.
+ */
+int XdpIo::tx(const uint8_t* data, uint16_t len) {
+    if (!ok_ || len > kFrameSize) return -1;
+    reclaim_tx();
+    if (tx_free_.empty()) return -1;
+
+    const uint32_t prod = *tx_.producer;
+    if (prod - load_acquire(tx_.consumer) >= ring_size_) return -1;
+
+    const uint64_t addr = tx_free_.back();
+    tx_free_.pop_back();
+    std::memcpy(umem_ + addr, data, len);
+    auto* ring = (xdp_desc*)tx_.desc;
+    ring[prod & tx_.mask] = xdp_desc{addr, len, 0};
+    store_release(tx_.producer, prod + 1);
+
+    // Copy mode always needs the syscall; zero-copy only when flagged
+    if (!zerocopy_ || (load_acquire(tx_.flags) & XDP_RING_NEED_WAKEUP))
+        sendto(xsk_, nullptr, 0, MSG_DONTWAIT, nullptr, 0);
+    return len;
+}
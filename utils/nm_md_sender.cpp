@@ -1,12 +1,14 @@
+#ifdef USE_NETMAP
 #ifndef NETMAP_WITH_LIBS
 #define NETMAP_WITH_LIBS
 #endif
+#include <net/netmap_user.h>
+#endif
 
 #include <arpa/inet.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <getopt.h>
-#include <net/netmap_user.h>
 #include <netinet/if_ether.h>
 #include <netinet/ip.h>
 #include <netinet/udp.h>
@@ -15,6 +17,7 @@
 #include <string.h>
 #include <sys/ioctl.h>
 #include <sys/mman.h>
+#include <sys/socket.h>
 #include <unistd.h>
 
 #include <chrono>
@@ -24,17 +27,130 @@
 #include <thread>
 #include <vector>
 
+#include "inet_checksum.h"  // shared with the receiver's filter
+
 static volatile bool g_running = true;
 
-static uint16_t ip_checksum(const void* vdata, size_t length) {
-    const uint8_t* data = (const uint8_t*)vdata;
-    uint32_t sum = 0;
-    for (size_t i = 0; i + 1 < length; i += 2) {
-        sum += (uint16_t)data[i] << 8 | data[i + 1];
+// Random market data payload (14 bytes): <u32, u8, u8, f32, f32> little-endian
+struct PayloadGen {
+    std::mt19937 rng{(unsigned)time(nullptr) ^ (unsigned)getpid()};
+    std::uniform_int_distribution<uint32_t> instr_dist{1, 0xFFFFFF};
+    std::uniform_int_distribution<int> type_dist{0, 2};
+    std::uniform_int_distribution<int> side_dist{0, 1};
+    std::uniform_real_distribution<float> valf{1.0f, 100.0f};
+
+    void fill(uint8_t* payload) {
+        uint32_t instr = instr_dist(rng);
+        uint8_t itype = (uint8_t)type_dist(rng);
+        uint8_t side = (uint8_t)side_dist(rng);
+        float px = valf(rng);
+        float qty = valf(rng);
+
+        // write little-endian explicitly
+        payload[0] = (instr >> 0) & 0xFF;
+        payload[1] = (instr >> 8) & 0xFF;
+        payload[2] = (instr >> 16) & 0xFF;
+        payload[3] = (instr >> 24) & 0xFF;
+        payload[4] = itype;
+        payload[5] = side;
+        memcpy(payload + 6, &px, 4);
+        memcpy(payload + 10, &qty, 4);
+    }
+
+    // Packed datagram (-m): 8-byte header <u32 seq, u16 channel, u16 count>
+    // little-endian, then `count` 14-byte records. Matches PackedHeader in
+    // include/tick_decode.h (receiver: -d port=md14x).
+    void fill_packed(uint8_t* payload, uint32_t seq, uint16_t channel, uint16_t count) {
+        memcpy(payload, &seq, 4);
+        memcpy(payload + 4, &channel, 2);
+        memcpy(payload + 6, &count, 2);
+        for (uint16_t i = 0; i < count; i++) fill(payload + 8 + i * 14);
     }
-    if (length & 1) sum += (uint16_t)data[length - 1] << 8;
-    while (sum >> 16) sum = (sum & 0xffff) + (sum >> 16);
-    return ~sum;
+};
+
+// Payload bytes per datagram: one bare record, or a packed header + records
+static size_t payload_size(unsigned records) {
+    return records ? 8 + 14 * (size_t)records : 14;
+}
+
+// Packed datagram options (-m, -C, -L)
+struct PackedOpts {
+    unsigned records = 0;  // records per packed datagram (0 = plain 14-byte payload)
+    uint16_t channel = 0;  // PackedHeader channel
+    unsigned loss_pct = 0;  // drop this share of sequence numbers (gap testing)
+    uint32_t seq = 0;  // next sequence number
+};
+
+// Fill one datagram. With -L, some sequence numbers are skipped as if lost on
+// this line, so two instances emulate A/B lines with independent loss.
+static void fill_payload(PayloadGen& gen, uint8_t* payload, PackedOpts& po) {
+    if (!po.records) {
+        gen.fill(payload);
+        return;
+    }
+    while (po.loss_pct && gen.rng() % 100 < po.loss_pct) ++po.seq;
+    gen.fill_packed(payload, po.seq++, po.channel, (uint16_t)po.records);
+}
+
+// Kernel UDP path (-i udp:): same payloads sent with sendmmsg() so the socket
+// backend of the receiver can be exercised on loopback without netmap.
+static int run_udp_sender(in_addr dst_ip, uint16_t dst_port, uint64_t count,
+    uint64_t rate_pps, unsigned batch, PackedOpts& po, PayloadGen& gen) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        std::perror("socket");
+        return 2;
+    }
+
+    sockaddr_in dst{};
+    dst.sin_family = AF_INET;
+    dst.sin_port = htons(dst_port);
+    dst.sin_addr = dst_ip;
+    if (connect(fd, (const sockaddr*)&dst, sizeof(dst)) < 0) {
+        std::perror("connect");
+        close(fd);
+        return 2;
+    }
+
+    const size_t payload_len = payload_size(po.records);
+    std::vector<uint8_t> bufs(batch * payload_len);
+    std::vector<iovec> iov(batch);
+    std::vector<mmsghdr> msgs(batch);
+    for (unsigned i = 0; i < batch; i++) {
+        iov[i].iov_base = bufs.data() + i * payload_len;
+        iov[i].iov_len = payload_len;
+        memset(&msgs[i], 0, sizeof(mmsghdr));
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    uint64_t sent = 0;
+    auto interval =
+        std::chrono::microseconds(rate_pps ? (1000000ULL * batch / rate_pps) : 0);
+
+    while (g_running && (count == 0 || sent < count)) {
+        unsigned n = batch;
+        if (count && count - sent < n) n = (unsigned)(count - sent);
+        for (unsigned i = 0; i < n; i++)
+            fill_payload(gen, bufs.data() + i * payload_len, po);
+
+        int r = sendmmsg(fd, msgs.data(), n, 0);
+        if (r < 0) {
+            if (errno == ENOBUFS || errno == EAGAIN || errno == ECONNREFUSED) continue;
+            std::perror("sendmmsg");
+            break;
+        }
+
+        uint64_t before = sent;
+        sent += (uint64_t)r;
+        if (sent / 1000 != before / 1000) { std::cerr << "sent=" << sent << "\n"; }
+
+        if (interval.count() > 0) { std::this_thread::sleep_for(interval); }
+    }
+
+    std::cerr << "exiting, sent=" << sent << "\n";
+    close(fd);
+    return 0;
 }
 
 static bool parse_mac(const char* s, uint8_t mac[6]) {
@@ -55,9 +171,13 @@ int main(int argc, char** argv) {
     uint16_t dst_port = 5001;
     uint64_t count = 0;  // 0 means run forever
     uint64_t rate_pps = 1000;  // packets per second (approx)
+    unsigned batch = 32;  // sendmmsg vector length (udp: mode)
+    PackedOpts po;
+    uint32_t universe = 0xFFFFFF;  // instrument ids drawn from 1..universe
+    unsigned corrupt_pct = 0;  // netmap: share of frames corrupted after checksumming
 
     int opt;
-    while ((opt = getopt(argc, argv, "i:s:d:S:D:p:c:r:h")) != -1) {
+    while ((opt = getopt(argc, argv, "i:s:d:S:D:p:c:r:b:m:C:L:U:E:h")) != -1) {
         switch (opt) {
             case 'i':
                 ifname = optarg;
@@ -83,12 +203,41 @@ int main(int argc, char** argv) {
             case 'r':
                 rate_pps = strtoull(optarg, nullptr, 10);
                 break;
+            case 'b':
+                batch = (unsigned)atoi(optarg);
+                if (batch == 0) batch = 1;
+                break;
+            case 'm':
+                po.records = (unsigned)atoi(optarg);
+                if (po.records > 100) po.records = 100;  // keep datagrams under 1500 bytes
+                break;
+            case 'C':
+                po.channel = (uint16_t)atoi(optarg);
+                break;
+            case 'L':
+                po.loss_pct = (unsigned)atoi(optarg);
+                if (po.loss_pct > 99) po.loss_pct = 99;
+                break;
+            case 'U':
+                universe = (uint32_t)strtoul(optarg, nullptr, 10);
+                if (universe == 0) universe = 1;
+                break;
+            case 'E':
+                corrupt_pct = (unsigned)atoi(optarg);
+                if (corrupt_pct > 100) corrupt_pct = 100;
+                break;
             case 'h':
             default:
                 std::cerr << "Usage: " << argv[0]
-                          << " [-i netmap:iface] [-s src_mac] [-d dst_mac]\n"
+                          << " [-i netmap:iface|udp:] [-s src_mac] [-d dst_mac]\n"
                           << "  [-S src_ip] [-D dst_ip] [-p dst_port] [-c count] [-r "
-                             "rate_pps]\n";
+                             "rate_pps]\n"
+                          << "  [-b batch (udp: sendmmsg vector length)]\n"
+                          << "  [-m records (packed datagrams of N records)]\n"
+                          << "  [-C channel] [-L loss_pct (skip sequence numbers, -m only)]\n"
+                          << "  [-U instruments (distinct instr_ids, default 16M)]\n"
+                          << "  [-E corrupt_pct (netmap: flip a payload bit after "
+                             "checksumming)]\n";
                 return 1;
         }
     }
@@ -116,6 +265,16 @@ int main(int argc, char** argv) {
         return 1;
     }
 
+    PayloadGen gen;
+    gen.instr_dist = std::uniform_int_distribution<uint32_t>(1, universe);
+    if (ifname.rfind("udp:", 0) == 0) {
+        return run_udp_sender(dst_ip, dst_port, count, rate_pps, batch, po, gen);
+    }
+
+#ifndef USE_NETMAP
+    std::cerr << "built without netmap; only -i udp: is available\n";
+    return 1;
+#else
     struct nm_desc* nmd = nm_open(ifname.c_str(), NULL, 0, NULL);
     if (!nmd) {
         std::perror("nm_open");
@@ -136,7 +295,7 @@ int main(int argc, char** argv) {
         return 4;
     }
 
-    const size_t payload_len = 14;
+    const size_t payload_len = payload_size(po.records);
     const size_t eth_len = sizeof(ether_header);
     const size_t ip_len = sizeof(iphdr);
     const size_t udp_len = sizeof(udphdr);
@@ -147,11 +306,18 @@ int main(int argc, char** argv) {
         return 5;
     }
 
-    std::mt19937 rng((unsigned)time(nullptr));
-    std::uniform_int_distribution<uint32_t> instr_dist(1, 0xFFFFFF);
-    std::uniform_int_distribution<int> type_dist(0, 2);
-    std::uniform_int_distribution<int> side_dist(0, 1);
-    std::uniform_real_distribution<float> valf(1.0f, 100.0f);
+    // The pseudo-header and UDP header never change, so their sum is taken
+    // once; each frame then only adds its payload (csum_partial(), the SIMD
+    // kernel the receiver's --verify-csum runs)
+    iphdr ip_t{};
+    ip_t.saddr = src_ip.s_addr;
+    ip_t.daddr = dst_ip.s_addr;
+    udphdr udp_t{};
+    udp_t.source = htons(12345);
+    udp_t.dest = htons(dst_port);
+    udp_t.len = htons(udp_len + payload_len);
+    const uint32_t udp_seed = csum_partial(&udp_t, sizeof(udp_t),
+        udp_pseudo_sum((const uint8_t*)&ip_t, (const uint8_t*)&udp_t.len));
 
     uint64_t sent = 0;
     auto interval = std::chrono::microseconds(rate_pps ? (1000000ULL / rate_pps) : 0);
@@ -188,32 +354,20 @@ int main(int argc, char** argv) {
         iph->saddr = src_ip.s_addr;
         iph->daddr = dst_ip.s_addr;
         iph->check = 0;
-        iph->check = ip_checksum(iph, ip_len);
+        iph->check = csum_finish(csum_partial(iph, ip_len, 0));
 
         // UDP header
         udphdr* udph = (udphdr*)(buf + eth_len + ip_len);
         udph->source = htons(12345);
         udph->dest = htons(dst_port);
         udph->len = htons(udp_len + payload_len);
-        udph->check = 0;  // optional/zero per requirements
 
-        // Payload (14 bytes): <u32, u8, u8, f32, f32> little-endian
+        // Payload: one <u32, u8, u8, f32, f32> little-endian record, or -m packed
         uint8_t* payload = (uint8_t*)(buf + eth_len + ip_len + udp_len);
-        uint32_t instr = instr_dist(rng);
-        uint8_t itype = (uint8_t)type_dist(rng);
-        uint8_t side = (uint8_t)side_dist(rng);
-        float px = valf(rng);
-        float qty = valf(rng);
-
-        // write little-endian explicitly
-        payload[0] = (instr >> 0) & 0xFF;
-        payload[1] = (instr >> 8) & 0xFF;
-        payload[2] = (instr >> 16) & 0xFF;
-        payload[3] = (instr >> 24) & 0xFF;
-        payload[4] = itype;
-        payload[5] = side;
-        memcpy(payload + 6, &px, 4);
-        memcpy(payload + 10, &qty, 4);
+        fill_payload(gen, payload, po);
+        udph->check = udp_csum_finish(csum_partial(payload, payload_len, udp_seed));
+        // -E: a bit flipped in flight, which no valid checksum can hide
+        if (corrupt_pct && gen.rng() % 100 < corrupt_pct) payload[0] ^= 0x01;
 
         // slot length & advance ring
         slot->len = pkt_len;
@@ -232,4 +386,5 @@ int main(int argc, char** argv) {
     std::cerr << "exiting, sent=" << sent << "\n";
     nm_close(nmd);
     return 0;
+#endif
 }